@@ -0,0 +1,301 @@
+//
+// Benchmark for the clustering split stage of the compiler.
+// It builds a synthetic grid mesh (5M triangles by default) and runs the recursive
+// bounds/split of RecurseClusterSplit in two ways:
+//      * AoS - The original path, gathers every vertex through the indices at every level
+//              and copies the triangle ids into new vectors for each side of the split.
+//      * SoA - The precomputed triangle centroid/bounds table and the ping-pong partition
+//              used by the compiler (SoA streams with AVX2, one record per triangle without).
+// Both must produce the same clusters (same triangle order), which is verified at the end.
+//
+// Usage: xskeleton_clustering_benchmark [TriangleCount] [Iterations]
+//
+#include "../compiler/xskeleton_compiler_tri_soa.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+    namespace tri_soa = xgeom_static_compiler::tri_soa;
+
+    // Same footprint as the compiler vertex (position, 4 UVs, color, normal, tangent, binormal)
+    struct vertex
+    {
+        float           m_Position[3];
+        float           m_UVs[4][2];
+        std::uint32_t   m_Color;
+        float           m_Normal[3];
+        float           m_Tangent[3];
+        float           m_Binormal[3];
+    };
+
+    struct mesh
+    {
+        std::vector<vertex>         m_Vertex;
+        std::vector<std::uint32_t>  m_Indices;
+    };
+
+    struct result
+    {
+        std::uint32_t   m_nClusters = 0;
+        std::uint64_t   m_Hash      = 1469598103934665603ull;
+
+        void Add(std::uint32_t TriID) noexcept
+        {
+            m_Hash = (m_Hash ^ TriID) * 1099511628211ull;
+        }
+    };
+
+    constexpr float         max_extent_v        = 0.001f * 65535.0f;    // Same precision the compiler uses
+    constexpr std::uint32_t max_cluster_tris_v  = 65534 / 3;            // Stand in for the unique vertex count test
+
+    //--------------------------------------------------------------------------------------
+
+    mesh BuildGrid(std::size_t TriangleCount)
+    {
+        const auto  Side = static_cast<std::uint32_t>(std::ceil(std::sqrt(TriangleCount / 2.0)));
+        mesh        Mesh;
+
+        Mesh.m_Vertex.resize(std::size_t(Side + 1) * (Side + 1));
+        for (std::uint32_t y = 0; y <= Side; ++y)
+        {
+            for (std::uint32_t x = 0; x <= Side; ++x)
+            {
+                auto& V = Mesh.m_Vertex[std::size_t(y) * (Side + 1) + x];
+                V = {};
+                V.m_Position[0] = x * 0.25f;
+                V.m_Position[1] = std::sin(x * 0.01f) * std::cos(y * 0.01f) * 10.0f;
+                V.m_Position[2] = y * 0.25f;
+                V.m_UVs[0][0]   = x / float(Side);
+                V.m_UVs[0][1]   = y / float(Side);
+            }
+        }
+
+        Mesh.m_Indices.reserve(std::size_t(Side) * Side * 6);
+        for (std::uint32_t y = 0; y < Side; ++y)
+        {
+            for (std::uint32_t x = 0; x < Side; ++x)
+            {
+                const std::uint32_t i = y * (Side + 1) + x;
+                Mesh.m_Indices.insert(Mesh.m_Indices.end(), { i, i + 1, i + Side + 1, i + 1, i + Side + 2, i + Side + 1 });
+            }
+        }
+        return Mesh;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    bool IsLeaf(const std::array<float, 5>& Extent, std::uint32_t nTris) noexcept
+    {
+        const float max_e_pos = std::max({ Extent[0], Extent[1], Extent[2] });
+        const float max_e_uv  = std::max(Extent[3], Extent[4]);
+        return max_e_pos <= max_extent_v && max_e_uv <= max_extent_v && nTris <= max_cluster_tris_v;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    int ChooseAxis(const std::array<float, 5>& Extent) noexcept
+    {
+        int axis = 0;
+        for (int i = 1; i < 5; ++i) if (Extent[i] > Extent[axis]) axis = i;
+        return axis;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Reference: the original AoS gather path
+    //--------------------------------------------------------------------------------------
+
+    void AoSSplit(const mesh& Mesh, const std::vector<std::uint32_t>& TriIds, result& Result)
+    {
+        if (TriIds.empty()) return;
+
+        std::array<float, 5> Min, Max;
+        Min.fill(std::numeric_limits<float>::max());
+        Max.fill(std::numeric_limits<float>::lowest());
+
+        for (auto ti : TriIds)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                const auto& V = Mesh.m_Vertex[Mesh.m_Indices[ti * 3 + j]];
+                for (int a = 0; a < 3; ++a) { Min[a] = std::min(Min[a], V.m_Position[a]); Max[a] = std::max(Max[a], V.m_Position[a]); }
+                for (int a = 0; a < 2; ++a) { Min[3 + a] = std::min(Min[3 + a], V.m_UVs[0][a]); Max[3 + a] = std::max(Max[3 + a], V.m_UVs[0][a]); }
+            }
+        }
+
+        std::array<float, 5> Extent;
+        for (int a = 0; a < 5; ++a) Extent[a] = Max[a] - Min[a];
+
+        if (IsLeaf(Extent, static_cast<std::uint32_t>(TriIds.size())))
+        {
+            Result.m_nClusters++;
+            for (auto ti : TriIds) Result.Add(ti);
+            return;
+        }
+
+        const int   Axis  = ChooseAxis(Extent);
+        const float Split = (Min[Axis] + Max[Axis]) * 0.5f;
+
+        std::vector<std::uint32_t> C1, C2;
+        for (auto ti : TriIds)
+        {
+            const auto& V0 = Mesh.m_Vertex[Mesh.m_Indices[ti * 3 + 0]];
+            const auto& V1 = Mesh.m_Vertex[Mesh.m_Indices[ti * 3 + 1]];
+            const auto& V2 = Mesh.m_Vertex[Mesh.m_Indices[ti * 3 + 2]];
+            const float Cent = Axis < 3
+                ? (V0.m_Position[Axis] + V1.m_Position[Axis] + V2.m_Position[Axis]) / 3.0f
+                : (V0.m_UVs[0][Axis - 3] + V1.m_UVs[0][Axis - 3] + V2.m_UVs[0][Axis - 3]) / 3.0f;
+
+            if (Cent < Split) C1.push_back(ti);
+            else              C2.push_back(ti);
+        }
+
+        if (C1.empty() || C2.empty())
+        {
+            // Same guard as the compiler, halve the range
+            auto& All = C1.empty() ? C2 : C1;
+            C1.assign(All.begin(), All.begin() + All.size() / 2);
+            C2.assign(All.begin() + All.size() / 2, All.end());
+        }
+
+        AoSSplit(Mesh, C1, Result);
+        AoSSplit(Mesh, C2, Result);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // SoA path
+    //--------------------------------------------------------------------------------------
+
+    void BuildSoA(const mesh& Mesh, tri_soa::triangles& Tris)
+    {
+        const auto nTris = static_cast<std::uint32_t>(Mesh.m_Indices.size() / 3);
+        Tris.resize(nTris);
+        for (std::uint32_t i = 0; i < nTris; ++i)
+        {
+            const auto& V0 = Mesh.m_Vertex[Mesh.m_Indices[i * 3 + 0]];
+            const auto& V1 = Mesh.m_Vertex[Mesh.m_Indices[i * 3 + 1]];
+            const auto& V2 = Mesh.m_Vertex[Mesh.m_Indices[i * 3 + 2]];
+
+            std::array<float, 5> Centroid, Min, Max;
+            for (int a = 0; a < 3; ++a)
+            {
+                Centroid[a] = (V0.m_Position[a] + V1.m_Position[a] + V2.m_Position[a]) / 3.0f;
+                Min[a]      = std::min({ V0.m_Position[a], V1.m_Position[a], V2.m_Position[a] });
+                Max[a]      = std::max({ V0.m_Position[a], V1.m_Position[a], V2.m_Position[a] });
+            }
+            for (int a = 0; a < 2; ++a)
+            {
+                Centroid[3 + a] = (V0.m_UVs[0][a] + V1.m_UVs[0][a] + V2.m_UVs[0][a]) / 3.0f;
+                Min[3 + a]      = std::min({ V0.m_UVs[0][a], V1.m_UVs[0][a], V2.m_UVs[0][a] });
+                Max[3 + a]      = std::max({ V0.m_UVs[0][a], V1.m_UVs[0][a], V2.m_UVs[0][a] });
+            }
+            Tris.Set(i, Centroid, Min, Max);
+        }
+    }
+
+    void SoASplit(tri_soa::triangles& Tris, int iBuffer, std::uint32_t Begin, std::uint32_t End, const tri_soa::bounds& Bounds, result& Result)
+    {
+        if (Begin == End) return;
+
+        std::array<float, 5> Extent;
+        for (int a = 0; a < 5; ++a) Extent[a] = Bounds.m_Max[a] - Bounds.m_Min[a];
+
+        if (IsLeaf(Extent, End - Begin))
+        {
+            Result.m_nClusters++;
+            for (auto t = Begin; t < End; ++t) Result.Add(Tris.m_Buffer[iBuffer].m_Id[t]);
+            return;
+        }
+
+        const int       Axis   = ChooseAxis(Extent);
+        const float     Split  = (Bounds.m_Min[Axis] + Bounds.m_Max[Axis]) * 0.5f;
+        tri_soa::bounds Left, Right;
+        const auto      nLeft  = tri_soa::Partition(Tris, iBuffer, Begin, End, Axis, Split, Left, Right);
+        std::uint32_t   Middle = Begin + nLeft;
+
+        if (nLeft == 0 || nLeft == End - Begin)
+        {
+            Middle = Begin + (End - Begin) / 2;
+            Left   = tri_soa::ComputeBounds(Tris, 1 - iBuffer, Begin, Middle);
+            Right  = tri_soa::ComputeBounds(Tris, 1 - iBuffer, Middle, End);
+        }
+
+        SoASplit(Tris, 1 - iBuffer, Begin, Middle, Left, Result);
+        SoASplit(Tris, 1 - iBuffer, Middle, End, Right, Result);
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    template< typename T_FUNCTION >
+    double BestOf(int Iterations, T_FUNCTION&& Function)
+    {
+        double Best = std::numeric_limits<double>::max();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            Function();
+            const auto Stop  = std::chrono::steady_clock::now();
+            Best = std::min(Best, std::chrono::duration<double, std::milli>(Stop - Start).count());
+        }
+        return Best;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const std::size_t   TriangleCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5'000'000;
+    const int           Iterations    = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    const char* pISA =
+#if defined(__AVX2__)
+        "AVX2";
+#elif defined(XSKELETON_TRI_SOA_SSE2)
+        "SSE2";
+#else
+        "Scalar";
+#endif
+
+    printf("Building grid with ~%zu triangles...\n", TriangleCount);
+    const auto Mesh  = BuildGrid(TriangleCount);
+    const auto nTris = static_cast<std::uint32_t>(Mesh.m_Indices.size() / 3);
+    printf("Mesh: %u triangles, %zu vertices, kernels: %s\n", nTris, Mesh.m_Vertex.size(), pISA);
+
+    result AoSResult, SoAResult;
+
+    const double AoSTime = BestOf(Iterations, [&]
+    {
+        std::vector<std::uint32_t> TriIds(nTris);
+        for (std::uint32_t i = 0; i < nTris; ++i) TriIds[i] = i;
+        AoSResult = {};
+        AoSSplit(Mesh, TriIds, AoSResult);
+    });
+
+    tri_soa::triangles Tris;
+    double PrepassTime = 0;
+    const double SoATime = BestOf(Iterations, [&]
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        BuildSoA(Mesh, Tris);
+        PrepassTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+        SoAResult = {};
+        SoASplit(Tris, 0, 0, nTris, tri_soa::ComputeBounds(Tris, 0, 0, nTris), SoAResult);
+    });
+
+    printf("AoS gather split    : %10.2f ms (%u clusters)\n", AoSTime, AoSResult.m_nClusters);
+    printf("SoA + %-6s split   : %10.2f ms (%u clusters, pre-pass %.2f ms)\n", pISA, SoATime, SoAResult.m_nClusters, PrepassTime);
+    printf("Speedup             : %10.2fx\n", AoSTime / SoATime);
+
+    if (AoSResult.m_nClusters != SoAResult.m_nClusters || AoSResult.m_Hash != SoAResult.m_Hash)
+    {
+        printf("ERROR: The SoA path produced different clusters than the AoS path\n");
+        return 1;
+    }
+
+    return 0;
+}
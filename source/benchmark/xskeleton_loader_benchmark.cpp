@@ -0,0 +1,302 @@
+//
+// Benchmark for the geom load path without a GPU.
+// It writes N synthetic compiled geoms into a temporary resource folder and loads all of them
+// through xresource::mgr, with the loader built against the headless device (see
+// xskeleton_headless_device.h) so the buffers are created in host memory. Reports:
+//      * Loads per second and file bytes per second (best iteration)
+//      * The latency of a load (median, 99th percentile and max of every load)
+//      * The average time of every phase of a load (read, decode, buffers, materials)
+//      * The device submissions per load and the CPU cost of the uploads per MB
+// Every iteration releases all the geoms and checks that the device has no buffers left.
+//
+// Usage: xskeleton_loader_benchmark [GeomCount] [VerticesPerGeom] [Iterations] [blob|serializer] [raw|meshopt|meshopt-all] [sync|async]
+//
+// meshopt encodes the indices, meshopt-all the vertices and the vertex extras as well.
+// sync loads the geoms one by one with xresource::mgr, async requests all of them from
+// xgeom_static::xgpu::async_loader so a single Update stages and submits their buffers together.
+//
+#include "../xskeleton_headless_device.h"
+#include "../xskeleton_xgpu_rsc_loader.h"
+#include "../xskeleton_blob.h"
+#include "../xskeleton_index_codec.h"
+#include "../xskeleton_vertex_codec.h"
+#include "../compiler/xskeleton_compiler_mesh_lookup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using geom   = xgeom_static::geom;
+    using loader = xresource::loader< xrsc::geom_static_type_guid_v >;
+
+    //--------------------------------------------------------------------------------------
+    // One mesh with one LOD and a single submesh, the data is what matters for the load. The
+    // triangles are split in clusters of 128 like the meshlets of the compiler.
+    //--------------------------------------------------------------------------------------
+    void BuildGeom(geom& Geom, std::uint32_t nVertices, std::uint32_t Seed, bool bEncodeIndices, bool bEncodeVertices)
+    {
+        constexpr std::size_t   align_v             = 64;
+        constexpr std::uint32_t cluster_indices_v   = 128 * 3;
+        const std::uint32_t     nIndices            = (nVertices - 2) * 3;
+        const std::uint32_t     nClusters           = (nIndices + cluster_indices_v - 1) / cluster_indices_v;
+        auto                    Align               = [](std::size_t X) { return (X + align_v - 1) & ~(align_v - 1); };
+
+        // A strip like triangle list so the indices look like the ones of a real mesh
+        std::vector<std::uint16_t> Indices(nIndices);
+        for (std::uint32_t t = 0; t < nIndices / 3; ++t)
+        {
+            Indices[t * 3 + 0] = static_cast<std::uint16_t>(t);
+            Indices[t * 3 + 1] = static_cast<std::uint16_t>(t + 1 + (t & 1));
+            Indices[t * 3 + 2] = static_cast<std::uint16_t>(t + 2 - (t & 1));
+        }
+
+        std::vector<geom::cluster> Clusters(nClusters);
+        for (std::uint32_t c = 0; c < nClusters; ++c)
+        {
+            Clusters[c]             = {};
+            Clusters[c].m_iIndex    = c * cluster_indices_v;
+            Clusters[c].m_nIndices  = std::min(cluster_indices_v, nIndices - c * cluster_indices_v);
+            Clusters[c].m_nVertices = nVertices;
+        }
+
+        std::vector<geom::vertex> Vertices(nVertices);
+        for (std::uint32_t i = 0; i < nVertices; ++i)
+            Vertices[i] = { static_cast<std::int16_t>(i * 7 + Seed), static_cast<std::int16_t>(i * 13), static_cast<std::int16_t>(i * 31), 0 };
+
+        std::vector<geom::vertex_extras> Extras(nVertices);
+        for (std::uint32_t i = 0; i < nVertices; ++i)
+            Extras[i] = { { static_cast<std::uint16_t>(i), static_cast<std::uint16_t>(i ^ Seed) }, { 128, 255 }, { 255, 128 } };
+
+        std::vector<std::byte> Encoded;
+        std::vector<std::byte> EncodedVertices;
+        std::vector<std::byte> EncodedExtras;
+        if (bEncodeIndices)  Encoded         = xgeom_static::index_codec::Encode(std::span<const geom::cluster>(Clusters), std::span<const std::uint16_t>(Indices));
+        if (bEncodeVertices) EncodedVertices = xgeom_static::vertex_codec::Encode(std::span<const geom::vertex>(Vertices));
+        if (bEncodeVertices) EncodedExtras   = xgeom_static::vertex_codec::Encode(std::span<const geom::vertex_extras>(Extras));
+
+        const std::size_t       VertexSize          = bEncodeVertices ? EncodedVertices.size() : nVertices * sizeof(geom::vertex);
+        const std::size_t       ExtrasSize          = bEncodeVertices ? EncodedExtras.size()   : nVertices * sizeof(geom::vertex_extras);
+        const std::size_t       VertexOffset        = 0;
+        const std::size_t       VertexExtrasOffset  = Align(VertexOffset       + VertexSize);
+        const std::size_t       IndicesOffset       = Align(VertexExtrasOffset + ExtrasSize);
+        const std::size_t       IndicesSize         = bEncodeIndices ? Encoded.size() : nIndices * sizeof(std::uint16_t);
+        const std::size_t       DataSize            = Align(IndicesOffset      + IndicesSize);
+
+        geom::mesh      Mesh    {};
+        geom::lod       LOD     {};
+        geom::submesh   SubMesh {};
+        std::snprintf(Mesh.m_Name.data(), Mesh.m_Name.size(), "Geom_%u", Seed);
+        Mesh.m_nLODs        = 1;
+        LOD.m_nSubmesh      = 1;
+        LOD.m_nVertices     = nVertices;
+        LOD.m_nIndices      = nIndices;
+        SubMesh.m_nCluster  = nClusters;
+
+        const auto Lookup = xgeom_static_compiler::mesh_lookup::Build({ &Mesh, 1 }, { &LOD, 1 }, { &SubMesh, 1 }, 0);
+
+        xgeom_static::blob::AllocateArena(Geom, 1, 1, 1, nClusters, 0, static_cast<std::uint32_t>(Lookup.m_Lookup.size()), 0, 0, DataSize);
+        Geom.m_pMesh[0]             = Mesh;
+        Geom.m_pLOD[0]              = LOD;
+        Geom.m_pSubMesh[0]          = SubMesh;
+        std::ranges::copy(Clusters, Geom.m_pCluster);
+        std::ranges::copy(Lookup.m_Lookup, Geom.m_pLookup);
+        Geom.m_nMeshHashBuckets     = Lookup.m_nBuckets;
+        Geom.m_nMeshHashSlots       = Lookup.m_nSlots;
+        Geom.m_VertexOffset         = VertexOffset;
+        Geom.m_VertexExtrasOffset   = VertexExtrasOffset;
+        Geom.m_IndicesOffset        = IndicesOffset;
+        Geom.m_VertexSkinOffset     = DataSize;
+        Geom.m_nVertices            = nVertices;
+        Geom.m_nIndices             = nIndices;
+        Geom.m_IndexEncoding        = bEncodeIndices  ? geom::index_encoding::MESHOPT  : geom::index_encoding::RAW;
+        Geom.m_VertexEncoding       = bEncodeVertices ? geom::vertex_encoding::MESHOPT : geom::vertex_encoding::RAW;
+        Geom.m_VertexExtrasEncoding = Geom.m_VertexEncoding;
+        Geom.m_BBox.m_Min           = xmath::fvec3(-1.0f, -1.0f, -1.0f);
+        Geom.m_BBox.m_Max           = xmath::fvec3( 1.0f,  1.0f,  1.0f);
+
+        std::memcpy(Geom.m_pData + VertexOffset,       bEncodeVertices ? static_cast<const void*>(EncodedVertices.data()) : Vertices.data(), VertexSize);
+        std::memcpy(Geom.m_pData + VertexExtrasOffset, bEncodeVertices ? static_cast<const void*>(EncodedExtras.data())   : Extras.data(),   ExtrasSize);
+
+        if (bEncodeIndices) std::memcpy(Geom.m_pData + IndicesOffset, Encoded.data(), IndicesSize);
+        else                std::ranges::copy(Indices, Geom.getIndices().data());
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    std::size_t WriteGeom(const geom& Geom, const std::wstring& Path, bool bFlatBlob)
+    {
+        std::error_code Error;
+        std::filesystem::create_directories(std::filesystem::path(Path).parent_path(), Error);
+
+        if (bFlatBlob)
+        {
+            std::vector<std::byte> Blob;
+            xgeom_static::blob::Write(Geom, Blob);
+
+            std::ofstream File(std::filesystem::path(Path), std::ios::binary | std::ios::trunc);
+            File.write(reinterpret_cast<const char*>(Blob.data()), static_cast<std::streamsize>(Blob.size()));
+            if (!File) return 0;
+        }
+        else
+        {
+            xserializer::stream Stream;
+            if (auto Err = Stream.Save(Path, Geom, xserializer::compression_level::FAST); Err)
+                return 0;
+        }
+
+        return static_cast<std::size_t>(std::filesystem::file_size(Path, Error));
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    double Percentile(std::vector<double>& Values, double P)
+    {
+        if (Values.empty()) return 0;
+        const auto i = static_cast<std::size_t>(P * (Values.size() - 1));
+        std::nth_element(Values.begin(), Values.begin() + i, Values.end());
+        return Values[i];
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const std::uint32_t GeomCount       = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    const std::uint32_t VerticesPerGeom = std::clamp<std::uint32_t>(argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 50'000, 3, 0xfffe);
+    const int           Iterations      = argc > 3 ? std::atoi(argv[3]) : 5;
+    const bool          bFlatBlob       = argc > 4 ? std::string_view(argv[4]) != "serializer" : true;
+    const bool          bEncodeIndices  = argc > 5 ? std::string_view(argv[5]).starts_with("meshopt") : false;
+    const bool          bEncodeVertices = argc > 5 ? std::string_view(argv[5]) == "meshopt-all" : false;
+    const bool          bAsync          = argc > 6 ? std::string_view(argv[6]) == "async" : false;
+    const auto          RootPath        = std::filesystem::temp_directory_path() / "xskeleton_loader_benchmark";
+
+    resource_mgr_user_data  UserData;
+    xresource::mgr          Mgr;
+    Mgr.Initiallize();
+    Mgr.setRootPath(RootPath.wstring());
+    Mgr.setUserData(&UserData, false);
+
+    //
+    // Write the resources where the manager expects them
+    //
+    std::vector<xresource::full_guid>   GUIDs(GeomCount);
+    std::size_t                         FileBytes = 0;
+    for (std::uint32_t i = 0; i < GeomCount; ++i)
+    {
+        GUIDs[i] = xresource::full_guid{ .m_Instance = { .m_Value = 0x5EED000000000001ull + (std::uint64_t(i) << 1) }, .m_Type = xrsc::geom_static_type_guid_v };
+
+        geom Geom;
+        Geom.Initialize();
+        BuildGeom(Geom, VerticesPerGeom, i, bEncodeIndices, bEncodeVertices);
+
+        const auto Size = WriteGeom(Geom, Mgr.getResourcePath(GUIDs[i], loader::type_name_v), bFlatBlob);
+        Geom.Kill();
+
+        if (Size == 0)
+        {
+            printf("ERROR: Failed to write geom %u\n", i);
+            return 1;
+        }
+        FileBytes += Size;
+    }
+
+    printf("Geoms: %u x %u vertices, %s, %s indices, %s vertices, %s loads, %.2f MB on disk\n", GeomCount, VerticesPerGeom, bFlatBlob ? "flat blob" : "serializer", bEncodeIndices ? "meshopt" : "raw", bEncodeVertices ? "meshopt" : "raw", bAsync ? "async" : "sync", FileBytes / (1024.0 * 1024.0));
+
+    //
+    // Load and release everything a few times
+    //
+    auto&                                   Stats    = xgeom_static::xgpu::getLoadStats();
+    std::vector<double>                     Latency;
+    std::vector<xrsc::geom_static>          Refs(GeomCount);
+    std::vector<xgeom_static::xgpu::geom*>  AsyncGeoms(GeomCount);
+    xgeom_static::xgpu::async_loader        AsyncLoader(Mgr);
+    double                                  BestMS   = std::numeric_limits<double>::max();
+    Latency.reserve(std::size_t(GeomCount) * Iterations);
+    Stats.Reset();
+
+    for (int It = 0; It < Iterations; ++It)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        if (bAsync)
+        {
+            // The latency of a request is until its callback, which comes from the Update of Flush
+            for (std::uint32_t i = 0; i < GeomCount; ++i)
+            {
+                AsyncLoader.Request(GUIDs[i], [&, i, RequestStart = std::chrono::steady_clock::now()](xgeom_static::xgpu::geom* pGeom)
+                {
+                    AsyncGeoms[i] = pGeom;
+                    Latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - RequestStart).count());
+                });
+            }
+            AsyncLoader.Flush();
+            BestMS = std::min(BestMS, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+
+            for (std::uint32_t i = 0; i < GeomCount; ++i)
+            {
+                if (AsyncGeoms[i] == nullptr)
+                {
+                    printf("ERROR: Failed to load geom %u\n", i);
+                    return 1;
+                }
+                AsyncLoader.Release(GUIDs[i]);
+                AsyncGeoms[i] = nullptr;
+            }
+        }
+        else
+        {
+            for (std::uint32_t i = 0; i < GeomCount; ++i)
+            {
+                Refs[i].m_Instance = GUIDs[i].m_Instance;
+
+                const auto LoadStart = std::chrono::steady_clock::now();
+                if (Mgr.getResource(Refs[i]) == nullptr)
+                {
+                    printf("ERROR: Failed to load geom %u\n", i);
+                    return 1;
+                }
+                Latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - LoadStart).count());
+            }
+            BestMS = std::min(BestMS, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+
+            for (auto& Ref : Refs) Mgr.ReleaseRef(Ref);
+        }
+
+        if (UserData.m_Device.getLiveBuffers())
+        {
+            printf("ERROR: %zu buffers were not destroyed\n", UserData.m_Device.getLiveBuffers());
+            return 1;
+        }
+    }
+
+    const double nLoads = static_cast<double>(std::max<std::uint64_t>(1, Stats.m_nLoads.load()));
+    printf("Loads/sec           : %10.1f\n",           GeomCount / (BestMS / 1000.0));
+    printf("File MB/sec         : %10.1f\n",           FileBytes / (1024.0 * 1024.0) / (BestMS / 1000.0));
+    printf("Buffer MB/sec       : %10.1f\n",           Stats.m_BufferBytes.load() / nLoads * GeomCount / (1024.0 * 1024.0) / (BestMS / 1000.0));
+    printf("Load latency (us)   : %10.1f p50, %.1f p99, %.1f max\n", Percentile(Latency, 0.5), Percentile(Latency, 0.99), Percentile(Latency, 1.0));
+    printf("Read phase (us)     : %10.1f avg\n",       Stats.m_ReadNS.load()      / nLoads / 1000.0);
+    printf("Decode phase (us)   : %10.1f avg\n",       Stats.m_DecodeNS.load()    / nLoads / 1000.0);
+    printf("Buffers phase (us)  : %10.1f avg\n",       Stats.m_BuffersNS.load()   / nLoads / 1000.0);
+    printf("Materials phase (us): %10.1f avg\n",       Stats.m_MaterialsNS.load() / nLoads / 1000.0);
+    printf("Submits per load    : %10.3f\n",           Stats.m_nSubmits.load() / nLoads);
+    printf("Upload cost (us/MB) : %10.1f\n",           Stats.m_BuffersNS.load() / 1000.0 / std::max(1.0, Stats.m_BufferBytes.load() / (1024.0 * 1024.0)));
+
+    std::error_code Error;
+    std::filesystem::remove_all(RootPath, Error);
+
+    if (Stats.m_nFailed.load())
+    {
+        printf("ERROR: %llu loads failed\n", static_cast<unsigned long long>(Stats.m_nFailed.load()));
+        return 1;
+    }
+
+    return 0;
+}
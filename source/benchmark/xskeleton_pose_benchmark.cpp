@@ -0,0 +1,230 @@
+//
+// Benchmark for the per frame pose kernels (see xskeleton_pose.h). It builds synthetic rigs of
+// 50, 250 and 1000 bones and computes their skinning palette from a local pose in two ways:
+//      * Scalar - skeleton::FromTRS/Multiply for every bone (ComputePaletteScalar).
+//      * SIMD   - ComputePalette, 8/4 bones at a time for the local matrices and the rows of
+//                 the matrices in the parent ordered pass.
+// Both must give the same palette (within float rounding), which is verified at the end.
+//
+// Then a crowd of instances of the 250 bone rig goes through crowd::ComputePalettes with 1, 2,
+// 4, ... jobs up to the number of hardware threads, which shows how it scales with the workers.
+// Every job count must give exactly the palettes of ComputePalette called per instance.
+//
+// Usage: xskeleton_pose_benchmark [Iterations] [CrowdInstances]
+//
+#include "../xskeleton_pose.h"
+#include "../xskeleton_crowd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using skeleton = xskeleton::skeleton;
+    namespace pose = xskeleton::pose;
+
+    struct rig
+    {
+        std::vector<std::int16_t>       m_Parent;
+        std::vector<skeleton::vec4>     m_T, m_R, m_S;
+        std::vector<skeleton::affine>   m_InverseBind;
+        std::vector<float>              m_Local;
+        skeleton                        m_Skeleton;
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Mostly chains with some branching, like a character (spine, limbs, fingers)
+    //--------------------------------------------------------------------------------------
+    void BuildRig(rig& Rig, int nBones)
+    {
+        std::mt19937                            Random(1234u + nBones);
+        std::uniform_real_distribution<float>   Unit(-1.0f, 1.0f);
+
+        Rig.m_Parent.resize(nBones);
+        Rig.m_T.resize(nBones);
+        Rig.m_R.resize(nBones);
+        Rig.m_S.resize(nBones);
+        Rig.m_InverseBind.resize(nBones);
+
+        for (int i = 0; i < nBones; ++i)
+        {
+            Rig.m_Parent[i] = i == 0 ? skeleton::invalid_bone_v : static_cast<std::int16_t>(i - 1 - static_cast<int>(Random() % std::min(i, 4)));
+
+            skeleton::vec4 Q = { Unit(Random), Unit(Random), Unit(Random), Unit(Random) };
+            const float    L = std::sqrt(Q.m_X * Q.m_X + Q.m_Y * Q.m_Y + Q.m_Z * Q.m_Z + Q.m_W * Q.m_W);
+            Rig.m_R[i] = { Q.m_X / L, Q.m_Y / L, Q.m_Z / L, Q.m_W / L };
+            Rig.m_T[i] = { Unit(Random), Unit(Random), Unit(Random), 0 };
+            Rig.m_S[i] = { 1 + 0.2f * Unit(Random), 1 + 0.2f * Unit(Random), 1 + 0.2f * Unit(Random), 0 };
+        }
+
+        auto& S = Rig.m_Skeleton;
+        S.Initialize();
+        S.m_pParent             = Rig.m_Parent.data();
+        S.m_pBindTranslation    = Rig.m_T.data();
+        S.m_pBindRotation       = Rig.m_R.data();
+        S.m_pBindScale          = Rig.m_S.data();
+        S.m_pInverseBind        = Rig.m_InverseBind.data();
+        S.m_nBones              = static_cast<std::uint16_t>(nBones);
+        S.m_nRoots              = 1;
+
+        std::vector<skeleton::affine> Local(nBones);
+        S.ComputeBindLocal(Local);
+        S.ComputeModelPose(Local, Rig.m_InverseBind);
+        for (auto& M : Rig.m_InverseBind) M = skeleton::Inverse(M);
+
+        // Animate away from the bind pose so the palette is not the identity
+        Rig.m_Local.assign(pose::getLocalPoseSize(nBones), 0.0f);
+        pose::SetBindPose(S, Rig.m_Local);
+        const auto Stride = pose::getStride(nBones);
+        for (int i = 0; i < nBones; ++i)
+        {
+            Rig.m_Local[pose::TX * Stride + i] += 0.1f * Unit(Random);
+            Rig.m_Local[pose::TY * Stride + i] += 0.1f * Unit(Random);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    template< typename T_FUNCTION >
+    double BestOf(int Iterations, int Repeats, T_FUNCTION&& Function)
+    {
+        double Best = std::numeric_limits<double>::max();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            for (int r = 0; r < Repeats; ++r) Function();
+            const auto Stop  = std::chrono::steady_clock::now();
+            Best = std::min(Best, std::chrono::duration<double, std::nano>(Stop - Start).count() / Repeats);
+        }
+        return Best;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    float MaxDifference(const std::vector<skeleton::affine>& A, const std::vector<skeleton::affine>& B)
+    {
+        float Max = 0;
+        for (std::size_t i = 0; i < A.size(); ++i)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                const auto& a = A[i].m_Rows[r];
+                const auto& b = B[i].m_Rows[r];
+                Max = std::max({ Max, std::abs(a.m_X - b.m_X), std::abs(a.m_Y - b.m_Y), std::abs(a.m_Z - b.m_Z), std::abs(a.m_W - b.m_W) });
+            }
+        }
+        return Max;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const int           Iterations      = argc > 1 ? std::atoi(argv[1]) : 5;
+    const std::size_t   CrowdInstances  = argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 2000;
+
+    xscheduler::g_System.Init();
+
+    const char* pISA =
+#if defined(__AVX2__)
+        "AVX2";
+#elif defined(XSKELETON_POSE_SSE2)
+        "SSE2";
+#else
+        "Scalar";
+#endif
+
+    printf("Pose kernels: %s\n", pISA);
+    printf("Bones   Scalar ns/bone   SIMD ns/bone   Speedup\n");
+
+    bool bOK = true;
+    for (int nBones : { 50, 250, 1000 })
+    {
+        rig Rig;
+        BuildRig(Rig, nBones);
+
+        std::vector<skeleton::affine> Model(nBones), ScalarPalette(nBones), SIMDPalette(nBones);
+        const int Repeats = std::max(1, 2'000'000 / nBones);
+
+        const double ScalarTime = BestOf(Iterations, Repeats, [&]
+        {
+            pose::ComputePaletteScalar(Rig.m_Skeleton, Rig.m_Local, Model, ScalarPalette);
+        });
+
+        const double SIMDTime = BestOf(Iterations, Repeats, [&]
+        {
+            pose::ComputePalette(Rig.m_Skeleton, Rig.m_Local, Model, SIMDPalette);
+        });
+
+        const float Difference = MaxDifference(ScalarPalette, SIMDPalette);
+        printf("%5d   %14.2f   %12.2f   %6.2fx   (max diff %g)\n", nBones, ScalarTime / nBones, SIMDTime / nBones, ScalarTime / SIMDTime, Difference);
+
+        if (Difference > 1e-3f) bOK = false;
+    }
+
+    if (!bOK)
+    {
+        printf("ERROR: The SIMD palette is different from the scalar one\n");
+        return 1;
+    }
+
+    //
+    // Crowd, every instance with its own pose
+    //
+    {
+        constexpr int       nBones      = 250;
+        const std::size_t   PoseSize    = pose::getLocalPoseSize(nBones);
+
+        rig Rig;
+        BuildRig(Rig, nBones);
+
+        std::vector<float> LocalPoses(CrowdInstances * PoseSize);
+        for (std::size_t i = 0; i < CrowdInstances; ++i)
+        {
+            std::ranges::copy(Rig.m_Local, LocalPoses.begin() + i * PoseSize);
+            LocalPoses[i * PoseSize + pose::TX * pose::getStride(nBones)] += 0.01f * static_cast<float>(i % 100);
+        }
+
+        std::vector<skeleton::affine> Model(nBones), Expected(CrowdInstances * nBones);
+        for (std::size_t i = 0; i < CrowdInstances; ++i)
+            pose::ComputePalette(Rig.m_Skeleton, std::span<const float>(LocalPoses).subspan(i * PoseSize, PoseSize), Model, std::span(Expected).subspan(i * nBones, nBones));
+
+        const std::size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+        printf("\nCrowd: %zu instances of %d bones, %zu instances per batch\n", CrowdInstances, nBones, xskeleton::crowd::getBatchSize(Rig.m_Skeleton));
+        printf("Jobs    ms         Instances/ms   Speedup\n");
+
+        double OneJobTime = 0;
+        for (std::size_t nJobs = 1; ; nJobs = std::min(nJobs * 2, nThreads))
+        {
+            std::vector<skeleton::affine> Scratch(xskeleton::crowd::getScratchSize(Rig.m_Skeleton, nJobs));
+            std::vector<skeleton::affine> Palettes(CrowdInstances * nBones);
+
+            const double Time = BestOf(Iterations, 1, [&]
+            {
+                xskeleton::crowd::ComputePalettes(Rig.m_Skeleton, LocalPoses, Palettes, Scratch);
+            }) / 1e6;
+            if (nJobs == 1) OneJobTime = Time;
+
+            printf("%4zu   %8.3f   %12.1f   %6.2fx\n", nJobs, Time, CrowdInstances / Time, OneJobTime / Time);
+
+            if (std::memcmp(Palettes.data(), Expected.data(), Palettes.size() * sizeof(skeleton::affine)))
+            {
+                printf("ERROR: The crowd palettes with %zu jobs are different from the per instance ones\n", nJobs);
+                return 1;
+            }
+
+            if (nJobs == nThreads) break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,404 @@
+//
+// Benchmark for the serialization of the geom tables (meshes, LODs, submeshes and clusters).
+// It builds synthetic tables (100K clusters by default) and saves/loads them with xserializer
+// in two ways:
+//      * Per field - Every element of every table goes through its SerializeIO function
+//                    (the path used up to xserializer_version_v 4).
+//      * Bulk      - Every table is a single block of words (table_io::SerializeTable), which
+//                    is what the geom uses now.
+// The bulk load must give back exactly the same tables, which is verified at the end.
+//
+// Usage: xskeleton_serialize_benchmark [ClusterCount] [Iterations]
+//
+#include "dependencies/xresource_pipeline_v2/source/xresource_pipeline.h"
+#include "../xskeleton.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    using geom = xgeom_static::geom;
+
+    // Same tables that the geom has, so both paths move the same data
+    template< bool T_BULK_V >
+    struct tables
+    {
+        inline static constexpr auto xserializer_version_v = 1;
+
+        geom::mesh*         m_pMesh;
+        geom::lod*          m_pLOD;
+        geom::submesh*      m_pSubMesh;
+        geom::cluster*      m_pCluster;
+        std::uint16_t       m_nMeshes;
+        std::uint16_t       m_nLODs;
+        std::uint16_t       m_nSubMeshs;
+        std::uint32_t       m_nClusters;
+    };
+
+    using per_field_tables  = tables<false>;
+    using bulk_tables       = tables<true>;
+
+    //--------------------------------------------------------------------------------------
+
+    struct source
+    {
+        std::vector<geom::mesh>     m_Mesh;
+        std::vector<geom::lod>      m_LOD;
+        std::vector<geom::submesh>  m_SubMesh;
+        std::vector<geom::cluster>  m_Cluster;
+
+        template< typename T >
+        T getTables(void) noexcept
+        {
+            return
+            { .m_pMesh      = m_Mesh.data()
+            , .m_pLOD       = m_LOD.data()
+            , .m_pSubMesh   = m_SubMesh.data()
+            , .m_pCluster   = m_Cluster.data()
+            , .m_nMeshes    = static_cast<std::uint16_t>(m_Mesh.size())
+            , .m_nLODs      = static_cast<std::uint16_t>(m_LOD.size())
+            , .m_nSubMeshs  = static_cast<std::uint16_t>(m_SubMesh.size())
+            , .m_nClusters  = static_cast<std::uint32_t>(m_Cluster.size())
+            };
+        }
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    source BuildTables(std::size_t ClusterCount)
+    {
+        constexpr std::uint32_t meshes_v        = 64;
+        constexpr std::uint32_t lods_v          = 4;
+        constexpr std::uint32_t submeshes_v     = 4;
+
+        source Source;
+        Source.m_Mesh.resize(meshes_v);
+        Source.m_LOD.resize(meshes_v * lods_v);
+        Source.m_SubMesh.resize(meshes_v * lods_v * submeshes_v);
+        Source.m_Cluster.resize(ClusterCount);
+
+        // Zero everything first so the tables can be compared with memcmp after the round trip
+        std::memset(Source.m_Mesh.data(),    0, Source.m_Mesh.size()    * sizeof(geom::mesh));
+        std::memset(Source.m_LOD.data(),     0, Source.m_LOD.size()     * sizeof(geom::lod));
+        std::memset(Source.m_SubMesh.data(), 0, Source.m_SubMesh.size() * sizeof(geom::submesh));
+        std::memset(Source.m_Cluster.data(), 0, Source.m_Cluster.size() * sizeof(geom::cluster));
+
+        for (std::uint32_t i = 0; i < meshes_v; ++i)
+        {
+            auto& M = Source.m_Mesh[i];
+            std::snprintf(M.m_Name.data(), M.m_Name.size(), "Mesh_%u", i);
+            M.m_WorldPixelSize  = 0.01f * (i + 1);
+            M.m_BBox.m_Min      = xmath::fvec3(-float(i), -1.0f, -1.0f);
+            M.m_BBox.m_Max      = xmath::fvec3( float(i),  1.0f,  1.0f);
+            M.m_iLOD            = static_cast<std::uint16_t>(i * lods_v);
+            M.m_nLODs           = lods_v;
+        }
+
+        for (std::uint32_t i = 0; i < Source.m_LOD.size(); ++i)
+        {
+            auto& L = Source.m_LOD[i];
+            L.m_ScreenArea      = 1000.0f / (1 + i % lods_v);
+            L.m_GeometricError  = 0.001f * (i % lods_v);
+            L.m_iSubmesh        = static_cast<std::uint16_t>(i * submeshes_v);
+            L.m_nSubmesh        = submeshes_v;
+            L.m_iVertex         = i * 1024;
+            L.m_nVertices       = 1024;
+            L.m_iIndex          = i * 4096;
+            L.m_nIndices        = 4096;
+        }
+
+        const auto ClustersPerSubmesh = static_cast<std::uint32_t>(ClusterCount / Source.m_SubMesh.size());
+        for (std::uint32_t i = 0; i < Source.m_SubMesh.size(); ++i)
+        {
+            auto& S = Source.m_SubMesh[i];
+            S.m_iCluster        = i * ClustersPerSubmesh;
+            S.m_nCluster        = ClustersPerSubmesh;
+            S.m_iMaterial       = static_cast<std::uint16_t>(i % submeshes_v);
+        }
+
+        for (std::uint32_t i = 0; i < ClusterCount; ++i)
+        {
+            auto&       C = Source.m_Cluster[i];
+            const float f = static_cast<float>(i);
+            C.m_PosScaleAndUScale       = { 1.0f, 2.0f, 3.0f, 0.5f };
+            C.m_PosTrasnlationAndVScale = { f, -f, f * 0.5f, 0.25f };
+            C.m_UVTranslation           = { 0.1f, 0.2f };
+            C.m_BBox.m_Min              = xmath::fvec3(f - 1, -1.0f, -1.0f);
+            C.m_BBox.m_Max              = xmath::fvec3(f + 1,  1.0f,  1.0f);
+            C.m_BoundingSphere          = { f, 0.0f, 0.0f, 1.5f };
+            C.m_NormalCone              = { 0.0f, 1.0f, 0.0f, 0.7f };
+            C.m_iIndex                  = i * 384;
+            C.m_nIndices                = 384;
+            C.m_iVertex                 = i * 128;
+            C.m_nVertices               = 128;
+        }
+
+        return Source;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    template< typename T >
+    bool SameTable(const T* pA, const T* pB, std::size_t Count) noexcept
+    {
+        return std::memcmp(pA, pB, Count * sizeof(T)) == 0;
+    }
+
+    bool SameTables(const source& Source, const bulk_tables& Tables) noexcept
+    {
+        return Tables.m_nMeshes     == Source.m_Mesh.size()
+            && Tables.m_nLODs       == Source.m_LOD.size()
+            && Tables.m_nSubMeshs   == Source.m_SubMesh.size()
+            && Tables.m_nClusters   == Source.m_Cluster.size()
+            && SameTable(Tables.m_pMesh,    Source.m_Mesh.data(),    Source.m_Mesh.size())
+            && SameTable(Tables.m_pLOD,     Source.m_LOD.data(),     Source.m_LOD.size())
+            && SameTable(Tables.m_pSubMesh, Source.m_SubMesh.data(), Source.m_SubMesh.size())
+            && SameTable(Tables.m_pCluster, Source.m_Cluster.data(), Source.m_Cluster.size());
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    template< typename T_FUNCTION >
+    double BestOf(int Iterations, T_FUNCTION&& Function)
+    {
+        double Best = std::numeric_limits<double>::max();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            Function();
+            const auto Stop  = std::chrono::steady_clock::now();
+            Best = std::min(Best, std::chrono::duration<double, std::milli>(Stop - Start).count());
+        }
+        return Best;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    struct timings
+    {
+        double      m_SaveMS    = 0;
+        double      m_LoadMS    = 0;
+        std::size_t m_FileSize  = 0;
+        bool        m_bOK       = true;
+    };
+
+    template< typename T >
+    timings Measure(source& Source, const std::wstring& Path, int Iterations)
+    {
+        timings Timings;
+        const T Tables = Source.getTables<T>();
+
+        Timings.m_SaveMS = BestOf(Iterations, [&]
+        {
+            xserializer::stream Stream;
+            if (auto Err = Stream.Save(Path, Tables, xserializer::compression_level::FAST); Err)
+            {
+                printf("ERROR: %s\n", std::string(Err.getMessage()).c_str());
+                Timings.m_bOK = false;
+            }
+        });
+
+        std::error_code Error;
+        Timings.m_FileSize = static_cast<std::size_t>(std::filesystem::file_size(Path, Error));
+
+        Timings.m_LoadMS = BestOf(Iterations, [&]
+        {
+            xserializer::stream Stream;
+            T*                  pTables = nullptr;
+            if (auto Err = Stream.Load(Path, pTables); Err)
+            {
+                printf("ERROR: %s\n", std::string(Err.getMessage()).c_str());
+                Timings.m_bOK = false;
+                return;
+            }
+
+            if constexpr (std::is_same_v<T, bulk_tables>)
+            {
+                if (SameTables(Source, *pTables) == false) Timings.m_bOK = false;
+            }
+
+            xserializer::default_memory_handler_v.Free(xserializer::mem_type{ .m_bUnique = true }, pTables);
+        });
+
+        std::filesystem::remove(Path, Error);
+        return Timings;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+namespace xserializer::io_functions
+{
+    //-------------------------------------------------------------------------
+    // Per field description of the tables, only the per field path of the benchmark uses it
+    //-------------------------------------------------------------------------
+    template<> inline
+    xerr SerializeIO<xgeom_static::geom::lod>(xserializer::stream& Stream, const xgeom_static::geom::lod& Lod) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Lod.m_ScreenArea))
+            || (Err = Stream.Serialize(Lod.m_GeometricError))
+            || (Err = Stream.Serialize(Lod.m_iSubmesh))
+            || (Err = Stream.Serialize(Lod.m_nSubmesh))
+            || (Err = Stream.Serialize(Lod.m_iVertex))
+            || (Err = Stream.Serialize(Lod.m_nVertices))
+            || (Err = Stream.Serialize(Lod.m_iIndex))
+            || (Err = Stream.Serialize(Lod.m_nIndices))
+            ;
+        return Err;
+    }
+
+    //-------------------------------------------------------------------------
+    template<> inline
+    xerr SerializeIO<xgeom_static::geom::mesh>(xserializer::stream& Stream, const xgeom_static::geom::mesh& Mesh) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Mesh.m_Name))
+            || (Err = Stream.Serialize(Mesh.m_WorldPixelSize))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_X))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_Y))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_Z))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_X))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_Y))
+            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_Z))
+            || (Err = Stream.Serialize(Mesh.m_nLODs))
+            || (Err = Stream.Serialize(Mesh.m_iLOD))
+            ;
+        return Err;
+    }
+
+    //-------------------------------------------------------------------------
+    template<> inline
+    xerr SerializeIO<xgeom_static::geom::submesh>(xserializer::stream& Stream, const xgeom_static::geom::submesh& Submesh) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Submesh.m_iCluster))
+            || (Err = Stream.Serialize(Submesh.m_nCluster))
+            || (Err = Stream.Serialize(Submesh.m_iMaterial))
+            || (Err = Stream.Serialize(Submesh.m_Padding))
+            ;
+        return Err;
+    }
+
+    //-------------------------------------------------------------------------
+    template<> inline
+    xerr SerializeIO<xgeom_static::geom::cluster>(xserializer::stream& Stream, const xgeom_static::geom::cluster& Cluster) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_X))
+            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_Z))
+            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_W))
+
+            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_X))
+            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_Z))
+            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_W))
+
+            || (Err = Stream.Serialize(Cluster.m_UVTranslation.m_X))
+            || (Err = Stream.Serialize(Cluster.m_UVTranslation.m_Y))
+
+            || (Err = Stream.Serialize(Cluster.m_nVertices))
+            || (Err = Stream.Serialize(Cluster.m_nIndices))
+            || (Err = Stream.Serialize(Cluster.m_iIndex))
+            || (Err = Stream.Serialize(Cluster.m_iVertex))
+            || (Err = Stream.Serialize(Cluster.m_iBone))
+            || (Err = Stream.Serialize(Cluster.m_nBones))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_X))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_Z))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_X))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_Z))
+
+            || (Err = Stream.Serialize(Cluster.m_BoundingSphere.m_X))
+            || (Err = Stream.Serialize(Cluster.m_BoundingSphere.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_BoundingSphere.m_Z))
+            || (Err = Stream.Serialize(Cluster.m_BoundingSphere.m_W))
+
+            || (Err = Stream.Serialize(Cluster.m_NormalCone.m_X))
+            || (Err = Stream.Serialize(Cluster.m_NormalCone.m_Y))
+            || (Err = Stream.Serialize(Cluster.m_NormalCone.m_Z))
+            || (Err = Stream.Serialize(Cluster.m_NormalCone.m_W))
+            ;
+        return Err;
+    }
+
+    //-------------------------------------------------------------------------
+    template<> inline
+    xerr SerializeIO<per_field_tables>(xserializer::stream& Stream, const per_field_tables& Tables) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Tables.m_nMeshes))
+            || (Err = Stream.Serialize(Tables.m_pMesh,      Tables.m_nMeshes))
+            || (Err = Stream.Serialize(Tables.m_nLODs))
+            || (Err = Stream.Serialize(Tables.m_pLOD,       Tables.m_nLODs))
+            || (Err = Stream.Serialize(Tables.m_nSubMeshs))
+            || (Err = Stream.Serialize(Tables.m_pSubMesh,   Tables.m_nSubMeshs))
+            || (Err = Stream.Serialize(Tables.m_nClusters))
+            || (Err = Stream.Serialize(Tables.m_pCluster,   Tables.m_nClusters))
+            ;
+        return Err;
+    }
+
+    template<> inline
+    xerr SerializeIO<bulk_tables>(xserializer::stream& Stream, const bulk_tables& Tables) noexcept
+    {
+        xerr Err;
+        false
+            || (Err = Stream.Serialize(Tables.m_nMeshes))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Tables.m_pMesh,       Tables.m_nMeshes))
+            || (Err = Stream.Serialize(Tables.m_nLODs))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Tables.m_pLOD,        Tables.m_nLODs))
+            || (Err = Stream.Serialize(Tables.m_nSubMeshs))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Tables.m_pSubMesh,    Tables.m_nSubMeshs))
+            || (Err = Stream.Serialize(Tables.m_nClusters))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Tables.m_pCluster,    Tables.m_nClusters))
+            ;
+        return Err;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const std::size_t   ClusterCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000;
+    const int           Iterations   = argc > 2 ? std::atoi(argv[2]) : 5;
+    const auto          Path         = (std::filesystem::temp_directory_path() / "xskeleton_serialize_benchmark.bin").wstring();
+
+    auto Source = BuildTables(ClusterCount);
+    printf("Tables: %zu meshes, %zu LODs, %zu submeshes, %zu clusters (%zu bytes)\n"
+        , Source.m_Mesh.size(), Source.m_LOD.size(), Source.m_SubMesh.size(), Source.m_Cluster.size()
+        , Source.m_Mesh.size()    * sizeof(geom::mesh)
+        + Source.m_LOD.size()     * sizeof(geom::lod)
+        + Source.m_SubMesh.size() * sizeof(geom::submesh)
+        + Source.m_Cluster.size() * sizeof(geom::cluster));
+
+    const auto PerField = Measure<per_field_tables>(Source, Path, Iterations);
+    const auto Bulk     = Measure<bulk_tables>(Source, Path, Iterations);
+
+    printf("Per field save      : %10.2f ms, load %10.2f ms (%zu bytes)\n", PerField.m_SaveMS, PerField.m_LoadMS, PerField.m_FileSize);
+    printf("Bulk save           : %10.2f ms, load %10.2f ms (%zu bytes)\n", Bulk.m_SaveMS, Bulk.m_LoadMS, Bulk.m_FileSize);
+    printf("Speedup             : %10.2fx save, %.2fx load\n", PerField.m_SaveMS / Bulk.m_SaveMS, PerField.m_LoadMS / Bulk.m_LoadMS);
+
+    if (PerField.m_bOK == false || Bulk.m_bOK == false)
+    {
+        printf("ERROR: The tables did not survive the round trip\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+//
+// Benchmark for the CPU skinning (see xskeleton_skinning.h). It builds a synthetic skinned geom
+// (1M vertices by default, clusters of 64 vertices with up to 4 bones each out of a 64 bone
+// skeleton) and skins all its positions and normals in three ways:
+//      * Scalar   - SkinClusterScalar for every cluster on this thread.
+//      * SIMD     - SkinCluster for every cluster on this thread.
+//      * Parallel - skinning::Skin, the SIMD kernel on all the xscheduler workers.
+// All of them must give the same positions and normals (within float rounding), which is
+// verified at the end.
+//
+// Usage: xskeleton_skinning_benchmark [VertexCount] [Iterations]
+//
+#include "dependencies/xresource_pipeline_v2/source/xresource_pipeline.h"
+#include "../xskeleton_skinning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using geom      = xgeom_static::geom;
+    using skeleton  = xskeleton::skeleton;
+    namespace skinning = xskeleton::skinning;
+
+    constexpr std::uint32_t cluster_vertices_v = 64;
+    constexpr std::uint32_t skeleton_bones_v   = 64;
+
+    // Every table of the geom, the geom only points at them
+    struct synthetic
+    {
+        std::vector<geom::cluster>      m_Clusters;
+        std::vector<std::uint16_t>      m_ClusterBones;
+        std::vector<char>               m_Data;
+        std::vector<skeleton::affine>   m_Palette;
+        geom                            m_Geom;
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    void BuildGeom(synthetic& S, std::uint32_t nVertices)
+    {
+        std::mt19937                            Random(1234u);
+        std::uniform_real_distribution<float>   Unit(-1.0f, 1.0f);
+        std::uniform_int_distribution<int>      Q16(-32768, 32767);
+
+        const std::uint32_t nClusters = (nVertices + cluster_vertices_v - 1) / cluster_vertices_v;
+
+        const std::size_t VertexOffset       = 0;
+        const std::size_t VertexExtrasOffset = VertexOffset       + nVertices * sizeof(geom::vertex);
+        const std::size_t VertexSkinOffset   = VertexExtrasOffset + nVertices * sizeof(geom::vertex_extras);
+        S.m_Data.assign(VertexSkinOffset + nVertices * sizeof(geom::vertex_skin), 0);
+
+        auto* pVertex = reinterpret_cast<geom::vertex*>(S.m_Data.data() + VertexOffset);
+        auto* pExtras = reinterpret_cast<geom::vertex_extras*>(S.m_Data.data() + VertexExtrasOffset);
+        auto* pSkin   = reinterpret_cast<geom::vertex_skin*>(S.m_Data.data() + VertexSkinOffset);
+
+        S.m_Clusters.resize(nClusters);
+        for (std::uint32_t c = 0; c < nClusters; ++c)
+        {
+            auto& Cluster = S.m_Clusters[c];
+            Cluster = {};
+            Cluster.m_PosScaleAndUScale         = { 0.5f + 0.25f * Unit(Random), 0.5f + 0.25f * Unit(Random), 0.5f + 0.25f * Unit(Random), 1 };
+            Cluster.m_PosTrasnlationAndVScale   = { 10 * Unit(Random), 10 * Unit(Random), 10 * Unit(Random), 1 };
+            Cluster.m_iVertex                   = c * cluster_vertices_v;
+            Cluster.m_nVertices                 = std::min(cluster_vertices_v, nVertices - Cluster.m_iVertex);
+            Cluster.m_iBone                     = static_cast<std::uint32_t>(S.m_ClusterBones.size());
+            Cluster.m_nBones                    = 1 + Random() % 4;
+
+            for (std::uint32_t i = 0; i < Cluster.m_nBones; ++i)
+                S.m_ClusterBones.push_back(static_cast<std::uint16_t>(Random() % skeleton_bones_v));
+
+            for (std::uint32_t v = Cluster.m_iVertex; v < Cluster.m_iVertex + Cluster.m_nVertices; ++v)
+            {
+                pVertex[v] = { static_cast<std::int16_t>(Q16(Random)), static_cast<std::int16_t>(Q16(Random)), static_cast<std::int16_t>(Q16(Random)), 0 };
+                pExtras[v].m_OctNormal = { static_cast<std::uint8_t>(Random()), static_cast<std::uint8_t>(Random()) };
+
+                // Weights that add up to 255, the unused influences have a weight of 0
+                int Left = 255;
+                for (std::uint32_t i = 0; i < 4; ++i)
+                {
+                    const int W = i + 1 == Cluster.m_nBones ? Left : static_cast<int>(Random() % (Left + 1));
+                    pSkin[v].m_iBone[i]  = static_cast<std::uint8_t>(i < Cluster.m_nBones ? i : 0);
+                    pSkin[v].m_Weight[i] = static_cast<std::uint8_t>(i < Cluster.m_nBones ? W : 0);
+                    if (i < Cluster.m_nBones) Left -= W;
+                }
+            }
+        }
+
+        // Rotation, scale and translation away from the identity
+        S.m_Palette.resize(skeleton_bones_v);
+        for (auto& M : S.m_Palette)
+        {
+            for (auto& Row : M.m_Rows) Row = { Unit(Random), Unit(Random), Unit(Random), 5 * Unit(Random) };
+            M.m_Rows[0].m_X += 1.5f;
+            M.m_Rows[1].m_Y += 1.5f;
+            M.m_Rows[2].m_Z += 1.5f;
+        }
+
+        auto& G = S.m_Geom;
+        G.Initialize();
+        G.m_pData                   = S.m_Data.data();
+        G.m_pCluster                = S.m_Clusters.data();
+        G.m_pClusterBone            = S.m_ClusterBones.data();
+        G.m_DataSize                = S.m_Data.size();
+        G.m_VertexOffset            = VertexOffset;
+        G.m_VertexExtrasOffset      = VertexExtrasOffset;
+        G.m_IndicesOffset           = VertexSkinOffset;
+        G.m_VertexSkinOffset        = VertexSkinOffset;
+        G.m_nClusters               = nClusters;
+        G.m_nVertices               = nVertices;
+        G.m_nClusterBones           = static_cast<std::uint32_t>(S.m_ClusterBones.size());
+        G.m_VertexEncoding          = geom::vertex_encoding::RAW;
+        G.m_VertexExtrasEncoding    = geom::vertex_encoding::RAW;
+        G.m_Skeleton.m_nBones       = skeleton_bones_v;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    template< typename T_FUNCTION >
+    double BestOf(int Iterations, T_FUNCTION&& Function)
+    {
+        double Best = std::numeric_limits<double>::max();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            Function();
+            const auto Stop  = std::chrono::steady_clock::now();
+            Best = std::min(Best, std::chrono::duration<double, std::milli>(Stop - Start).count());
+        }
+        return Best;
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    float MaxDifference(const std::vector<geom::vec3>& A, const std::vector<geom::vec3>& B)
+    {
+        float Max = 0;
+        for (std::size_t i = 0; i < A.size(); ++i)
+            Max = std::max({ Max, std::abs(A[i].m_X - B[i].m_X), std::abs(A[i].m_Y - B[i].m_Y), std::abs(A[i].m_Z - B[i].m_Z) });
+        return Max;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const std::uint32_t nVertices  = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 1'000'000;
+    const int           Iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    xscheduler::g_System.Init();
+
+    synthetic S;
+    BuildGeom(S, nVertices);
+
+    const char* pISA =
+#if defined(__AVX2__)
+        "AVX2";
+#elif defined(XSKELETON_SKINNING_SSE2)
+        "SSE2";
+#else
+        "Scalar";
+#endif
+
+    printf("Skinning kernels: %s, %u vertices in %u clusters\n", pISA, nVertices, S.m_Geom.m_nClusters);
+    printf("Path        ms        Vertices/ms   Speedup\n");
+
+    struct result
+    {
+        std::vector<geom::vec3> m_Positions;
+        std::vector<geom::vec3> m_Normals;
+    };
+    result Scalar{ std::vector<geom::vec3>(nVertices), std::vector<geom::vec3>(nVertices) };
+    result SIMD     = Scalar;
+    result Parallel = Scalar;
+
+    bool bOK = true;
+    const double ScalarTime = BestOf(Iterations, [&]
+    {
+        for (const auto& Cluster : S.m_Geom.getClusters())
+            bOK &= skinning::SkinClusterScalar(S.m_Geom, S.m_Palette, Cluster, Scalar.m_Positions, Scalar.m_Normals);
+    });
+
+    const double SIMDTime = BestOf(Iterations, [&]
+    {
+        for (const auto& Cluster : S.m_Geom.getClusters())
+            bOK &= skinning::SkinCluster(S.m_Geom, S.m_Palette, Cluster, SIMD.m_Positions, SIMD.m_Normals);
+    });
+
+    const double ParallelTime = BestOf(Iterations, [&]
+    {
+        bOK &= skinning::Skin(S.m_Geom, S.m_Palette, Parallel.m_Positions, Parallel.m_Normals);
+    });
+
+    printf("Scalar   %8.3f   %12.0f   %6.2fx\n", ScalarTime,   nVertices / ScalarTime,   1.0);
+    printf("SIMD     %8.3f   %12.0f   %6.2fx\n", SIMDTime,     nVertices / SIMDTime,     ScalarTime / SIMDTime);
+    printf("Parallel %8.3f   %12.0f   %6.2fx\n", ParallelTime, nVertices / ParallelTime, ScalarTime / ParallelTime);
+
+    // The positions are up to ~50 units away, the normals are unit vectors
+    const float PositionDifference = std::max(MaxDifference(Scalar.m_Positions, SIMD.m_Positions), MaxDifference(Scalar.m_Positions, Parallel.m_Positions));
+    const float NormalDifference   = std::max(MaxDifference(Scalar.m_Normals,   SIMD.m_Normals),   MaxDifference(Scalar.m_Normals,   Parallel.m_Normals));
+    printf("Max diff: positions %g, normals %g\n", PositionDifference, NormalDifference);
+
+    if (!bOK)
+    {
+        printf("ERROR: A cluster was rejected\n");
+        return 1;
+    }
+
+    if (PositionDifference > 1e-3f || NormalDifference > 1e-3f)
+    {
+        printf("ERROR: The SIMD skinning is different from the scalar one\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,6 +2,233 @@
 #include "xgeom_static_compiler.h"
 #include "dependencies/xscheduler/source/xscheduler.h"
 
+#include "xskeleton_compiler_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+//---------------------------------------------------------------------------------------
+// Global allocation hooks so the compile trace can report the memory of every stage. The
+// size comes from the allocator so the blocks do not need a header. They cost every
+// allocation a size query, so they are only built with XSKELETON_TRACE_MEMORY.
+//---------------------------------------------------------------------------------------
+#if defined(XSKELETON_TRACE_MEMORY)
+
+#if defined(__APPLE__)
+    #include <malloc/malloc.h>
+#elif !defined(_WIN32)
+    #include <malloc.h>
+#endif
+
+static std::size_t AllocationSize( void* p ) noexcept
+{
+#if defined(_WIN32)
+    return _msize(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+void* operator new( std::size_t Size )
+{
+    void* p = std::malloc(Size ? Size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    xgeom_static_compiler::trace::alloc::OnAlloc(AllocationSize(p));
+    return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+    if (p == nullptr) return;
+    xgeom_static_compiler::trace::alloc::OnFree(AllocationSize(p));
+    std::free(p);
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+    operator delete(p);
+}
+
+// Over aligned types (the geom arena, SIMD scratch) come here instead
+
+static std::size_t AlignedAllocationSize( void* p, std::size_t Alignment ) noexcept
+{
+#if defined(_WIN32)
+    return _aligned_msize(p, Alignment, 0);
+#else
+    (void)Alignment;
+    return AllocationSize(p);
+#endif
+}
+
+void* operator new( std::size_t Size, std::align_val_t Alignment )
+{
+    const auto Align = std::max(static_cast<std::size_t>(Alignment), sizeof(void*));
+#if defined(_WIN32)
+    void* p = _aligned_malloc(Size ? Size : 1, Align);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, Align, Size ? Size : 1) != 0) p = nullptr;
+#endif
+    if (p == nullptr) throw std::bad_alloc();
+    xgeom_static_compiler::trace::alloc::OnAlloc(AlignedAllocationSize(p, Align));
+    return p;
+}
+
+void operator delete( void* p, std::align_val_t Alignment ) noexcept
+{
+    if (p == nullptr) return;
+    const auto Align = std::max(static_cast<std::size_t>(Alignment), sizeof(void*));
+    xgeom_static_compiler::trace::alloc::OnFree(AlignedAllocationSize(p, Align));
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete( void* p, std::size_t, std::align_val_t Alignment ) noexcept
+{
+    operator delete(p, Alignment);
+}
+
+#endif
+
+//---------------------------------------------------------------------------------------
+
+static std::string FormatError( const xerr Err )
+{
+    std::string Out;
+    Err.ForEachInChain([&](xerr Error)
+    {
+        auto Hint = Error.getHint();
+        Out += std::format("Error: {}\n", Error.getMessage());
+        if (Hint.empty() == false)
+            Out += std::format("Hint: {}\n", Hint);
+    });
+    return Out;
+}
+
+//---------------------------------------------------------------------------------------
+// Batch mode: -BATCH <manifest> replaces -DESCRIPTOR. The manifest is a text file with one
+// descriptor path per line (same format as -DESCRIPTOR), empty lines and lines starting with
+// # are ignored. All the descriptors are compiled concurrently in this process, each one with
+// its own compiler instance and the rest of the arguments. A failing asset (error or
+// exception) is reported and does not stop the others.
+//
+// The assets run on plain threads, not on the scheduler workers: a compile waits on its own
+// ParallelFor jobs, and doing that from a worker could leave every worker blocked in a join
+// with the jobs it waits for still queued.
+//---------------------------------------------------------------------------------------
+
+static int BatchCompile( int argc, const char* argv[], int iBatchArg )
+{
+    if (iBatchArg + 1 >= argc)
+    {
+        printf("Error: -BATCH expects the path of a manifest file\n");
+        return 1;
+    }
+
+    std::vector<std::string> Descriptors;
+    {
+        std::ifstream Manifest(argv[iBatchArg + 1]);
+        if (!Manifest)
+        {
+            printf("Error: Unable to open the batch manifest %s\n", argv[iBatchArg + 1]);
+            return 1;
+        }
+
+        for (std::string Line; std::getline(Manifest, Line); )
+        {
+            const auto Begin = Line.find_first_not_of(" \t\r");
+            const auto End   = Line.find_last_not_of(" \t\r");
+            if (Begin == std::string::npos || Line[Begin] == '#') continue;
+            Descriptors.emplace_back(Line.substr(Begin, End - Begin + 1));
+        }
+    }
+
+    // Shared arguments, every asset appends its own -DESCRIPTOR
+    std::vector<const char*> SharedArgs;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (i == iBatchArg) { ++i; continue; }
+        SharedArgs.push_back(argv[i]);
+    }
+
+    std::mutex                  PrintMutex;
+    std::vector<bool>           Failed(Descriptors.size(), false);
+    std::atomic<std::size_t>    iNext = 0;
+
+    auto Report = [&](std::size_t iAsset, const std::string& Message)
+    {
+        std::scoped_lock Lock(PrintMutex);
+        Failed[iAsset] = true;
+        printf("[%s]\n%s", Descriptors[iAsset].c_str(), Message.c_str());
+    };
+
+    auto CompileAsset = [&](std::size_t iAsset)
+    {
+        try
+        {
+            auto Args = SharedArgs;
+            Args.push_back("-DESCRIPTOR");
+            Args.push_back(Descriptors[iAsset].c_str());
+
+            auto    GeomCompilerPipeline = xgeom_static_compiler::instance::Create();
+            xerr    Err                  = GeomCompilerPipeline->Parse(static_cast<int>(Args.size()), Args.data());
+            if (!Err) Err = GeomCompilerPipeline->Compile();
+            if (Err) Report(iAsset, FormatError(Err));
+        }
+        catch (const std::exception& Exception)
+        {
+            Report(iAsset, std::format("Error: {}\n", Exception.what()));
+        }
+        catch (...)
+        {
+            Report(iAsset, "Error: Unknown exception\n");
+        }
+    };
+
+    // Every thread takes the next asset until there are none left, the threads join at the end of the scope
+    {
+        const std::size_t           nThreads = std::min<std::size_t>(Descriptors.size(), std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::jthread>   Threads;
+        Threads.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads; ++i)
+        {
+            Threads.emplace_back([&]
+            {
+                for (std::size_t iAsset; (iAsset = iNext++) < Descriptors.size(); )
+                    CompileAsset(iAsset);
+            });
+        }
+    }
+
+    //
+    // Summary
+    //
+    std::size_t nFailed = 0;
+    for (std::size_t i = 0; i < Descriptors.size(); ++i)
+    {
+        if (Failed[i] == false) continue;
+        if (nFailed++ == 0) printf("Failed assets:\n");
+        printf("    %s\n", Descriptors[i].c_str());
+    }
+    printf("Batch: %zu compiled, %zu failed\n", Descriptors.size() - nFailed, nFailed);
+
+    return nFailed ? 1 : 0;
+}
+
 //---------------------------------------------------------------------------------------
 
 int main( int argc, const char* argv[] )
@@ -11,6 +238,15 @@ int main( int argc, const char* argv[] )
     //
     xscheduler::g_System.Init();
 
+    //
+    // Batch mode compiles many descriptors in this process
+    //
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "-BATCH")
+            return BatchCompile(argc, argv, i);
+    }
+
     //
    // Create the compiler instance
    //
@@ -42,14 +278,7 @@ int main( int argc, const char* argv[] )
     //
     if (auto Err = GeomCompilerPipeline->Parse(argc, argv); Err)
     {
-        Err.ForEachInChain([&](xerr Error)
-        {
-            auto Hint = Err.getHint();
-            auto String = std::format("Error: {}\n", Err.getMessage());
-            printf("%s", String.c_str());
-            if (Hint.empty() == false)
-                printf("Hint: %s\n", Hint.data());
-        });
+        printf("%s", FormatError(Err).c_str());
         return 1;
     }
 
@@ -58,14 +287,7 @@ int main( int argc, const char* argv[] )
     //
     if (auto Err = GeomCompilerPipeline->Compile(); Err)
     {
-        Err.ForEachInChain([&](xerr Error)
-        {
-            auto Hint = Err.getHint();
-            auto String = std::format("Error: {}\n", Err.getMessage());
-            printf("%s", String.c_str());
-            if (Hint.empty() == false)
-                printf("Hint: %s\n", Hint.data());
-        });
+        printf("%s", FormatError(Err).c_str());
         return 1;
     }
 
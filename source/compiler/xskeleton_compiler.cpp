@@ -12,6 +12,17 @@
 #include "../xgeom_static_descriptor.h"
 #include "../xgeom_static.h"
 #include "../xgeom_static_details.h"
+#include "../xskeleton_parallel.h"
+#include "../xskeleton_blob.h"
+#include "../xskeleton_index_codec.h"
+#include "../xskeleton_vertex_codec.h"
+#include "xskeleton_compiler_tri_soa.h"
+#include "xskeleton_compiler_import_cache.h"
+#include "xskeleton_compiler_stage_cache.h"
+#include "xskeleton_compiler_trace.h"
+#include "xskeleton_compiler_mesh_lookup.h"
+#include "xskeleton_compiler_codec_report.h"
+#include "xskeleton_compiler_skeleton.h"
 
 #include "dependencies/xproperty/source/xcore/my_properties.cpp"
 #include "dependencies/xmath/source/bridge/xmath_to_xproperty.h"
@@ -30,11 +41,15 @@ namespace xgeom_static_compiler
             xmath::fvec3                    m_Normal;
             xmath::fvec3                    m_Tangent;
             xmath::fvec3                    m_Binormal;
+            std::array<std::uint16_t, 4>    m_iBone;                        // Bones in skeleton_builder order, the largest weight first
+            std::array<float, 4>            m_Weight;                       // Add up to 1, 0 for the unused influences
         };
 
         struct lod
         {
             float                           m_ScreenArea;
+            float                           m_Error;                        // Simplification error in world units compared to LOD 0
+            std::uint64_t                   m_Fingerprint;                  // Stage cache key of the indices
             std::vector<std::uint32_t>      m_Indices;
         };
 
@@ -44,6 +59,7 @@ namespace xgeom_static_compiler
             std::vector<std::uint32_t>      m_Indices;                      // Actual LOD 0 (Original mesh)
             std::vector<lod>                m_LODs;                         // This is LOD 1..n (New computed LODS)
             std::uint32_t                   m_iMaterial;
+            std::uint64_t                   m_Fingerprint   { 0 };          // Hash of the content, root of the stage cache keys
             int                             m_nWeights      { 0 };
             int                             m_nUVs          { 0 };
             bool                            m_bHasColor     { false };
@@ -66,61 +82,197 @@ namespace xgeom_static_compiler
 
         //--------------------------------------------------------------------------------------
 
+        // ParallelFor for the compiler stages. ParallelFor is noexcept, so an exception (bad_alloc
+        // included) must not leave a job. The first failure is logged after the join and returned.
+
+        template< typename T_FUNCTION >
+        xerr ParallelJobs(std::size_t Count, T_FUNCTION&& Function) noexcept
+        {
+            std::mutex          Mutex;
+            std::array<char,256> Failure{};
+
+            auto SetFailure = [&](const char* pMessage) noexcept
+            {
+                std::scoped_lock Lock(Mutex);
+                if (Failure[0] == 0) std::strncpy(Failure.data(), pMessage, Failure.size() - 1);
+            };
+
+            xskeleton::ParallelFor(Count, [&](std::size_t i) noexcept
+            {
+                try
+                {
+                    Function(i);
+                }
+                catch (const std::exception& Error)
+                {
+                    SetFailure(Error.what());
+                }
+                catch (...)
+                {
+                    SetFailure("Unknown exception");
+                }
+            });
+
+            if (Failure[0] == 0) return {};
+
+            LogMessage(xresource_pipeline::msg_type::ERROR, std::format("{}", Failure.data()));
+            return xerr::create_f<state, "A compiler job failed">();
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        // The result of the import is cached in the resource log folder, keyed by the content of the
+        // source file, so a recompile with only descriptor changes does not need to run assimp again
+
         xerr LoadRaw( const std::wstring_view Path )
         {
             xraw3d::assimp_v2::importer Importer;
-            Importer.m_Settings.m_bAnimated = false;
+            Importer.m_Settings.m_bAnimated = true;     // Keep the bones and the weights
+
+            const auto          CachePath   = std::format(L"{}\\ImportCache.bin", m_ResourceLogPath);
+            import_cache::key   CacheKey;
+            const bool          bUseCache   = !import_cache::ComputeKey(CacheKey, std::wstring(Path), import_cache::ComputeSettingsHash(Importer, m_Descriptor.m_ImportAsset));
+
+            if ( bUseCache && !import_cache::Load(CachePath, CacheKey, m_RawGeom, m_RootNode) )
+                return {};
+
             if ( auto Err = Importer.Import(Path, m_RawGeom, m_RootNode); Err )
                 return xerr::create_f<state, "Failed to import the asset">(Err);
 
+            if ( bUseCache )
+            {
+                if ( auto Err = import_cache::Save(CachePath, CacheKey, m_RawGeom, m_RootNode); Err )
+                    LogMessage(xresource_pipeline::msg_type::WARNING, std::format("{}", Err.getMessage()));
+            }
+
             return {};
         }
 
         //--------------------------------------------------------------------------------------
 
-        void ConvertToCompilerMesh(void)
+        // Hashes everything the later stages read from a submesh. The fields are packed one by one
+        // because the math types may have padding that is not initialized.
+
+        static std::uint64_t ComputeFingerprint(const sub_mesh& S)
+        {
+            std::vector<float> Packed;
+            Packed.reserve(S.m_Vertex.size() * 28);
+            for (const auto& V : S.m_Vertex)
+            {
+                Packed.insert(Packed.end(), { V.m_Position.m_X, V.m_Position.m_Y, V.m_Position.m_Z });
+                for (int i = 0; i < S.m_nUVs; ++i) Packed.insert(Packed.end(), { V.m_UVs[i].m_X, V.m_UVs[i].m_Y });
+                Packed.push_back(std::bit_cast<float>(std::array{ V.m_Color.m_R, V.m_Color.m_G, V.m_Color.m_B, V.m_Color.m_A }));
+                Packed.insert(Packed.end(), { V.m_Normal.m_X,   V.m_Normal.m_Y,   V.m_Normal.m_Z   });
+                Packed.insert(Packed.end(), { V.m_Tangent.m_X,  V.m_Tangent.m_Y,  V.m_Tangent.m_Z  });
+                Packed.insert(Packed.end(), { V.m_Binormal.m_X, V.m_Binormal.m_Y, V.m_Binormal.m_Z });
+                Packed.insert(Packed.end(), { std::bit_cast<float>(std::array{ V.m_iBone[0], V.m_iBone[1] }), std::bit_cast<float>(std::array{ V.m_iBone[2], V.m_iBone[3] }) });
+                Packed.insert(Packed.end(), V.m_Weight.begin(), V.m_Weight.end());
+            }
+
+            stage_cache::fingerprint Fingerprint;
+            Fingerprint.Add(import_cache::details::Hash(std::as_bytes(std::span{ Packed })));
+            Fingerprint.Add(import_cache::details::Hash(std::as_bytes(std::span{ S.m_Indices })));
+            Fingerprint.Add(S.m_nUVs).Add(S.m_bHasColor).Add(S.m_bHasNormal).Add(S.m_bHasBTN);
+            return Fingerprint.m_Value;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        // Converts the raw geom into the compiler meshes. The faces are sorted by mesh, so a counting
+        // pre-pass finds the face range, the submeshes and the raw vertex range of every mesh, and
+        // then every mesh is filled in parallel with exact reservations. The raw to submesh vertex
+        // remap is a table sized to the vertex range of the mesh that is reset with a generation
+        // counter, so the cost follows the number of faces instead of meshes x vertices.
+
+        struct mesh_faces
+        {
+            std::uint32_t                   m_iFace             = 0;
+            std::uint32_t                   m_nFaces            = 0;
+            std::uint32_t                   m_MinVert           = std::numeric_limits<std::uint32_t>::max();
+            std::uint32_t                   m_MaxVert           = 0;
+            std::vector<std::uint32_t>      m_SubmeshMaterial   = {};           // Material of each submesh in order of appearance
+            std::vector<std::uint32_t>      m_SubmeshFaceCount  = {};
+        };
+
+        // Keeps the 4 largest influences of a raw vertex and renormalizes them. The vertices of a
+        // skinned geom without any weight follow the first root.
+
+        void SetWeights(vertex& V, const xraw3d::geom::vertex& RawVert) const noexcept
+        {
+            if (m_Skeleton.size() == 0) return;
+
+            auto        Weights     = RawVert.m_Weight;
+            const auto  nWeights    = std::clamp(RawVert.m_nWeights, 0, static_cast<int>(Weights.size()));
+            const auto  nKeep       = std::min(nWeights, static_cast<int>(V.m_Weight.size()));
+            std::partial_sort(Weights.begin(), Weights.begin() + nKeep, Weights.begin() + nWeights, [](const auto& A, const auto& B)
+            {
+                return A.m_Weight > B.m_Weight;
+            });
+
+            float Total = 0;
+            int   n     = 0;
+            for (int i = 0; i < nKeep; ++i)
+            {
+                const auto& W = Weights[i];
+                if (W.m_Weight <= 0 || W.m_iBone < 0 || W.m_iBone >= static_cast<int>(m_Skeleton.m_Remap.size())) continue;
+
+                V.m_iBone[n]  = static_cast<std::uint16_t>(m_Skeleton.m_Remap[W.m_iBone]);
+                V.m_Weight[n] = W.m_Weight;
+                Total        += W.m_Weight;
+                ++n;
+            }
+
+            if (n == 0)
+            {
+                V.m_iBone[0]  = 0;
+                V.m_Weight[0] = 1;
+                return;
+            }
+
+            for (int i = 0; i < n; ++i) V.m_Weight[i] /= Total;
+        }
+
+        xerr ConvertToCompilerMesh(void)
         {
+            // The vertex weights need the final order of the bones
+            m_Skeleton = skeleton_builder::Build(m_RawGeom.m_Bone);
+
             for( auto& Mesh : m_RawGeom.m_Mesh )
             {
                 auto& NewMesh = m_CompilerMesh.emplace_back();
                 NewMesh.m_Name = Mesh.m_Name;
             }
 
-            std::vector<std::int32_t> GeomToCompilerVertMesh( m_RawGeom.m_Facet.size() * 3          );
-            std::vector<std::int32_t> MaterialToSubmesh     ( m_RawGeom.m_MaterialInstance.size()   );
-
-            int MinVert     = 0;
-            int MaxVert     = int(GeomToCompilerVertMesh.size()-1);
-            int CurMaterial = -1;
-            int LastMesh    = -1;
-
-            for( auto& Face : m_RawGeom.m_Facet )
+            //
+            // Counting pre-pass
+            //
+            std::vector<mesh_faces>     MeshFaces           ( m_CompilerMesh.size() );
+            std::vector<std::uint32_t>  FaceToSubmesh       ( m_RawGeom.m_Facet.size() );
+            std::vector<std::int32_t>   MaterialStamp       ( m_RawGeom.m_MaterialInstance.size(), -1 );    // Mesh that last used the material
+            std::vector<std::uint32_t>  MaterialToSubmesh   ( m_RawGeom.m_MaterialInstance.size() );
+            int                         CurMaterial         = -1;
+            int                         LastMesh            = -1;
+
+            for( std::uint32_t iFace = 0; iFace < m_RawGeom.m_Facet.size(); ++iFace )
             {
-                auto& Mesh = m_CompilerMesh[Face.m_iMesh];
+                const auto& Face    = m_RawGeom.m_Facet[iFace];
+                auto&       Range   = MeshFaces[Face.m_iMesh];
 
                 // Make sure all faces are shorted by the mesh
                 assert(Face.m_iMesh >= LastMesh);
-                LastMesh = Face.m_iMesh;
-
-                // are we dealing with a new mesh? if so we need to reset the remap of the submesh
-                if( Mesh.m_SubMesh.size() == 0 )
+                if (Face.m_iMesh != LastMesh)
                 {
-                    for (auto& R : MaterialToSubmesh) R = -1;
+                    Range.m_iFace = iFace;
+                    LastMesh      = Face.m_iMesh;
                 }
 
-                // are we dealiong with a new submesh is so we need to reset the verts
-                if( MaterialToSubmesh[Face.m_iMaterialInstance] == -1 )
+                // are we dealing with a new submesh?
+                if( MaterialStamp[Face.m_iMaterialInstance] != Face.m_iMesh )
                 {
-                    MaterialToSubmesh[Face.m_iMaterialInstance] = int(Mesh.m_SubMesh.size());
-                    auto& Submesh = Mesh.m_SubMesh.emplace_back();
-
-                    Submesh.m_iMaterial = Face.m_iMaterialInstance;
-
-                    for (int i = MinVert; i <= MaxVert; ++i)
-                        GeomToCompilerVertMesh[i] = -1;
-
-                    MaxVert = 0;
-                    MinVert = int(GeomToCompilerVertMesh.size()-1);
+                    MaterialStamp[Face.m_iMaterialInstance]     = Face.m_iMesh;
+                    MaterialToSubmesh[Face.m_iMaterialInstance] = static_cast<std::uint32_t>(Range.m_SubmeshMaterial.size());
+                    Range.m_SubmeshMaterial.push_back(Face.m_iMaterialInstance);
+                    Range.m_SubmeshFaceCount.push_back(0);
                     CurMaterial = Face.m_iMaterialInstance;
                 }
                 else
@@ -129,91 +281,278 @@ namespace xgeom_static_compiler
                     assert(CurMaterial >= Face.m_iMaterialInstance );
                 }
 
-                auto& SubMesh = Mesh.m_SubMesh[MaterialToSubmesh[Face.m_iMaterialInstance]];
+                const auto iSubmesh = MaterialToSubmesh[Face.m_iMaterialInstance];
+                FaceToSubmesh[iFace] = iSubmesh;
+                Range.m_SubmeshFaceCount[iSubmesh]++;
+                Range.m_nFaces++;
 
                 for( int i=0; i<3; ++i )
                 {
-                    if( GeomToCompilerVertMesh[Face.m_iVertex[i]] == -1 )
+                    Range.m_MinVert = std::min( Range.m_MinVert, static_cast<std::uint32_t>(Face.m_iVertex[i]) );
+                    Range.m_MaxVert = std::max( Range.m_MaxVert, static_cast<std::uint32_t>(Face.m_iVertex[i]) );
+                }
+            }
+
+            //
+            // Fill every mesh in parallel
+            //
+            return ParallelJobs(m_CompilerMesh.size(), [&](std::size_t iMesh)
+            {
+                const auto& Range = MeshFaces[iMesh];
+                auto&       Mesh  = m_CompilerMesh[iMesh];
+
+                if (Range.m_nFaces == 0) return;
+
+                // Stable bucket of the faces by submesh
+                const auto                  nSubmeshes = Range.m_SubmeshMaterial.size();
+                std::vector<std::uint32_t>  SubmeshFaceStart(nSubmeshes + 1, 0);
+                std::vector<std::uint32_t>  SortedFaces(Range.m_nFaces);
+
+                for (std::size_t s = 0; s < nSubmeshes; ++s)
+                    SubmeshFaceStart[s + 1] = SubmeshFaceStart[s] + Range.m_SubmeshFaceCount[s];
+
+                {
+                    std::vector<std::uint32_t> Cursor(SubmeshFaceStart.begin(), SubmeshFaceStart.end() - 1);
+                    for (std::uint32_t iFace = Range.m_iFace; iFace < Range.m_iFace + Range.m_nFaces; ++iFace)
+                        SortedFaces[Cursor[FaceToSubmesh[iFace]]++] = iFace;
+                }
+
+                // Raw vertex -> submesh vertex, only valid when the stamp matches the current generation
+                const std::uint32_t         VertBase    = Range.m_MinVert;
+                std::vector<std::uint32_t>  VertStamp   ( Range.m_MaxVert - Range.m_MinVert + 1, 0 );
+                std::vector<std::uint32_t>  VertRemap   ( VertStamp.size() );
+                std::uint32_t               Generation  = 0;
+
+                Mesh.m_SubMesh.resize(nSubmeshes);
+                for (std::size_t s = 0; s < nSubmeshes; ++s)
+                {
+                    auto&       SubMesh     = Mesh.m_SubMesh[s];
+                    const auto  FaceBegin   = SubmeshFaceStart[s];
+                    const auto  FaceEnd     = SubmeshFaceStart[s + 1];
+
+                    SubMesh.m_iMaterial = Range.m_SubmeshMaterial[s];
+
+                    // Count the unique vertices so we can reserve exactly
+                    std::uint32_t nVerts = 0;
+                    ++Generation;
+                    for (auto f = FaceBegin; f < FaceEnd; ++f)
                     {
-                        GeomToCompilerVertMesh[Face.m_iVertex[i]] = int(SubMesh.m_Vertex.size());
-                        auto& CompilerVert = SubMesh.m_Vertex.emplace_back();
-                        auto& RawVert      = m_RawGeom.m_Vertex[Face.m_iVertex[i]];
-
-                        CompilerVert.m_Binormal = RawVert.m_BTN[0].m_Binormal;
-                        CompilerVert.m_Tangent  = RawVert.m_BTN[0].m_Tangent;
-                        CompilerVert.m_Normal   = RawVert.m_BTN[0].m_Normal;
-                        CompilerVert.m_Color    = RawVert.m_Color[0];               // This could be n in the future...
-                        CompilerVert.m_Position = RawVert.m_Position;
-                        
-                        if ( RawVert.m_nTangents ) SubMesh.m_bHasBTN    = true;
-                        if ( RawVert.m_nNormals  ) SubMesh.m_bHasNormal = true;
-                        if ( RawVert.m_nColors   ) SubMesh.m_bHasColor  = true;
-
-                        if( SubMesh.m_Indices.size() && SubMesh.m_nUVs != 0 && RawVert.m_nUVs < SubMesh.m_nUVs )
+                        for( int i=0; i<3; ++i )
                         {
-                            printf("WARNING: Found a vertex with an inconsistent set of uvs (Expecting %d, found %d) MeshName: %s \n"
-                            , SubMesh.m_nUVs
-                            , RawVert.m_nUVs
-                            , Mesh.m_Name.data()
-                            );
+                            const auto iLocal = m_RawGeom.m_Facet[SortedFaces[f]].m_iVertex[i] - VertBase;
+                            if (VertStamp[iLocal] != Generation)
+                            {
+                                VertStamp[iLocal] = Generation;
+                                nVerts++;
+                            }
                         }
-                        else
+                    }
+
+                    SubMesh.m_Vertex.reserve(nVerts);
+                    SubMesh.m_Indices.reserve((FaceEnd - FaceBegin) * 3);
+
+                    ++Generation;
+                    for (auto f = FaceBegin; f < FaceEnd; ++f)
+                    {
+                        const auto& Face = m_RawGeom.m_Facet[SortedFaces[f]];
+
+                        for( int i=0; i<3; ++i )
                         {
-                            SubMesh.m_nUVs = RawVert.m_nUVs;
+                            const auto iLocal = Face.m_iVertex[i] - VertBase;
+
+                            if( VertStamp[iLocal] != Generation )
+                            {
+                                VertStamp[iLocal] = Generation;
+                                VertRemap[iLocal] = static_cast<std::uint32_t>(SubMesh.m_Vertex.size());
+
+                                auto& CompilerVert = SubMesh.m_Vertex.emplace_back();
+                                auto& RawVert      = m_RawGeom.m_Vertex[Face.m_iVertex[i]];
+
+                                CompilerVert.m_Binormal = RawVert.m_BTN[0].m_Binormal;
+                                CompilerVert.m_Tangent  = RawVert.m_BTN[0].m_Tangent;
+                                CompilerVert.m_Normal   = RawVert.m_BTN[0].m_Normal;
+                                CompilerVert.m_Color    = RawVert.m_Color[0];               // This could be n in the future...
+                                CompilerVert.m_Position = RawVert.m_Position;
+                                SetWeights(CompilerVert, RawVert);
+
+                                if ( RawVert.m_nTangents ) SubMesh.m_bHasBTN    = true;
+                                if ( RawVert.m_nNormals  ) SubMesh.m_bHasNormal = true;
+                                if ( RawVert.m_nColors   ) SubMesh.m_bHasColor  = true;
+                                SubMesh.m_nWeights = std::max(SubMesh.m_nWeights, std::min(RawVert.m_nWeights, static_cast<int>(CompilerVert.m_Weight.size())));
+
+                                if( SubMesh.m_Indices.size() && SubMesh.m_nUVs != 0 && RawVert.m_nUVs < SubMesh.m_nUVs )
+                                {
+                                    printf("WARNING: Found a vertex with an inconsistent set of uvs (Expecting %d, found %d) MeshName: %s \n"
+                                    , SubMesh.m_nUVs
+                                    , RawVert.m_nUVs
+                                    , Mesh.m_Name.data()
+                                    );
+                                }
+                                else
+                                {
+                                    SubMesh.m_nUVs = RawVert.m_nUVs;
+
+                                    for (int j = 0; j < RawVert.m_nUVs; ++j)
+                                        CompilerVert.m_UVs[j] = RawVert.m_UV[j];
+                                }
+                            }
 
-                            for (int j = 0; j < RawVert.m_nUVs; ++j)
-                                CompilerVert.m_UVs[j] = RawVert.m_UV[j];
+                            assert( VertRemap[iLocal] < m_RawGeom.m_Vertex.size() );
+                            SubMesh.m_Indices.push_back(VertRemap[iLocal]);
                         }
                     }
 
-                    assert( GeomToCompilerVertMesh[Face.m_iVertex[i]] >= 0 );
-                    assert( GeomToCompilerVertMesh[Face.m_iVertex[i]] < m_RawGeom.m_Vertex.size() );
-                    SubMesh.m_Indices.push_back(GeomToCompilerVertMesh[Face.m_iVertex[i]]);
+                    SubMesh.m_Fingerprint = ComputeFingerprint(SubMesh);
+                }
+            });
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        // Builds the LOD chain of one submesh, every LOD simplifies the previous one. The key of each
+        // LOD chains the key of its source with its settings, so editing one LOD only recomputes it
+        // and the ones that follow.
+
+        static void SimplifySubmesh(sub_mesh& S, const std::vector<xgeom_static::lod>& LODs, stage_cache::store& Cache)
+        {
+            if (S.m_Vertex.empty()) return;
+
+            // Converts the relative errors that meshopt reports into world units
+            const float         ErrorScale  = meshopt_simplifyScale(&S.m_Vertex[0].m_Position.m_X, S.m_Vertex.size(), sizeof(vertex));
+            std::size_t         IndexCount  = S.m_Indices.size();
+            float               Error       = 0;
+
+            // The source of each LOD is the previous one, so make sure it does not move while we add LODs
+            S.m_LODs.reserve(S.m_LODs.size() + LODs.size());
+
+            for (const auto& L : LODs)
+            {
+                const std::size_t target_index_count      = std::size_t(IndexCount * L.m_LODReduction + 0.005f) / 3 * 3;
+                const float       target_error            = L.m_MaxError;
+                const auto&       Source                  = (S.m_LODs.size())? S.m_LODs.back().m_Indices : S.m_Indices;
+                const auto        Fingerprint             = stage_cache::fingerprint{}
+                                                            .Add((S.m_LODs.size())? S.m_LODs.back().m_Fingerprint : S.m_Fingerprint)
+                                                            .Add(L.m_LODReduction)
+                                                            .Add(L.m_MaxError).m_Value;
+
+                if( Source.size() < target_index_count )
+                    break;
+
+                auto&   NewLod      = S.m_LODs.emplace_back();
+                NewLod.m_Fingerprint = Fingerprint;
+
+                const bool bCached = Cache.Load("LOD", Fingerprint, [&](import_cache::details::reader& Reader)
+                {
+                    NewLod.m_Error = Reader.Read<float>();
+                    Reader.ReadVector(NewLod.m_Indices);
+                });
+
+                if (bCached)
+                {
+                    Error = NewLod.m_Error;
+                }
+                else
+                {
+                    float ResultError = 0;
+
+                    NewLod.m_Indices.resize(Source.size());
+                    NewLod.m_Indices.resize( meshopt_simplify( NewLod.m_Indices.data(), Source.data(), Source.size(), &S.m_Vertex[0].m_Position.m_X, S.m_Vertex.size(), sizeof(vertex), target_index_count, target_error, 0, &ResultError));
+
+                    // Each error is measured against the previous LOD so the sum bounds the error against LOD 0
+                    Error          += ResultError * ErrorScale;
+                    NewLod.m_Error  = Error;
 
-                    MinVert = std::min( MinVert, (int)Face.m_iVertex[i] );
-                    MaxVert = std::max( MaxVert, (int)Face.m_iVertex[i] );
+                    Cache.Save("LOD", Fingerprint, [&](import_cache::details::writer& Writer)
+                    {
+                        Writer.Write(NewLod.m_Error);
+                        Writer.WriteVector(NewLod.m_Indices);
+                    });
                 }
+
+                // Set the new count
+                IndexCount = NewLod.m_Indices.size();
             }
         }
 
         //--------------------------------------------------------------------------------------
 
-        void GenenateLODs()
+        xerr GenenateLODs()
         {
+            //
+            // Simplify every submesh in parallel
+            //
+            struct lod_job
+            {
+                sub_mesh*                               m_pSubMesh;
+                const std::vector<xgeom_static::lod>*   m_pLODs;
+                const std::string*                      m_pMeshName;
+            };
+
+            std::vector<lod_job> Jobs;
             for (auto& M : m_CompilerMesh)
             {
                 auto iDescMesh = m_Descriptor.findMesh( M.m_Name );
 
-                if (iDescMesh == -1)
+                if (iDescMesh == -1 || m_Descriptor.m_MeshList[iDescMesh].m_LODs.empty())
                     continue;
 
                 for (auto& S : M.m_SubMesh)
-                {
-                    if (m_Descriptor.m_MeshList[iDescMesh].m_LODs.size())
-                    {
-                        std::size_t IndexCount = S.m_Indices.size();
+                    Jobs.push_back({ &S, &m_Descriptor.m_MeshList[iDescMesh].m_LODs, &M.m_Name });
+            }
 
-                        for ( size_t i = 0; i < m_Descriptor.m_MeshList[iDescMesh].m_LODs.size(); ++i)
-                        {
-                            //const float       threshold               = std::powf(m_Descriptor.m_MeshList[iDescMesh].m_LODs[i].m_LODReduction, float(i));
-                            const std::size_t target_index_count      = std::size_t(IndexCount * m_Descriptor.m_MeshList[iDescMesh].m_LODs[i].m_LODReduction + 0.005f) / 3 * 3;
-                            const float       target_error            = 1e-2f;
-                            const auto&       Source                  = (S.m_LODs.size())? S.m_LODs.back().m_Indices : S.m_Indices;
+            if (auto Err = ParallelJobs(Jobs.size(), [&](std::size_t iJob)
+            {
+                auto&           Job = Jobs[iJob];
+                trace::scope    Scope(m_Trace, std::format("Simplify {}", *Job.m_pMeshName), "job");
+                Scope.setCounts(Job.m_pSubMesh->m_Indices.size() / 3, Job.m_pSubMesh->m_Vertex.size());
+
+                SimplifySubmesh(*Job.m_pSubMesh, *Job.m_pLODs, m_StageCache);
+            }); Err) return Err;
+
+            //
+            // All the submeshes of a mesh switch LOD together, so each level takes the worst error
+            // of its submeshes. The screen area is where that error becomes LODPixelError pixels
+            // (for a mesh whose bbox diagonal covers ScreenArea pixels).
+            //
+            for (auto& M : m_CompilerMesh)
+            {
+                auto iDescMesh = m_Descriptor.findMesh( M.m_Name );
 
-                            if( Source.size() < target_index_count )
-                                break;
+                if (iDescMesh == -1)
+                    continue;
+
+                const auto& DescLODs = m_Descriptor.m_MeshList[iDescMesh].m_LODs;
+                BBox3       MeshBBox;
+                std::size_t nLevels  = 0;
+                for (const auto& S : M.m_SubMesh)
+                {
+                    for (const auto& V : S.m_Vertex) MeshBBox.Update(V.m_Position);
+                    nLevels = std::max(nLevels, S.m_LODs.size());
+                }
 
-                            auto& NewLod = S.m_LODs.emplace_back();
+                const float MeshSize = nLevels ? (MeshBBox.m_MaxPos - MeshBBox.m_MinPos).Length() : 0.0f;
+                for (std::size_t iLevel = 0; iLevel < nLevels; ++iLevel)
+                {
+                    float Error = 0;
+                    for (const auto& S : M.m_SubMesh)
+                        if (iLevel < S.m_LODs.size()) Error = std::max(Error, S.m_LODs[iLevel].m_Error);
 
-                            NewLod.m_Indices.resize(Source.size());
-                            NewLod.m_Indices.resize( meshopt_simplify( NewLod.m_Indices.data(), Source.data(), Source.size(), &S.m_Vertex[0].m_Position.m_X, S.m_Vertex.size(), sizeof(vertex), target_index_count, target_error));
+                    float ScreenArea = DescLODs[iLevel].m_ScreenArea;
+                    if (m_Descriptor.m_bAutoLODScreenArea)
+                    {
+                        ScreenArea = (Error > 0) ? m_Descriptor.m_LODPixelError * MeshSize / Error : std::numeric_limits<float>::max();
+                    }
 
-                            // Set the new count
-                            IndexCount = NewLod.m_Indices.size();
-                        }
+                    for (auto& S : M.m_SubMesh)
+                    {
+                        if (iLevel >= S.m_LODs.size()) continue;
+                        S.m_LODs[iLevel].m_Error      = Error;
+                        S.m_LODs[iLevel].m_ScreenArea = ScreenArea;
                     }
                 }
             }
+
+            return {};
         }
 
 #if 0
@@ -735,185 +1074,486 @@ namespace xgeom_static_compiler
         };
 
         //--------------------------------------------------------------------------------------
-        // Cluster for recursive splitting (triangle ids)
+        // How the vertices of a cluster get quantized, derived from the bounds of the cluster
 
-        struct TriCluster
+        struct cluster_quantization
         {
-            std::vector<uint32_t> tri_ids;
+            xmath::fvec3    m_PosCenter;
+            xmath::fvec3    m_PosScale;
+            xmath::fvec2    m_UVMin;
+            xmath::fvec2    m_UVScale;
+
+            cluster_quantization(const BBox3& bb_pos, const BBox2& bb_uv) noexcept
+                : m_PosCenter   { (bb_pos.m_MinPos + bb_pos.m_MaxPos) * 0.5f }
+                , m_PosScale    { xmath::fvec3::Max((bb_pos.m_MaxPos - bb_pos.m_MinPos) * 0.5f, xmath::fvec3(1e-6f)) }
+                , m_UVMin       { bb_uv.m_MinUV }
+                , m_UVScale     { xmath::fvec2::Max(bb_uv.m_MaxUV - bb_uv.m_MinUV, xmath::fvec2(1e-6f)) }
+            {}
+
+            void Quantize(const vertex& v, float BinormalSign, geom::vertex& Static, geom::vertex_extras& Extras) const noexcept
+            {
+                const int sign_bit = (BinormalSign < 0.0f ? 1 : 0);
+
+                // Pos compression
+                const auto pos = ((v.m_Position - m_PosCenter) / m_PosScale + 1.0f) * 32767.5f - 32768.0f;
+                Static.m_XPos   = static_cast<int16_t>(std::round(pos.m_X));
+                Static.m_YPos   = static_cast<int16_t>(std::round(pos.m_Y));
+                Static.m_ZPos   = static_cast<int16_t>(std::round(pos.m_Z));
+                Static.m_Extra  = static_cast<uint16_t>(sign_bit);
+
+                // UV
+                const auto norm_uv = (v.m_UVs[0] - m_UVMin) / m_UVScale;
+                Extras.m_UV[0] = static_cast<uint16_t>(std::round(norm_uv.m_X * 65535.0f));
+                Extras.m_UV[1] = static_cast<uint16_t>(std::round(norm_uv.m_Y * 65535.0f));
+
+                // Oct normal/tangent (UNORM8)
+                const auto oct_n = oct_encode(v.m_Normal.NormalizeSafeCopy());
+                Extras.m_OctNormal[0] = static_cast<uint8_t>(std::round((oct_n.m_X * 0.5f + 0.5f) * 255.0f));
+                Extras.m_OctNormal[1] = static_cast<uint8_t>(std::round((oct_n.m_Y * 0.5f + 0.5f) * 255.0f));
+
+                const auto oct_t = oct_encode(v.m_Tangent.NormalizeSafeCopy());
+                Extras.m_OctTangent[0] = static_cast<uint8_t>(std::round((oct_t.m_X * 0.5f + 0.5f) * 255.0f));
+                Extras.m_OctTangent[1] = static_cast<uint8_t>(std::round((oct_t.m_Y * 0.5f + 0.5f) * 255.0f));
+            }
+
+            // The bounding sphere comes from the box and the normal cone is disabled, meshlets overwrite both
+            geom::cluster MakeCluster(const BBox3& bb_pos) const noexcept
+            {
+                const float     radius  = ((bb_pos.m_MaxPos - bb_pos.m_MinPos) * 0.5f).Length();
+                geom::cluster   cl;
+
+                cl.m_BBox                           = bb_pos.to_fbbox();
+                cl.m_PosScaleAndUScale.m_X          = m_PosScale.m_X;
+                cl.m_PosScaleAndUScale.m_Y          = m_PosScale.m_Y;
+                cl.m_PosScaleAndUScale.m_Z          = m_PosScale.m_Z;
+                cl.m_PosScaleAndUScale.m_W          = m_UVScale.m_X;
+                cl.m_PosTrasnlationAndVScale.m_X    = m_PosCenter.m_X;
+                cl.m_PosTrasnlationAndVScale.m_Y    = m_PosCenter.m_Y;
+                cl.m_PosTrasnlationAndVScale.m_Z    = m_PosCenter.m_Z;
+                cl.m_PosTrasnlationAndVScale.m_W    = m_UVScale.m_Y;
+                cl.m_UVTranslation.m_X              = m_UVMin.m_X;
+                cl.m_UVTranslation.m_Y              = m_UVMin.m_Y;
+                cl.m_BoundingSphere                 = { m_PosCenter.m_X, m_PosCenter.m_Y, m_PosCenter.m_Z, radius };
+                cl.m_NormalCone                     = { 0.0f, 0.0f, 0.0f, 1.0f };
+                cl.m_iBone                          = 0;
+                cl.m_nBones                         = 0;
+                return cl;
+            }
         };
 
         //--------------------------------------------------------------------------------------
-
-        static void RecurseClusterSplit
-        ( const std::vector<vertex>&        InputVerts
-        , const std::vector<uint32_t>&      InputIndices
-        , const TriCluster&                 c
-        , uint32_t                          MaxVerts
-        , const float                       MaxExtent
-        , const std::vector<float>&         BinormalSigns
-        , std::vector<geom::cluster>&       OutputClusters
-        , std::vector<geom::vertex>&        AllStaticVerts
-        , std::vector<geom::vertex_extras>& AllExtrasVerts
-        , std::vector<uint32_t>&            AllIndices
-        )
+        // State for splitting one submesh LOD into clusters. The triangles live in a table
+        // (ids, centroids and bounds) with two buffers: every split partitions a range from one
+        // buffer into the other and reduces the bounds of both halves on the way, like a BVH
+        // builder working on index ranges. The local vertex remap uses a flat generation-stamped table
+        // sized to the submesh, so all the scratch memory is allocated once per job instead of at
+        // every recursion level. The bones of a skinned submesh use the same kind of table sized to
+        // the skeleton, a leaf must not touch more bones than an 8 bit palette index can address.
+
+        struct cluster_context
         {
-            if (c.tri_ids.empty()) return;
-            BBox3 bb_pos;
-            BBox2 bb_uv;
-
-            for (uint32_t ti : c.tri_ids)
+            inline static constexpr uint32_t    max_bones_v = 256;          // geom::vertex_skin::m_iBone is 8 bits
+
+            const std::vector<vertex>&          m_InputVerts;
+            const std::vector<uint32_t>&        m_InputIndices;
+            const std::vector<float>&           m_BinormalSigns;
+            uint32_t                            m_MaxVerts;
+            float                               m_MaxExtent;
+            bool                                m_bMeshlets;
+            uint32_t                            m_MeshletMaxVerts;
+            uint32_t                            m_MeshletMaxTris;
+            float                               m_MeshletConeWeight;
+            uint32_t                            m_nBones;                   // Bones of the skeleton, 0 for a static geom
+
+            std::vector<geom::cluster>&         m_OutputClusters;
+            std::vector<geom::vertex>&          m_AllStaticVerts;
+            std::vector<geom::vertex_extras>&   m_AllExtrasVerts;
+            std::vector<geom::vertex_skin>&     m_AllSkinVerts;
+            std::vector<std::uint16_t>&         m_AllClusterBones;
+            std::vector<uint32_t>&              m_AllIndices;
+
+            tri_soa::triangles                  m_Tris              = {};   // Ping-pong partitioned by range
+            std::vector<uint32_t>               m_VertStamp         = {};   // Generation that last touched each submesh vertex
+            std::vector<uint32_t>               m_VertRemap         = {};   // Submesh vertex -> cluster local vertex
+            std::vector<uint32_t>               m_UsedVerts         = {};
+            std::vector<unsigned int>           m_LocalIndices      = {};
+            std::vector<float>                  m_LocalPositions    = {};
+            std::vector<unsigned int>           m_FetchRemap        = {};
+            std::vector<geom::vertex>           m_OriginalStatic    = {};
+            std::vector<geom::vertex_extras>    m_OriginalExtras    = {};
+            std::vector<meshopt_Meshlet>        m_Meshlets          = {};
+            std::vector<unsigned int>           m_MeshletVerts      = {};   // Meshlet vertex -> cluster local vertex
+            std::vector<unsigned char>          m_MeshletTris       = {};   // Meshlet local indices
+            std::vector<uint32_t>               m_BoneStamp         = {};   // Bone generation that last touched each skeleton bone
+            std::vector<uint32_t>               m_BoneRemap         = {};   // Skeleton bone -> cluster palette entry
+            std::vector<std::uint16_t>          m_UsedBones         = {};
+            std::vector<geom::vertex_skin>      m_OriginalSkin      = {};
+            uint32_t                            m_Generation        = 0;
+            uint32_t                            m_BoneGeneration    = 0;
+
+            bool isSkinned(void) const noexcept { return m_nBones != 0; }
+
+            void Initialize(void)
             {
-                for (int j = 0; j < 3; ++j)
+                const auto nTris     = static_cast<uint32_t>(m_InputIndices.size() / 3);
+                const auto nVerts    = m_InputVerts.size();
+                const auto nMaxLocal = std::min<std::size_t>(nVerts, m_MaxVerts + 3);
+
+                // Gather the triangles once from the AoS vertices, every split after this only
+                // touches the triangle table (see xskeleton_compiler_tri_soa.h)
+                m_Tris.resize(nTris);
+                for (uint32_t i = 0; i < nTris; ++i)
                 {
-                    uint32_t vi = InputIndices[ti * 3 + j];
-                    bb_pos.Update(InputVerts[vi].m_Position);
-                    bb_uv.Update(InputVerts[vi].m_UVs[0]);
+                    const vertex&       v0          = m_InputVerts[m_InputIndices[i * 3 + 0]];
+                    const vertex&       v1          = m_InputVerts[m_InputIndices[i * 3 + 1]];
+                    const vertex&       v2          = m_InputVerts[m_InputIndices[i * 3 + 2]];
+                    const xmath::fvec3  cent_pos    = (v0.m_Position + v1.m_Position + v2.m_Position) / 3.0f;
+                    const xmath::fvec2  cent_uv     = (v0.m_UVs[0] + v1.m_UVs[0] + v2.m_UVs[0]) / 3.0f;
+                    BBox3               bb_pos;
+                    BBox2               bb_uv;
+
+                    bb_pos.Update(v0.m_Position); bb_pos.Update(v1.m_Position); bb_pos.Update(v2.m_Position);
+                    bb_uv.Update(v0.m_UVs[0]);    bb_uv.Update(v1.m_UVs[0]);    bb_uv.Update(v2.m_UVs[0]);
+
+                    m_Tris.Set
+                    ( i
+                    , { cent_pos[0],        cent_pos[1],        cent_pos[2],        cent_uv[0],        cent_uv[1]        }
+                    , { bb_pos.m_MinPos[0], bb_pos.m_MinPos[1], bb_pos.m_MinPos[2], bb_uv.m_MinUV[0],  bb_uv.m_MinUV[1]  }
+                    , { bb_pos.m_MaxPos[0], bb_pos.m_MaxPos[1], bb_pos.m_MaxPos[2], bb_uv.m_MaxUV[0],  bb_uv.m_MaxUV[1]  }
+                    );
                 }
-            }
 
-            xmath::fvec3    extent_pos      = bb_pos.m_MaxPos - bb_pos.m_MinPos;
-            xmath::fvec2    extent_uv       = bb_uv.m_MaxUV - bb_uv.m_MinUV;
-            float           max_e_pos       = std::max({ extent_pos.m_X, extent_pos.m_Y, extent_pos.m_Z });
-            float           max_e_uv        = std::max(extent_uv.m_X, extent_uv.m_Y);
-            bool            small_extent    = (max_e_pos <= MaxExtent && max_e_uv <= MaxExtent);
+                m_VertStamp.assign(nVerts, 0);
+                m_VertRemap.resize(nVerts);
+                m_UsedVerts.reserve(nMaxLocal);
+                m_LocalIndices.reserve(m_InputIndices.size());
+                m_LocalPositions.reserve(nMaxLocal * 3);
+                m_FetchRemap.reserve(nMaxLocal);
+                m_OriginalStatic.reserve(nMaxLocal);
+                m_OriginalExtras.reserve(nMaxLocal);
 
-            std::unordered_set<uint32_t> used_verts;
-            if (small_extent)
-            {
-                for (uint32_t ti : c.tri_ids)
+                m_AllIndices.reserve(m_InputIndices.size());
+                m_AllStaticVerts.reserve(nVerts);
+                m_AllExtrasVerts.reserve(nVerts);
+
+                if (isSkinned())
                 {
-                    for (int j = 0; j < 3; ++j)
-                    {
-                        used_verts.insert(InputIndices[ti * 3 + j]);
-                    }
+                    m_BoneStamp.assign(m_nBones, 0);
+                    m_BoneRemap.resize(m_nBones);
+                    m_UsedBones.reserve(max_bones_v + 4);
+                    m_OriginalSkin.reserve(nMaxLocal);
+                    m_AllSkinVerts.reserve(nVerts);
                 }
             }
 
-            if (small_extent && used_verts.size() <= MaxVerts)
+            // Starts a new set of unique vertices
+            void NewGeneration(void) noexcept
             {
-                // Remap verts locally
-                std::vector<uint32_t> new_vert_ids(used_verts.begin(), used_verts.end());
-                std::sort(new_vert_ids.begin(), new_vert_ids.end());
-                std::unordered_map<uint32_t, uint32_t> old_to_new = {};
-                uint32_t new_id = 0;
-                for (uint32_t ov : new_vert_ids)
+                if (++m_Generation == 0)
                 {
-                    old_to_new[ov] = new_id++;
+                    std::ranges::fill(m_VertStamp, 0u);
+                    m_Generation = 1;
                 }
+                m_UsedVerts.clear();
+            }
 
-                // Use precomputed bboxes
-                xmath::fvec3 pos_min    = bb_pos.m_MinPos;
-                xmath::fvec3 pos_max    = bb_pos.m_MaxPos;
-                xmath::fvec3 pos_center = (pos_min + pos_max) * 0.5f;
-                xmath::fvec3 pos_scale  = xmath::fvec3::Max((pos_max - pos_min) * 0.5f, xmath::fvec3(1e-6f));
-                xmath::fvec2 uv_min     = bb_uv.m_MinUV;
-                xmath::fvec2 uv_max     = bb_uv.m_MaxUV;
-                xmath::fvec2 uv_scale   = xmath::fvec2::Max(uv_max - uv_min, xmath::fvec2(1e-6f));
+            // Starts a new set of unique bones
+            void NewBoneGeneration(void) noexcept
+            {
+                if (++m_BoneGeneration == 0)
+                {
+                    std::ranges::fill(m_BoneStamp, 0u);
+                    m_BoneGeneration = 1;
+                }
+                m_UsedBones.clear();
+            }
 
-                // Build local indices
-                std::vector<unsigned int> local_indices;
-                local_indices.reserve(c.tri_ids.size() * 3);
-                for (uint32_t ti : c.tri_ids)
+            // Adds the bones of a vertex to the current set
+            void AddBones(const vertex& v)
+            {
+                for (int i = 0; i < 4 && v.m_Weight[i] > 0; ++i)
                 {
-                    for (int j = 0; j < 3; ++j)
+                    if (m_BoneStamp[v.m_iBone[i]] != m_BoneGeneration)
                     {
-                        uint32_t ov = InputIndices[ti * 3 + j];
-                        local_indices.push_back(old_to_new[ov]);
+                        m_BoneStamp[v.m_iBone[i]] = m_BoneGeneration;
+                        m_UsedBones.push_back(v.m_iBone[i]);
                     }
                 }
+            }
 
-                // Optimize vertex cache
-                meshopt_optimizeVertexCache(local_indices.data(), local_indices.data(), local_indices.size(), static_cast<unsigned int>(new_vert_ids.size()));
+            // Influences relative to the palette in m_BoneRemap, the weights are rounded so they
+            // still add up to 255 (the remainders go to the largest fractions)
+            geom::vertex_skin QuantizeSkin(const vertex& v) const noexcept
+            {
+                geom::vertex_skin       Skin        = {};
+                std::array<float, 4>    Fraction    = {};
+                int                     Total       = 0;
+                for (int i = 0; i < 4 && v.m_Weight[i] > 0; ++i)
+                {
+                    const float W   = v.m_Weight[i] * 255.0f;
+                    Skin.m_iBone[i]  = static_cast<std::uint8_t>(m_BoneRemap[v.m_iBone[i]]);
+                    Skin.m_Weight[i] = static_cast<std::uint8_t>(std::min(W, 255.0f));
+                    Fraction[i]     = W - Skin.m_Weight[i];
+                    Total          += Skin.m_Weight[i];
+                }
 
-                // Prepare positions for overdraw optimization
-                std::vector<float> local_positions(new_vert_ids.size() * 3);
-                for (uint32_t i = 0; i < new_vert_ids.size(); ++i)
+                for (; Total < 255; ++Total)
                 {
-                    const auto& pos = InputVerts[new_vert_ids[i]].m_Position;
-                    local_positions[i * 3 + 0] = pos.m_X;
-                    local_positions[i * 3 + 1] = pos.m_Y;
-                    local_positions[i * 3 + 2] = pos.m_Z;
+                    const auto i = std::ranges::max_element(Fraction) - Fraction.begin();
+                    Skin.m_Weight[i]++;
+                    Fraction[i] = -1;
                 }
+                return Skin;
+            }
 
-                // Optimize overdraw
-                meshopt_optimizeOverdraw(local_indices.data(), local_indices.data(), local_indices.size(), local_positions.data(), static_cast<unsigned int>(new_vert_ids.size()), sizeof(float) * 3, 1.05f);
+            // Builds the bone palette of a cluster from its vertices (submesh vertex getId(i)),
+            // appends it to m_AllClusterBones and writes the skin of every vertex into pSkin
+            template< typename T_GET_ID >
+            void EmitSkin(geom::cluster& cl, const uint32_t nVerts, T_GET_ID&& getId, geom::vertex_skin* pSkin)
+            {
+                NewBoneGeneration();
+                for (uint32_t i = 0; i < nVerts; ++i)
+                    AddBones(m_InputVerts[getId(i)]);
 
-                // Generate fetch remap
-                std::vector<unsigned int> fetch_remap(new_vert_ids.size());
-                meshopt_optimizeVertexFetchRemap(fetch_remap.data(), local_indices.data(), local_indices.size(), static_cast<unsigned int>(new_vert_ids.size()));
+                std::ranges::sort(m_UsedBones);
+                for (uint32_t i = 0; i < m_UsedBones.size(); ++i)
+                    m_BoneRemap[m_UsedBones[i]] = i;
 
-                // Pack original compressed vertices and extras
-                std::vector<geom::vertex>           original_static(new_vert_ids.size());
-                std::vector<geom::vertex_extras>    original_extras(new_vert_ids.size());
-                for (uint32_t i = 0; i < new_vert_ids.size(); ++i)
-                {
-                    const uint32_t  ov          = new_vert_ids[i];
-                    const vertex&   v           = InputVerts[ov];
-                    const float     sign_val    = BinormalSigns[ov];
-                    const int       sign_bit    = (sign_val < 0.0f ? 1 : 0);
+                cl.m_iBone  = static_cast<uint32_t>(m_AllClusterBones.size());
+                cl.m_nBones = static_cast<uint32_t>(m_UsedBones.size());
+                m_AllClusterBones.insert(m_AllClusterBones.end(), m_UsedBones.begin(), m_UsedBones.end());
 
-                    // Pos compression
-                    const auto pos = ((v.m_Position - pos_center) / pos_scale + 1.0f) * 32767.5f - 32768.0f;
-                    original_static[i].m_XPos   = static_cast<int16_t>(std::round(pos.m_X));
-                    original_static[i].m_YPos   = static_cast<int16_t>(std::round(pos.m_Y));
-                    original_static[i].m_ZPos   = static_cast<int16_t>(std::round(pos.m_Z));
-                    original_static[i].m_Extra  = static_cast<uint16_t>(sign_bit);
+                for (uint32_t i = 0; i < nVerts; ++i)
+                    pSkin[i] = QuantizeSkin(m_InputVerts[getId(i)]);
+            }
+        };
 
-                    // UV
-                    const auto norm_uv = (v.m_UVs[0] - uv_min) / uv_scale;
-                    original_extras[i].m_UV[0] = static_cast<uint16_t>(std::round(norm_uv.m_X * 65535.0f));
-                    original_extras[i].m_UV[1] = static_cast<uint16_t>(std::round(norm_uv.m_Y * 65535.0f));
+        //--------------------------------------------------------------------------------------
+        // Splits the current leaf (its local indices and positions are ready in the context) into
+        // fixed budget meshlets. Every meshlet is emitted as its own cluster with its own
+        // quantization, bounding sphere and normal cone.
 
-                    // Oct normal/tangent (UNORM8)
-                    const auto oct_n = oct_encode(v.m_Normal.NormalizeSafeCopy());
-                    original_extras[i].m_OctNormal[0] = static_cast<uint8_t>(std::round((oct_n.m_X * 0.5f + 0.5f) * 255.0f));
-                    original_extras[i].m_OctNormal[1] = static_cast<uint8_t>(std::round((oct_n.m_Y * 0.5f + 0.5f) * 255.0f));
+        static void EmitMeshlets(cluster_context& C, const uint32_t nLocalVerts)
+        {
+            const auto& new_vert_ids    = C.m_UsedVerts;
+            const auto& local_indices   = C.m_LocalIndices;
+            const auto& local_positions = C.m_LocalPositions;
+            const auto  max_meshlets    = meshopt_buildMeshletsBound(local_indices.size(), C.m_MeshletMaxVerts, C.m_MeshletMaxTris);
+
+            C.m_Meshlets.resize(max_meshlets);
+            C.m_MeshletVerts.resize(max_meshlets * C.m_MeshletMaxVerts);
+            C.m_MeshletTris.resize(max_meshlets * C.m_MeshletMaxTris * 3);
+
+            const auto nMeshlets = meshopt_buildMeshlets
+            ( C.m_Meshlets.data(), C.m_MeshletVerts.data(), C.m_MeshletTris.data()
+            , local_indices.data(), local_indices.size()
+            , local_positions.data(), nLocalVerts, sizeof(float) * 3
+            , C.m_MeshletMaxVerts, C.m_MeshletMaxTris, C.m_MeshletConeWeight
+            );
+
+            for (std::size_t m = 0; m < nMeshlets; ++m)
+            {
+                const meshopt_Meshlet&  meshlet = C.m_Meshlets[m];
+                unsigned int*           pVerts  = &C.m_MeshletVerts[meshlet.vertex_offset];
+                unsigned char*          pTris   = &C.m_MeshletTris[meshlet.triangle_offset];
 
-                    const auto oct_t = oct_encode(v.m_Tangent.NormalizeSafeCopy());
-                    original_extras[i].m_OctTangent[0] = static_cast<uint8_t>(std::round((oct_t.m_X * 0.5f + 0.5f) * 255.0f));
-                    original_extras[i].m_OctTangent[1] = static_cast<uint8_t>(std::round((oct_t.m_Y * 0.5f + 0.5f) * 255.0f));
+                // Better vertex locality inside the meshlet
+                meshopt_optimizeMeshlet(pVerts, pTris, meshlet.triangle_count, meshlet.vertex_count);
+
+                const meshopt_Bounds bounds = meshopt_computeMeshletBounds(pVerts, pTris, meshlet.triangle_count, local_positions.data(), nLocalVerts, sizeof(float) * 3);
+
+                BBox3 bb_pos;
+                BBox2 bb_uv;
+                for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+                {
+                    const vertex& v = C.m_InputVerts[new_vert_ids[pVerts[i]]];
+                    bb_pos.Update(v.m_Position);
+                    bb_uv.Update(v.m_UVs[0]);
                 }
 
-                // Remap vertices and extras
-                std::vector<geom::vertex> remapped_static(new_vert_ids.size());
-                meshopt_remapVertexBuffer(remapped_static.data(), original_static.data(), new_vert_ids.size(), sizeof(geom::vertex), fetch_remap.data());
+                // The meshlet vertices are already in fetch order
+                const cluster_quantization  Quantization(bb_pos, bb_uv);
+                const uint32_t              cluster_vert_start = static_cast<uint32_t>(C.m_AllStaticVerts.size());
+                C.m_AllStaticVerts.resize(cluster_vert_start + meshlet.vertex_count);
+                C.m_AllExtrasVerts.resize(cluster_vert_start + meshlet.vertex_count);
+                for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+                {
+                    const uint32_t ov = new_vert_ids[pVerts[i]];
+                    Quantization.Quantize(C.m_InputVerts[ov], C.m_BinormalSigns[ov], C.m_AllStaticVerts[cluster_vert_start + i], C.m_AllExtrasVerts[cluster_vert_start + i]);
+                }
 
-                std::vector<geom::vertex_extras> remapped_extras(new_vert_ids.size());
-                meshopt_remapVertexBuffer(remapped_extras.data(), original_extras.data(), new_vert_ids.size(), sizeof(geom::vertex_extras), fetch_remap.data());
+                const uint32_t cluster_index_start = static_cast<uint32_t>(C.m_AllIndices.size());
+                C.m_AllIndices.insert(C.m_AllIndices.end(), pTris, pTris + meshlet.triangle_count * 3);
 
-                // Remap indices
-                meshopt_remapIndexBuffer(local_indices.data(), local_indices.data(), local_indices.size(), fetch_remap.data());
+                geom::cluster cl = Quantization.MakeCluster(bb_pos);
+                cl.m_BoundingSphere = { bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius };
+                cl.m_NormalCone     = { bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff };
+                cl.m_iIndex         = cluster_index_start;
+                cl.m_nIndices       = meshlet.triangle_count * 3;
+                cl.m_iVertex        = cluster_vert_start;
+                cl.m_nVertices      = meshlet.vertex_count;
 
-                // Append verts to global
-                uint32_t cluster_vert_start = static_cast<uint32_t>(AllStaticVerts.size());
-                AllStaticVerts.insert(AllStaticVerts.end(), remapped_static.begin(), remapped_static.end());
-                AllExtrasVerts.insert(AllExtrasVerts.end(), remapped_extras.begin(), remapped_extras.end());
+                // The meshlet is a piece of a leaf, so its palette fits too
+                if (C.isSkinned())
+                {
+                    C.m_AllSkinVerts.resize(cluster_vert_start + meshlet.vertex_count);
+                    C.EmitSkin(cl, meshlet.vertex_count, [&](uint32_t i) { return new_vert_ids[pVerts[i]]; }, C.m_AllSkinVerts.data() + cluster_vert_start);
+                }
 
-                // Append indices to global
-                uint32_t cluster_index_start = static_cast<uint32_t>(AllIndices.size());
-                for (auto idx : local_indices)
+                C.m_OutputClusters.push_back(cl);
+            }
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        // iBuffer is the buffer of the SoA table that holds the range, Bounds its triangle bounds
+
+        static void RecurseClusterSplit(cluster_context& C, const int iBuffer, const uint32_t Begin, const uint32_t End, const tri_soa::bounds& Bounds)
+        {
+            if (Begin == End) return;
+
+            const auto& InputVerts   = C.m_InputVerts;
+            const auto& InputIndices = C.m_InputIndices;
+            const auto* pTriIds      = C.m_Tris.m_Buffer[iBuffer].m_Id;
+            BBox3       bb_pos;
+            BBox2       bb_uv;
+
+            bb_pos.m_MinPos = xmath::fvec3(Bounds.m_Min[0], Bounds.m_Min[1], Bounds.m_Min[2]);
+            bb_pos.m_MaxPos = xmath::fvec3(Bounds.m_Max[0], Bounds.m_Max[1], Bounds.m_Max[2]);
+            bb_uv.m_MinUV   = xmath::fvec2(Bounds.m_Min[3], Bounds.m_Min[4]);
+            bb_uv.m_MaxUV   = xmath::fvec2(Bounds.m_Max[3], Bounds.m_Max[4]);
+
+            xmath::fvec3    extent_pos      = bb_pos.m_MaxPos - bb_pos.m_MinPos;
+            xmath::fvec2    extent_uv       = bb_uv.m_MaxUV - bb_uv.m_MinUV;
+            float           max_e_pos       = std::max({ extent_pos.m_X, extent_pos.m_Y, extent_pos.m_Z });
+            float           max_e_uv        = std::max(extent_uv.m_X, extent_uv.m_Y);
+            bool            small_extent    = (max_e_pos <= C.m_MaxExtent && max_e_uv <= C.m_MaxExtent);
+            bool            fits_verts      = false;
+
+            // A single triangle can not be split any further, it becomes a cluster with a coarser quantization
+            if (End - Begin == 1) small_extent = true;
+
+            if (small_extent)
+            {
+                // Collect the unique vertices (and bones), we can stop as soon as we know it does not fit
+                C.NewGeneration();
+                C.NewBoneGeneration();
+                fits_verts = true;
+                for (uint32_t t = Begin; t < End && fits_verts; ++t)
                 {
-                    AllIndices.push_back(idx);
+                    const uint32_t ti = pTriIds[t];
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        const uint32_t vi = InputIndices[ti * 3 + j];
+                        if (C.m_VertStamp[vi] != C.m_Generation)
+                        {
+                            C.m_VertStamp[vi] = C.m_Generation;
+                            C.m_UsedVerts.push_back(vi);
+                            if (C.isSkinned()) C.AddBones(InputVerts[vi]);
+                        }
+                    }
+
+                    fits_verts = C.m_UsedVerts.size() <= C.m_MaxVerts && C.m_UsedBones.size() <= C.max_bones_v;
+                }
+            }
+
+            if (small_extent && fits_verts)
+            {
+                // Remap verts locally
+                auto& new_vert_ids = C.m_UsedVerts;
+                std::sort(new_vert_ids.begin(), new_vert_ids.end());
+                for (uint32_t i = 0; i < new_vert_ids.size(); ++i)
+                {
+                    C.m_VertRemap[new_vert_ids[i]] = i;
+                }
+
+                const auto nLocalVerts = static_cast<uint32_t>(new_vert_ids.size());
+
+                // Build local indices
+                auto& local_indices = C.m_LocalIndices;
+                local_indices.clear();
+                for (uint32_t t = Begin; t < End; ++t)
+                {
+                    const uint32_t ti = pTriIds[t];
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        local_indices.push_back(C.m_VertRemap[InputIndices[ti * 3 + j]]);
+                    }
+                }
+
+                // Optimize vertex cache
+                meshopt_optimizeVertexCache(local_indices.data(), local_indices.data(), local_indices.size(), nLocalVerts);
+
+                // Prepare positions for overdraw optimization
+                auto& local_positions = C.m_LocalPositions;
+                local_positions.resize(nLocalVerts * 3);
+                for (uint32_t i = 0; i < nLocalVerts; ++i)
+                {
+                    const auto& pos = InputVerts[new_vert_ids[i]].m_Position;
+                    local_positions[i * 3 + 0] = pos.m_X;
+                    local_positions[i * 3 + 1] = pos.m_Y;
+                    local_positions[i * 3 + 2] = pos.m_Z;
                 }
 
+                if (C.m_bMeshlets)
+                {
+                    EmitMeshlets(C, nLocalVerts);
+                    return;
+                }
+
+                // Optimize overdraw
+                meshopt_optimizeOverdraw(local_indices.data(), local_indices.data(), local_indices.size(), local_positions.data(), nLocalVerts, sizeof(float) * 3, 1.05f);
+
+                // Generate fetch remap
+                auto& fetch_remap = C.m_FetchRemap;
+                fetch_remap.resize(nLocalVerts);
+                meshopt_optimizeVertexFetchRemap(fetch_remap.data(), local_indices.data(), local_indices.size(), nLocalVerts);
+
+                // Pack original compressed vertices and extras, using the precomputed bboxes
+                const cluster_quantization Quantization(bb_pos, bb_uv);
+                auto& original_static = C.m_OriginalStatic;
+                auto& original_extras = C.m_OriginalExtras;
+                original_static.resize(nLocalVerts);
+                original_extras.resize(nLocalVerts);
+                for (uint32_t i = 0; i < nLocalVerts; ++i)
+                {
+                    const uint32_t ov = new_vert_ids[i];
+                    Quantization.Quantize(InputVerts[ov], C.m_BinormalSigns[ov], original_static[i], original_extras[i]);
+                }
+
+                // Remap vertices and extras straight into the output
+                uint32_t cluster_vert_start = static_cast<uint32_t>(C.m_AllStaticVerts.size());
+                C.m_AllStaticVerts.resize(cluster_vert_start + nLocalVerts);
+                C.m_AllExtrasVerts.resize(cluster_vert_start + nLocalVerts);
+                meshopt_remapVertexBuffer(C.m_AllStaticVerts.data() + cluster_vert_start, original_static.data(), nLocalVerts, sizeof(geom::vertex), fetch_remap.data());
+                meshopt_remapVertexBuffer(C.m_AllExtrasVerts.data() + cluster_vert_start, original_extras.data(), nLocalVerts, sizeof(geom::vertex_extras), fetch_remap.data());
+
+                // Remap indices
+                meshopt_remapIndexBuffer(local_indices.data(), local_indices.data(), local_indices.size(), fetch_remap.data());
+
+                // Append indices to global
+                uint32_t cluster_index_start = static_cast<uint32_t>(C.m_AllIndices.size());
+                C.m_AllIndices.insert(C.m_AllIndices.end(), local_indices.begin(), local_indices.end());
+
                 // Create cluster
-                geom::cluster cl;
-                cl.m_BBox                           = bb_pos.to_fbbox();
-                cl.m_PosScaleAndUScale.m_X          = pos_scale.m_X;
-                cl.m_PosScaleAndUScale.m_Y          = pos_scale.m_Y;
-                cl.m_PosScaleAndUScale.m_Z          = pos_scale.m_Z;
-                cl.m_PosScaleAndUScale.m_W          = uv_scale.m_X;
-                cl.m_PosTrasnlationAndVScale.m_X    = pos_center.m_X;
-                cl.m_PosTrasnlationAndVScale.m_Y    = pos_center.m_Y;
-                cl.m_PosTrasnlationAndVScale.m_Z    = pos_center.m_Z;
-                cl.m_PosTrasnlationAndVScale.m_W    = uv_scale.m_Y;
-                cl.m_UVTranslation.m_X              = uv_min.m_X;
-                cl.m_UVTranslation.m_Y              = uv_min.m_Y;
+                geom::cluster cl = Quantization.MakeCluster(bb_pos);
                 cl.m_iIndex                         = cluster_index_start;
-                cl.m_nIndices                       = static_cast<uint32_t>(c.tri_ids.size() * 3);
+                cl.m_nIndices                       = (End - Begin) * 3;
                 cl.m_iVertex                        = cluster_vert_start;
-                cl.m_nVertices                      = static_cast<uint32_t>(new_vert_ids.size());
-                OutputClusters.push_back(cl);
+                cl.m_nVertices                      = nLocalVerts;
+
+                // Skins follow the same fetch order as the vertices
+                if (C.isSkinned())
+                {
+                    auto& original_skin = C.m_OriginalSkin;
+                    original_skin.resize(nLocalVerts);
+                    C.EmitSkin(cl, nLocalVerts, [&](uint32_t i) { return new_vert_ids[i]; }, original_skin.data());
+
+                    C.m_AllSkinVerts.resize(cluster_vert_start + nLocalVerts);
+                    meshopt_remapVertexBuffer(C.m_AllSkinVerts.data() + cluster_vert_start, original_skin.data(), nLocalVerts, sizeof(geom::vertex_skin), fetch_remap.data());
+                }
+
+                C.m_OutputClusters.push_back(cl);
             }
             else
             {
@@ -942,37 +1582,67 @@ namespace xgeom_static_compiler
                     split_pos = (bb_uv.m_MinUV[sub_axis] + bb_uv.m_MaxUV[sub_axis]) * 0.5f;
                 }
 
-                TriCluster c1, c2;
-                for (uint32_t ti : c.tri_ids)
+                // Stable partition of the SoA streams into the other buffer, centroids are laid out as XYZ followed by UV
+                tri_soa::bounds LeftBounds, RightBounds;
+                const int       iNext   = 1 - iBuffer;
+                const uint32_t  nLeft   = tri_soa::Partition(C.m_Tris, iBuffer, Begin, End, axis, split_pos, LeftBounds, RightBounds);
+                const uint32_t  nRight  = (End - Begin) - nLeft;
+
+                // Degenerated split (every centroid on one side), halve the range so we always make progress
+                uint32_t Middle = Begin + nLeft;
+                if (nLeft == 0 || nRight == 0)
                 {
-                    uint32_t i0 = InputIndices[ti * 3 + 0];
-                    uint32_t i1 = InputIndices[ti * 3 + 1];
-                    uint32_t i2 = InputIndices[ti * 3 + 2];
-                    float   cent;
+                    Middle      = Begin + (End - Begin) / 2;
+                    LeftBounds  = tri_soa::ComputeBounds(C.m_Tris, iNext, Begin, Middle);
+                    RightBounds = tri_soa::ComputeBounds(C.m_Tris, iNext, Middle, End);
+                }
 
-                    if (is_pos_axis)
-                    {
-                        xmath::fvec3 cent_pos = (InputVerts[i0].m_Position + InputVerts[i1].m_Position + InputVerts[i2].m_Position) / 3.0f;
-                        cent = cent_pos[sub_axis];
-                    }
-                    else
-                    {
-                        xmath::fvec2 cent_uv = (InputVerts[i0].m_UVs[0] + InputVerts[i1].m_UVs[0] + InputVerts[i2].m_UVs[0]) / 3.0f;
-                        cent = cent_uv[sub_axis];
-                    }
+                RecurseClusterSplit(C, iNext, Begin, Middle, LeftBounds);
+                RecurseClusterSplit(C, iNext, Middle, End, RightBounds);
+            }
+        }
 
-                    if (cent < split_pos)   c1.tri_ids.push_back(ti);
-                    else                    c2.tri_ids.push_back(ti);
-                }
+        //--------------------------------------------------------------------------------------
+        // One unit of clustering work: a single submesh at a single LOD. Every job writes into
+        // its own buffers (offsets relative to the job) so jobs can run on any worker, and
+        // ConvertToGeom stitches them back in job order. The buffers of a job are stage cached
+        // under the key of its indices plus the clustering settings.
 
-                RecurseClusterSplit(InputVerts, InputIndices, c1, MaxVerts, MaxExtent, BinormalSigns, OutputClusters, AllStaticVerts, AllExtrasVerts, AllIndices);
-                RecurseClusterSplit(InputVerts, InputIndices, c2, MaxVerts, MaxExtent, BinormalSigns, OutputClusters, AllStaticVerts, AllExtrasVerts, AllIndices);
+        struct cluster_job
+        {
+            const sub_mesh*                     m_pSubMesh          = nullptr;
+            const std::vector<uint32_t>*        m_pIndices          = nullptr;
+            const std::vector<float>*           m_pBinormalSigns    = nullptr;
+            std::uint64_t                       m_Fingerprint       = 0;
+            std::vector<geom::cluster>          m_Clusters          = {};
+            std::vector<geom::vertex>           m_StaticVerts       = {};
+            std::vector<geom::vertex_extras>    m_ExtrasVerts       = {};
+            std::vector<geom::vertex_skin>      m_SkinVerts         = {};   // Empty for a static geom
+            std::vector<std::uint16_t>          m_ClusterBones      = {};
+            std::vector<uint32_t>               m_Indices           = {};
+        };
+
+        //--------------------------------------------------------------------------------------
+
+        static std::vector<float> ComputeBinormalSigns(const sub_mesh& SubMesh)
+        {
+            auto binormal_signs = std::vector<float>(SubMesh.m_Vertex.size(), 1.0f);
+            if (SubMesh.m_bHasBTN)
+            {
+                for (size_t i = 0; i < SubMesh.m_Vertex.size(); ++i)
+                {
+                    const vertex&   v                   = SubMesh.m_Vertex[i];
+                    xmath::fvec3    computed_binormal   = xmath::fvec3::Cross(v.m_Normal, v.m_Tangent);
+                    float           dot_val             = xmath::fvec3::Dot(computed_binormal, v.m_Binormal);
+                    binormal_signs[i] = (dot_val >= 0.0f) ? 1.0f : -1.0f;
+                }
             }
+            return binormal_signs;
         }
 
         //--------------------------------------------------------------------------------------
 
-        void ConvertToGeom(float target_precision)
+        xerr ConvertToGeom(float target_precision)
         {
             const std::vector<mesh>&            compiler_meshes = m_CompilerMesh;
             geom&                               result          = m_FinalGeom;
@@ -982,13 +1652,36 @@ namespace xgeom_static_compiler
             std::vector<geom::cluster>          OutClusters;
             std::vector<geom::vertex>           OutAllStaticVerts;
             std::vector<geom::vertex_extras>    OutAllExtrasVerts;
+            std::vector<geom::vertex_skin>      OutAllSkinVerts;
+            std::vector<std::uint16_t>          OutClusterBones;
             std::vector<uint32_t>               OutAllIndices;
             BBox3                               OutGlobalBBox;
+            std::vector<cluster_job>            ClusterJobs;
+            std::vector<const sub_mesh*>        SignSubmeshes;
+            std::vector<std::vector<float>>     BinormalSigns;
             std::uint16_t                       current_lod_idx         = 0;
             std::uint16_t                       current_submesh_idx     = 0;
-            std::uint16_t                       current_cluster_idx     = 0;
+            std::uint32_t                       current_cluster_idx     = 0;
             float                               max_extent              = target_precision * 65535.0f;
+            const bool                          bSkinned                = m_Skeleton.size() != 0;
 
+            //
+            // The binormal signs only depend on the submesh vertices so all the LODs share them
+            //
+            for (const auto& input_mesh : compiler_meshes)
+                for (const auto& input_sm : input_mesh.m_SubMesh)
+                    SignSubmeshes.push_back(&input_sm);
+
+            BinormalSigns.resize(SignSubmeshes.size());
+            if (auto Err = ParallelJobs(SignSubmeshes.size(), [&](std::size_t i)
+            {
+                BinormalSigns[i] = ComputeBinormalSigns(*SignSubmeshes[i]);
+            }); Err) return Err;
+
+            //
+            // Build all the tables and collect one clustering job per (mesh, LOD, submesh)
+            //
+            std::size_t iSignSubmesh = 0;
             for (const auto& input_mesh : compiler_meshes)
             {
                 BBox3       mesh_bb         = {};
@@ -1041,9 +1734,10 @@ namespace xgeom_static_compiler
                 for (size_t lod_level = 0; lod_level < out_m.m_nLODs; ++lod_level)
                 {
                     geom::lod out_l;
-                    out_l.m_ScreenArea  = (lod_level == 0) ? 1.0f : (input_mesh.m_SubMesh.empty() ? 0.0f : input_mesh.m_SubMesh[0].m_LODs[lod_level - 1].m_ScreenArea);
-                    out_l.m_iSubmesh    = current_submesh_idx;
-                    out_l.m_nSubmesh    = static_cast<uint16_t>(input_mesh.m_SubMesh.size());
+                    out_l.m_ScreenArea      = (lod_level == 0) ? 1.0f : (input_mesh.m_SubMesh.empty() ? 0.0f : input_mesh.m_SubMesh[0].m_LODs[lod_level - 1].m_ScreenArea);
+                    out_l.m_GeometricError  = (lod_level == 0) ? 0.0f : (input_mesh.m_SubMesh.empty() ? 0.0f : input_mesh.m_SubMesh[0].m_LODs[lod_level - 1].m_Error);
+                    out_l.m_iSubmesh        = current_submesh_idx;
+                    out_l.m_nSubmesh        = static_cast<uint16_t>(input_mesh.m_SubMesh.size());
                     OutLODs.push_back(out_l);
 
                     current_submesh_idx += out_l.m_nSubmesh;
@@ -1051,61 +1745,251 @@ namespace xgeom_static_compiler
                     {
                         geom::submesh out_sm;
                         out_sm.m_iMaterial  = static_cast<uint16_t>(input_sm.m_iMaterial);
-                        out_sm.m_iCluster   = current_cluster_idx;
+                        out_sm.m_iCluster   = 0;
+                        out_sm.m_nCluster   = 0;
+                        OutSubmeshes.push_back(out_sm);
 
-                        const std::vector<uint32_t>&  lod_indices     = (lod_level == 0) ? input_sm.m_Indices : ((lod_level - 1 < input_sm.m_LODs.size()) ? input_sm.m_LODs[lod_level - 1].m_Indices : input_sm.m_Indices);
-                        auto                          binormal_signs  = std::vector<float>(input_sm.m_Vertex.size(), 1.0f);
-                        for (size_t i = 0; i < input_sm.m_Vertex.size(); ++i)
-                        {
-                            const vertex& v = input_sm.m_Vertex[i];
-                            if (input_sm.m_bHasBTN)
-                            {
-                                xmath::fvec3    computed_binormal   = xmath::fvec3::Cross(v.m_Normal, v.m_Tangent);
-                                float           dot_val             = xmath::fvec3::Dot(computed_binormal, v.m_Binormal);
-                                binormal_signs[i] = (dot_val >= 0.0f) ? 1.0f : -1.0f;
-                            }
-                        }
-                        TriCluster  initial  = {};
-                        uint32_t    num_tris = static_cast<uint32_t>(lod_indices.size() / 3);
+                        const bool  bLOD    = lod_level > 0 && lod_level - 1 < input_sm.m_LODs.size();
+                        auto&       Job     = ClusterJobs.emplace_back();
+                        Job.m_pSubMesh          = &input_sm;
+                        Job.m_pIndices          = bLOD ? &input_sm.m_LODs[lod_level - 1].m_Indices : &input_sm.m_Indices;
+                        Job.m_pBinormalSigns    = &BinormalSigns[iSignSubmesh + static_cast<std::size_t>(&input_sm - input_mesh.m_SubMesh.data())];
+                        Job.m_Fingerprint       = stage_cache::fingerprint{}
+                                                  .Add(bLOD ? input_sm.m_LODs[lod_level - 1].m_Fingerprint : input_sm.m_Fingerprint)
+                                                  .Add(max_extent)
+                                                  .Add(m_Descriptor.m_Meshlets.m_bEnable)
+                                                  .Add(m_Descriptor.m_Meshlets.m_MaxVertices)
+                                                  .Add(m_Descriptor.m_Meshlets.m_MaxTriangles)
+                                                  .Add(m_Descriptor.m_Meshlets.m_ConeWeight)
+                                                  .Add(m_Skeleton.size())
+                                                  .Add(std::array{ sizeof(geom::cluster), sizeof(geom::vertex), sizeof(geom::vertex_extras), sizeof(geom::vertex_skin) }).m_Value;
+                    }
+                }
 
-                        initial.tri_ids.resize(num_tris);
-                        for (uint32_t i = 0; i < num_tris; ++i) initial.tri_ids[i] = i;
+                iSignSubmesh += input_mesh.m_SubMesh.size();
+            }
 
-                        size_t prev_num_clusters = OutClusters.size();
-                        RecurseClusterSplit(input_sm.m_Vertex, lod_indices, initial, 65534, max_extent, binormal_signs, OutClusters, OutAllStaticVerts, OutAllExtrasVerts, OutAllIndices);
+            //
+            // Cluster every (mesh, LOD, submesh) in parallel
+            //
+            if (auto Err = ParallelJobs(ClusterJobs.size(), [&](std::size_t iJob)
+            {
+                auto&           Job = ClusterJobs[iJob];
+                trace::scope    Scope(m_Trace, std::format("Cluster job {}", iJob), "job");
+                Scope.setCounts(Job.m_pIndices->size() / 3, Job.m_pSubMesh->m_Vertex.size());
 
-                        out_sm.m_nCluster    = static_cast<uint16_t>(OutClusters.size() - prev_num_clusters);
-                        current_cluster_idx += out_sm.m_nCluster;
-                        OutSubmeshes.push_back(out_sm);
+                const bool bCached = m_StageCache.Load("CLUSTER", Job.m_Fingerprint, [&](import_cache::details::reader& Reader)
+                {
+                    Reader.ReadVector(Job.m_Clusters);
+                    Reader.ReadVector(Job.m_StaticVerts);
+                    Reader.ReadVector(Job.m_ExtrasVerts);
+                    Reader.ReadVector(Job.m_SkinVerts);
+                    Reader.ReadVector(Job.m_ClusterBones);
+                    Reader.ReadVector(Job.m_Indices);
+                });
+                if (bCached) return;
+
+                // A read that failed half way may have filled some of the outputs
+                Job.m_Clusters.clear();
+                Job.m_StaticVerts.clear();
+                Job.m_ExtrasVerts.clear();
+                Job.m_SkinVerts.clear();
+                Job.m_ClusterBones.clear();
+                Job.m_Indices.clear();
+
+                cluster_context Context
+                { .m_InputVerts     = Job.m_pSubMesh->m_Vertex
+                , .m_InputIndices   = *Job.m_pIndices
+                , .m_BinormalSigns  = *Job.m_pBinormalSigns
+                , .m_MaxVerts       = 65534
+                , .m_MaxExtent      = max_extent
+                , .m_bMeshlets          = m_Descriptor.m_Meshlets.m_bEnable
+                , .m_MeshletMaxVerts    = static_cast<uint32_t>(m_Descriptor.m_Meshlets.m_MaxVertices)
+                , .m_MeshletMaxTris     = static_cast<uint32_t>(m_Descriptor.m_Meshlets.m_MaxTriangles)
+                , .m_MeshletConeWeight  = m_Descriptor.m_Meshlets.m_ConeWeight
+                , .m_nBones             = static_cast<uint32_t>(m_Skeleton.size())
+                , .m_OutputClusters     = Job.m_Clusters
+                , .m_AllStaticVerts     = Job.m_StaticVerts
+                , .m_AllExtrasVerts     = Job.m_ExtrasVerts
+                , .m_AllSkinVerts       = Job.m_SkinVerts
+                , .m_AllClusterBones    = Job.m_ClusterBones
+                , .m_AllIndices         = Job.m_Indices
+                };
+
+                Context.Initialize();
+
+                const auto nTris = static_cast<uint32_t>(Context.m_Tris.size());
+                RecurseClusterSplit(Context, 0, 0, nTris, tri_soa::ComputeBounds(Context.m_Tris, 0, 0, nTris));
+
+                m_StageCache.Save("CLUSTER", Job.m_Fingerprint, [&](import_cache::details::writer& Writer)
+                {
+                    Writer.WriteVector(Job.m_Clusters);
+                    Writer.WriteVector(Job.m_StaticVerts);
+                    Writer.WriteVector(Job.m_ExtrasVerts);
+                    Writer.WriteVector(Job.m_SkinVerts);
+                    Writer.WriteVector(Job.m_ClusterBones);
+                    Writer.WriteVector(Job.m_Indices);
+                });
+            }); Err) return Err;
+
+            //
+            // Stitch the jobs back in order, offsetting them by the prefix sum of the previous jobs
+            //
+            auto align = [](std::size_t offset, std::size_t alignment) constexpr -> std::size_t
+            {
+                return (offset + alignment - 1) & ~(alignment - 1);
+            };
+
+            // The jobs of a LOD are consecutive, so every LOD becomes a page: a contiguous range of
+            // vertices, extras and indices that starts on a cache line and can be streamed alone
+            constexpr std::size_t page_align_v = 64;
+            static_assert(page_align_v % sizeof(geom::vertex) == 0 && page_align_v % sizeof(geom::vertex_extras) == 0 && page_align_v % sizeof(geom::vertex_skin) == 0 && page_align_v % sizeof(std::uint16_t) == 0);
+
+            {
+                std::size_t TotalClusters = 0, TotalVerts = OutLODs.size() * page_align_v / sizeof(geom::vertex), TotalIndices = OutLODs.size() * page_align_v / sizeof(std::uint16_t), TotalBones = 0;
+                for (const auto& Job : ClusterJobs)
+                {
+                    TotalClusters += Job.m_Clusters.size();
+                    TotalVerts    += Job.m_StaticVerts.size();
+                    TotalIndices  += Job.m_Indices.size();
+                    TotalBones    += Job.m_ClusterBones.size();
+                }
+
+                OutClusters.reserve(TotalClusters);
+                OutAllStaticVerts.reserve(TotalVerts);
+                OutAllExtrasVerts.reserve(TotalVerts);
+                OutAllIndices.reserve(TotalIndices);
+                OutClusterBones.reserve(TotalBones);
+                if (bSkinned) OutAllSkinVerts.reserve(TotalVerts);
+            }
+
+            for (auto& out_l : OutLODs)
+            {
+                OutAllStaticVerts.resize(align(OutAllStaticVerts.size(), page_align_v / sizeof(geom::vertex)), geom::vertex{});
+                OutAllExtrasVerts.resize(OutAllStaticVerts.size(), geom::vertex_extras{});
+                if (bSkinned) OutAllSkinVerts.resize(OutAllStaticVerts.size(), geom::vertex_skin{});
+                OutAllIndices.resize(align(OutAllIndices.size(), page_align_v / sizeof(std::uint16_t)), 0u);
+
+                out_l.m_iVertex = static_cast<uint32_t>(OutAllStaticVerts.size());
+                out_l.m_iIndex  = static_cast<uint32_t>(OutAllIndices.size());
+
+                for (std::size_t iJob = out_l.m_iSubmesh; iJob < std::size_t(out_l.m_iSubmesh) + out_l.m_nSubmesh; ++iJob)
+                {
+                    auto&          Job          = ClusterJobs[iJob];
+                    auto&          out_sm       = OutSubmeshes[iJob];
+                    const uint32_t vertex_base  = static_cast<uint32_t>(OutAllStaticVerts.size());
+                    const uint32_t index_base   = static_cast<uint32_t>(OutAllIndices.size());
+                    const uint32_t bone_base    = static_cast<uint32_t>(OutClusterBones.size());
+
+                    for (auto& cl : Job.m_Clusters)
+                    {
+                        cl.m_iVertex += vertex_base;
+                        cl.m_iIndex  += index_base;
+                        cl.m_iBone   += bone_base;
                     }
+
+                    out_sm.m_iCluster    = current_cluster_idx;
+                    out_sm.m_nCluster    = static_cast<uint32_t>(Job.m_Clusters.size());
+                    current_cluster_idx += out_sm.m_nCluster;
+
+                    OutClusters.insert(OutClusters.end(), Job.m_Clusters.begin(), Job.m_Clusters.end());
+                    OutAllStaticVerts.insert(OutAllStaticVerts.end(), Job.m_StaticVerts.begin(), Job.m_StaticVerts.end());
+                    OutAllExtrasVerts.insert(OutAllExtrasVerts.end(), Job.m_ExtrasVerts.begin(), Job.m_ExtrasVerts.end());
+                    OutAllSkinVerts.insert(OutAllSkinVerts.end(), Job.m_SkinVerts.begin(), Job.m_SkinVerts.end());
+                    OutClusterBones.insert(OutClusterBones.end(), Job.m_ClusterBones.begin(), Job.m_ClusterBones.end());
+                    OutAllIndices.insert(OutAllIndices.end(), Job.m_Indices.begin(), Job.m_Indices.end());
+
+                    // Release the job memory as soon as it has been copied
+                    Job = {};
                 }
+
+                out_l.m_nVertices = static_cast<uint32_t>(OutAllStaticVerts.size()) - out_l.m_iVertex;
+                out_l.m_nIndices  = static_cast<uint32_t>(OutAllIndices.size())     - out_l.m_iIndex;
             }
-            result.m_nMeshes    = static_cast<std::uint16_t>(OutMeshes.size());
-            result.m_pMesh      = new geom::mesh[result.m_nMeshes];
-            std::ranges::copy(OutMeshes, result.m_pMesh);
-            result.m_nLODs      = static_cast<std::uint16_t>(OutLODs.size());
-            result.m_pLOD       = new geom::lod[result.m_nLODs];
-            std::ranges::copy(OutLODs, result.m_pLOD);
-            result.m_nSubMeshs  = static_cast<std::uint16_t>(OutSubmeshes.size());
-            result.m_pSubMesh   = new geom::submesh[result.m_nSubMeshs];
-            std::ranges::copy(OutSubmeshes, result.m_pSubMesh);
-            result.m_nClusters  = static_cast<std::uint16_t>(OutClusters.size());
-            result.m_pCluster   = new geom::cluster[result.m_nClusters];
-            std::ranges::copy(OutClusters, result.m_pCluster);
-            result.m_BBox       = OutGlobalBBox.to_fbbox();
-            result.m_nVertices  = static_cast<std::uint32_t>(OutAllStaticVerts.size());
-            result.m_nIndices   = static_cast<std::uint32_t>(OutAllIndices.size());
 
             //
-            // Set all the material instances
+            // Optionally replace the indices by the per cluster meshopt streams
             //
-            result.m_nDefaultMaterialInstances = static_cast<std::uint16_t>(m_RawGeom.m_MaterialInstance.size());
-            result.m_pDefaultMaterialInstances = new xrsc::material_instance_ref[result.m_nDefaultMaterialInstances];
+            std::vector<std::byte> EncodedIndices;
+            if (m_Descriptor.m_bEncodeIndices)
+            {
+                trace::scope Scope(m_Trace, "Encode indices");
+                EncodedIndices = xgeom_static::index_codec::Encode(std::span<const geom::cluster>(OutClusters), std::span<const std::uint32_t>(OutAllIndices));
+                Scope.setCounts(OutAllIndices.size() / 3, 0);
+            }
 
-            // Set default values
-            std::memset(result.m_pDefaultMaterialInstances, 0, result.m_nDefaultMaterialInstances * sizeof(*result.m_pDefaultMaterialInstances));
+            //
+            // Optionally replace the vertex streams by chunked meshopt streams, each one on its own
+            //
+            std::vector<std::byte> EncodedVertices;
+            std::vector<std::byte> EncodedVertexExtras;
+            if (m_Descriptor.m_bEncodeVertices || m_Descriptor.m_bEncodeVertexExtras)
+            {
+                trace::scope Scope(m_Trace, "Encode vertices");
+                if (m_Descriptor.m_bEncodeVertices)     EncodedVertices     = xgeom_static::vertex_codec::Encode(std::span<const geom::vertex>(OutAllStaticVerts));
+                if (m_Descriptor.m_bEncodeVertexExtras) EncodedVertexExtras = xgeom_static::vertex_codec::Encode(std::span<const geom::vertex_extras>(OutAllExtrasVerts));
+                Scope.setCounts(0, OutAllStaticVerts.size());
+            }
 
-            // Set all the materials that we know about
+            //
+            // Compute aligned sizes for GPU data
+            //
+            constexpr std::size_t   vulkan_align        = 64; // Min for Vulkan buffers/UBO
+            const std::size_t       VertexSize          = m_Descriptor.m_bEncodeVertices     ? EncodedVertices.size()     : OutAllStaticVerts.size() * sizeof(geom::vertex);
+            const std::size_t       ExtrasSize          = m_Descriptor.m_bEncodeVertexExtras ? EncodedVertexExtras.size() : OutAllExtrasVerts.size() * sizeof(geom::vertex_extras);
+            const std::size_t       IndicesSize         = m_Descriptor.m_bEncodeIndices ? EncodedIndices.size() : OutAllIndices.size() * sizeof(std::uint16_t);
+            const std::size_t       SkinSize            = OutAllSkinVerts.size() * sizeof(geom::vertex_skin);
+            std::size_t             current_offset      = 0;
+
+            const std::size_t       VertexOffset        = align(current_offset, vulkan_align); current_offset = align(current_offset + VertexSize, vulkan_align);
+            const std::size_t       VertexExtrasOffset  = current_offset; current_offset = align(current_offset + ExtrasSize, vulkan_align);
+            const std::size_t       IndicesOffset       = current_offset; current_offset = align(current_offset + IndicesSize, vulkan_align);
+            const std::size_t       VertexSkinOffset    = current_offset; current_offset = align(current_offset + SkinSize,    vulkan_align);
+
+            //
+            // Constant time lookups of the meshes by name and of the submeshes by material
+            //
+            const auto Lookup = mesh_lookup::Build(OutMeshes, OutLODs, OutSubmeshes, m_RawGeom.m_MaterialInstance.size());
+
+            //
+            // All the tables and the data go into a single arena
+            //
+            xgeom_static::blob::AllocateArena
+            ( result
+            , static_cast<std::uint16_t>(OutMeshes.size())
+            , static_cast<std::uint16_t>(OutLODs.size())
+            , static_cast<std::uint16_t>(OutSubmeshes.size())
+            , static_cast<std::uint32_t>(OutClusters.size())
+            , static_cast<std::uint16_t>(m_RawGeom.m_MaterialInstance.size())
+            , static_cast<std::uint32_t>(Lookup.m_Lookup.size())
+            , static_cast<std::uint16_t>(m_Skeleton.size())
+            , static_cast<std::uint32_t>(OutClusterBones.size())
+            , current_offset
+            );
+
+            std::ranges::copy(OutMeshes,    result.m_pMesh);
+            std::ranges::copy(OutLODs,      result.m_pLOD);
+            std::ranges::copy(OutSubmeshes, result.m_pSubMesh);
+            std::ranges::copy(OutClusters,  result.m_pCluster);
+            std::ranges::copy(Lookup.m_Lookup, result.m_pLookup);
+            std::ranges::copy(OutClusterBones, result.m_pClusterBone);
+            skeleton_builder::Copy(m_Skeleton, result.m_Skeleton);
+            result.m_nMeshHashBuckets   = Lookup.m_nBuckets;
+            result.m_nMeshHashSlots     = Lookup.m_nSlots;
+            result.m_BBox               = OutGlobalBBox.to_fbbox();
+            result.m_nVertices          = static_cast<std::uint32_t>(OutAllStaticVerts.size());
+            result.m_nIndices           = static_cast<std::uint32_t>(OutAllIndices.size());
+            result.m_VertexOffset       = VertexOffset;
+            result.m_VertexExtrasOffset = VertexExtrasOffset;
+            result.m_IndicesOffset      = IndicesOffset;
+            result.m_VertexSkinOffset   = VertexSkinOffset;
+            result.m_IndexEncoding          = m_Descriptor.m_bEncodeIndices      ? geom::index_encoding::MESHOPT  : geom::index_encoding::RAW;
+            result.m_VertexEncoding         = m_Descriptor.m_bEncodeVertices     ? geom::vertex_encoding::MESHOPT : geom::vertex_encoding::RAW;
+            result.m_VertexExtrasEncoding   = m_Descriptor.m_bEncodeVertexExtras ? geom::vertex_encoding::MESHOPT : geom::vertex_encoding::RAW;
+
+            //
+            // Set all the material instances (the arena starts zeroed, which is the default)
+            //
             for (auto& E : m_RawGeom.m_MaterialInstance)
             {
                 const auto Index = static_cast<int>(&E - m_RawGeom.m_MaterialInstance.data());
@@ -1116,38 +2000,70 @@ namespace xgeom_static_compiler
             //
             // Build the final data
             //
-            // Compute aligned sizes for GPU data
-            auto align = [](std::size_t offset, std::size_t alignment) constexpr -> std::size_t
-            {
-                return (offset + alignment - 1) & ~(alignment - 1);
-            };
-
-            constexpr std::size_t   vulkan_align    = 64; // Min for Vulkan buffers/UBO
-            const std::size_t       VertexSize      = OutAllStaticVerts.size() * sizeof(geom::vertex);
-            const std::size_t       ExtrasSize      = OutAllExtrasVerts.size() * sizeof(geom::vertex_extras);
-            const std::size_t       IndicesSize     = OutAllIndices.size() * sizeof(std::uint16_t);
-            std::size_t             current_offset  = 0;
-
-            result.m_VertexOffset           = align(current_offset, vulkan_align); current_offset = align(current_offset + VertexSize, vulkan_align);
-            result.m_VertexExtrasOffset     = current_offset; current_offset = align(current_offset + ExtrasSize, vulkan_align);
-            result.m_IndicesOffset          = current_offset; current_offset = align(current_offset + IndicesSize, vulkan_align);
-            result.m_DataSize               = current_offset;
-            result.m_pData                  = new char[result.m_DataSize];
-
             // Copy data into m_pData
-            std::memcpy(result.m_pData + result.m_VertexOffset,         OutAllStaticVerts.data(), VertexSize);
-            std::memcpy(result.m_pData + result.m_VertexExtrasOffset,   OutAllExtrasVerts.data(), ExtrasSize);
+            std::memcpy(result.m_pData + result.m_VertexOffset,         m_Descriptor.m_bEncodeVertices     ? static_cast<const void*>(EncodedVertices.data())     : OutAllStaticVerts.data(), VertexSize);
+            std::memcpy(result.m_pData + result.m_VertexExtrasOffset,   m_Descriptor.m_bEncodeVertexExtras ? static_cast<const void*>(EncodedVertexExtras.data()) : OutAllExtrasVerts.data(), ExtrasSize);
 
             // Copy the indices
-            auto pIndex = reinterpret_cast<std::uint16_t*>(result.m_pData + result.m_IndicesOffset);
-            for (size_t i = 0; i < OutAllIndices.size(); ++i)
+            if (m_Descriptor.m_bEncodeIndices)
             {
-                assert(OutAllIndices[i] < 0xffff);
-                pIndex[i] = static_cast<std::uint16_t>(OutAllIndices[i]);
+                std::memcpy(result.m_pData + result.m_IndicesOffset, EncodedIndices.data(), IndicesSize);
+            }
+            else
+            {
+                auto pIndex = reinterpret_cast<std::uint16_t*>(result.m_pData + result.m_IndicesOffset);
+                for (size_t i = 0; i < OutAllIndices.size(); ++i)
+                {
+                    assert(OutAllIndices[i] < 0xffff);
+                    pIndex[i] = static_cast<std::uint16_t>(OutAllIndices[i]);
+                }
             }
 
+            // The skins are always raw
+            if (SkinSize) std::memcpy(result.m_pData + result.m_VertexSkinOffset, OutAllSkinVerts.data(), SkinSize);
+
             // Make sure that at least we have one cluster
             assert(result.m_nClusters >= 1);
+
+            //
+            // Decode the encoded streams back with the runtime decoders, which checks them and
+            // gives the numbers of the codec report
+            //
+            m_CodecReport.Clear();
+            if (m_Descriptor.m_bEncodeVertices)
+            {
+                std::vector<geom::vertex> Decoded(result.m_nVertices);
+                bool                      bOK = false;
+                m_CodecReport.Add("Vertices", Decoded.size(), OutAllStaticVerts.size() * sizeof(geom::vertex), EncodedVertices.size()
+                    , [&]{ bOK = xgeom_static::vertex_codec::DecodeVertices(result, Decoded); });
+
+                if (!bOK || std::memcmp(Decoded.data(), OutAllStaticVerts.data(), Decoded.size() * sizeof(geom::vertex)))
+                    return xerr::create_f<state, "The encoded vertices do not decode back to the source">();
+            }
+
+            if (m_Descriptor.m_bEncodeVertexExtras)
+            {
+                std::vector<geom::vertex_extras> Decoded(result.m_nVertices);
+                bool                             bOK = false;
+                m_CodecReport.Add("VertexExtras", Decoded.size(), OutAllExtrasVerts.size() * sizeof(geom::vertex_extras), EncodedVertexExtras.size()
+                    , [&]{ bOK = xgeom_static::vertex_codec::DecodeVertexExtras(result, Decoded); });
+
+                if (!bOK || std::memcmp(Decoded.data(), OutAllExtrasVerts.data(), Decoded.size() * sizeof(geom::vertex_extras)))
+                    return xerr::create_f<state, "The encoded vertex extras do not decode back to the source">();
+            }
+
+            if (m_Descriptor.m_bEncodeIndices)
+            {
+                std::vector<std::uint16_t> Decoded(result.m_nIndices);
+                bool                       bOK = false;
+                m_CodecReport.Add("Indices", Decoded.size(), OutAllIndices.size() * sizeof(std::uint16_t), EncodedIndices.size()
+                    , [&]{ bOK = xgeom_static::index_codec::Decode(result, Decoded); });
+
+                if (!bOK || !xgeom_static::index_codec::isSameTriangles(std::span<const geom::cluster>(OutClusters), std::span<const std::uint16_t>(Decoded), std::span<const std::uint32_t>(OutAllIndices)))
+                    return xerr::create_f<state, "The encoded indices do not decode back to the source">();
+            }
+
+            return {};
         }
 
 
@@ -1234,6 +2150,16 @@ namespace xgeom_static_compiler
                 Facet.m_iMesh = RemapMeshes[Facet.m_iMesh];
             }
 
+            //
+            // All the meshes share the skeleton, the merged mesh uses as many bones as the largest one it takes
+            //
+            int nMergedBones = 0;
+            for (const auto& E : m_RawGeom.m_Mesh)
+            {
+                if (RemapMeshes[static_cast<int>(&E - m_RawGeom.m_Mesh.data())] == iMergedMesh)
+                    nMergedBones = std::max(nMergedBones, E.m_nBones);
+            }
+
             //
             // Remove all meshes that have been merged
             //
@@ -1258,7 +2184,27 @@ namespace xgeom_static_compiler
             m_Descriptor.m_MeshList.emplace_back(std::move(TempMergeMesh));
             m_RawGeom.m_Mesh.resize(iMergedMesh + 1);
             m_RawGeom.m_Mesh[iMergedMesh].m_Name    = xgeom_static::merged_mesh_name_v;
-            m_RawGeom.m_Mesh[iMergedMesh].m_nBones  = 0;
+            m_RawGeom.m_Mesh[iMergedMesh].m_nBones  = nMergedBones;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        std::size_t CountTriangles(void) const noexcept
+        {
+            std::size_t Count = 0;
+            for (const auto& M : m_CompilerMesh)
+                for (const auto& S : M.m_SubMesh) Count += S.m_Indices.size() / 3;
+            return Count;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        std::size_t CountVertices(void) const noexcept
+        {
+            std::size_t Count = 0;
+            for (const auto& M : m_CompilerMesh)
+                for (const auto& S : M.m_SubMesh) Count += S.m_Vertex.size();
+            return Count;
         }
 
         //--------------------------------------------------------------------------------------
@@ -1269,6 +2215,7 @@ namespace xgeom_static_compiler
             {
                 if (m_Descriptor.m_bMergeMeshes) 
                 {
+                    trace::scope Scope(m_Trace, "Merging Meshes");
                     displayProgressBar("Merging Meshes", 1);
                     MergeMeshes();
                     displayProgressBar("Merging Meshes", 0);
@@ -1279,6 +2226,8 @@ namespace xgeom_static_compiler
                     || m_Descriptor.m_PreTranslation.m_Translation != xmath::fvec3::fromZero()
                     || m_Descriptor.m_PreTranslation.m_Rotation    != xmath::fvec3::fromZero() )
                 {
+                    trace::scope Scope(m_Trace, "PreTranslatingMeshes");
+                    Scope.setCounts(m_RawGeom.m_Facet.size(), m_RawGeom.m_Vertex.size());
                     displayProgressBar("PreTranslatingMeshes", 0);
 
                     xmath::radian3 Rot;
@@ -1306,9 +2255,20 @@ namespace xgeom_static_compiler
                 //
                 m_FinalGeom.Initialize();
 
+                // The LODs and the clusters are memoized per submesh, so only what changed is recomputed
+                m_StageCache.Initialize(m_ResourceLogPath.empty() ? std::wstring{} : std::format(L"{}\\StageCache", m_ResourceLogPath));
+
                 displayProgressBar("Generating LODs", 1);
-                ConvertToCompilerMesh();
-                GenenateLODs();
+                {
+                    trace::scope Scope(m_Trace, "ConvertToCompilerMesh");
+                    if (auto Err = ConvertToCompilerMesh(); Err) return Err;
+                    Scope.setCounts(CountTriangles(), CountVertices());
+                }
+                {
+                    trace::scope Scope(m_Trace, "Generating LODs");
+                    Scope.setCounts(CountTriangles(), CountVertices());
+                    if (auto Err = GenenateLODs(); Err) return Err;
+                }
                 displayProgressBar("Generating LODs", 0);
 
                 //
@@ -1317,15 +2277,26 @@ namespace xgeom_static_compiler
                 displayProgressBar("Generating Final Mesh", 0);
 
                 // mm accuracy
-                ConvertToGeom(0.001f);
+                {
+                    trace::scope Scope(m_Trace, "Generating Final Mesh");
+                    if (auto Err = ConvertToGeom(0.001f); Err) return Err;
+                    Scope.setCounts(m_FinalGeom.m_nIndices / 3, m_FinalGeom.m_nVertices);
+                }
+
+                // Only keep the entries of this compile
+                m_StageCache.Prune();
                 
                 displayProgressBar("Generating Final Mesh", 1);
             }
-            catch (std::runtime_error Error )
+            catch (const std::exception& Error)
             {
                 LogMessage(xresource_pipeline::msg_type::ERROR, std::format("{}", Error.what()));
                 return xerr::create_f<state, "Exception thrown">();
             }
+            catch (...)
+            {
+                return xerr::create_f<state, "Unknown exception thrown">();
+            }
 
             return {};
         }
@@ -1421,12 +2392,44 @@ namespace xgeom_static_compiler
         //--------------------------------------------------------------------------------------
 
         xerr onCompile(void) noexcept override
+        {
+            m_Trace.Begin();
+
+            // Nothing may leave a noexcept onCompile, what the stages do not turn into an error is caught here
+            xerr Err;
+            try
+            {
+                Err = CompileStages();
+            }
+            catch (const std::exception& Error)
+            {
+                LogMessage(xresource_pipeline::msg_type::ERROR, std::format("{}", Error.what()));
+                Err = xerr::create_f<state, "Exception thrown">();
+            }
+            catch (...)
+            {
+                Err = xerr::create_f<state, "Unknown exception thrown">();
+            }
+
+            //
+            // Save the timing trace next to the details, a failed compile keeps the trace of the stages it got to
+            //
+            if (m_Trace.Save(std::format(L"{}\\Trace.json", m_ResourceLogPath)) == false)
+                LogMessage(xresource_pipeline::msg_type::WARNING, std::format("Failed to write the timing trace Trace.json"));
+
+            return Err;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        xerr CompileStages(void)
         {
             //
             // Read the descriptor file...
             //
             displayProgressBar("Loading Descriptor", 0);
             {
+                trace::scope                    Scope(m_Trace, "Loading Descriptor");
                 xproperty::settings::context    Context{};
                 auto                            DescriptorFileName = std::format(L"{}/{}/Descriptor.txt", m_ProjectPaths.m_Project, m_InputSrcDescriptorPath);
 
@@ -1454,8 +2457,12 @@ namespace xgeom_static_compiler
             // Load the source data
             //
             displayProgressBar("Loading Mesh", 0);
-            if ( auto Err = LoadRaw(std::format(L"{}/{}", m_ProjectPaths.m_Project, m_Descriptor.m_ImportAsset)); Err )
-                return Err;
+            {
+                trace::scope Scope(m_Trace, "Loading Mesh");
+                if ( auto Err = LoadRaw(std::format(L"{}/{}", m_ProjectPaths.m_Project, m_Descriptor.m_ImportAsset)); Err )
+                    return Err;
+                Scope.setCounts(m_RawGeom.m_Facet.size(), m_RawGeom.m_Vertex.size());
+            }
             displayProgressBar("Loading Mesh", 1);
 
             //
@@ -1466,7 +2473,8 @@ namespace xgeom_static_compiler
             //
             // OK Time to compile
             //
-            Compile();
+            if (auto Err = Compile(); Err)
+                return Err;
 
             //
             // Serialize the details structure
@@ -1481,27 +2489,50 @@ namespace xgeom_static_compiler
                     return xerr::create_f<state, "Failed while serializing details.txt">(Err);
             }
 
+            //
+            // Size and decode speed of the encoded streams
+            //
+            if (m_CodecReport.empty() == false && m_CodecReport.Save(std::format(L"{}\\Codecs.txt", m_ResourceLogPath)) == false)
+                LogMessage(xresource_pipeline::msg_type::WARNING, std::format("Failed to write the codec report Codecs.txt"));
+
             //
             // Export
             //
             int Count = 0;
             for (auto& T : m_Target)
             {
+                trace::scope Scope(m_Trace, "Serializing");
+                Scope.setCounts(m_FinalGeom.m_nIndices / 3, m_FinalGeom.m_nVertices);
+
                 displayProgressBar("Serializing", Count++ / (float)m_Target.size());
 
                 if (T.m_bValid)
                 {
-                    Serialize(T.m_DataPath);
+                    if (auto Err = Serialize(T.m_DataPath); Err)
+                        return Err;
                 }
             }
             displayProgressBar("Serializing", 1);
+
             return {};
         }
 
         //--------------------------------------------------------------------------------------
 
-        void Serialize(const std::wstring_view FilePath)
+        xerr Serialize(const std::wstring_view FilePath)
         {
+            // The flat blob is not compressed so the runtime can map it and use it in place
+            if (m_Descriptor.m_bFlatBlob)
+            {
+                std::vector<std::byte> Blob;
+                xgeom_static::blob::Write(m_FinalGeom, Blob);
+
+                std::ofstream File(std::filesystem::path(FilePath), std::ios::binary | std::ios::trunc);
+                File.write(reinterpret_cast<const char*>(Blob.data()), static_cast<std::streamsize>(Blob.size()));
+                if (!File) return xerr::create_f<state, "Failed to write the geom blob">();
+                return {};
+            }
+
             xserializer::stream Serializer;
             if( auto Err = Serializer.Save
                 ( FilePath
@@ -1509,8 +2540,10 @@ namespace xgeom_static_compiler
                 , m_OptimizationType == optimization_type::O0 ? xserializer::compression_level::FAST : m_OptimizationType == optimization_type::O1 ? xserializer::compression_level::MEDIUM : xserializer::compression_level::HIGH
                 ); Err )
             {
-                throw(std::runtime_error(std::string(Err.getMessage())));
+                return xerr::create_f<state, "Failed to serialize the geom">(Err);
             }
+
+            return {};
         }
 
         meshopt_VertexCacheStatistics   m_VertCacheAMDStats;
@@ -1525,8 +2558,12 @@ namespace xgeom_static_compiler
 
         xgeom_static::geom              m_FinalGeom;
         std::vector<mesh>               m_CompilerMesh;
+        skeleton_builder::tables        m_Skeleton;             // Parent ordered bones, built before the vertex weights
         xraw3d::geom                    m_RawGeom;
         xraw3d::assimp_v2::node         m_RootNode;
+        stage_cache::store              m_StageCache;
+        trace::recorder                 m_Trace;
+        codec_report::report            m_CodecReport;
     };
 
     //------------------------------------------------------------------------------------
@@ -0,0 +1,87 @@
+#ifndef XSKELETON_COMPILER_CODEC_REPORT_H
+#define XSKELETON_COMPILER_CODEC_REPORT_H
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//
+// Size and decode speed of every stream that the compiler encoded (see xskeleton_index_codec.h
+// and xskeleton_vertex_codec.h), written as Codecs.txt next to Details.txt. The decode is timed
+// once on the compiling machine with the runtime decoder, so compare the numbers between streams
+// and assets rather than take them as the speed of the target platform.
+//
+namespace xgeom_static_compiler::codec_report
+{
+    struct stream
+    {
+        std::string             m_Name;
+        std::uint64_t           m_nElements;
+        std::uint64_t           m_RawBytes;
+        std::uint64_t           m_EncodedBytes;
+        std::uint64_t           m_DecodeNS;
+
+        double getRatio         (void) const noexcept { return m_EncodedBytes ? double(m_RawBytes) / double(m_EncodedBytes) : 0.0; }
+        double getDecodeMBPerSec(void) const noexcept { return m_DecodeNS     ? double(m_RawBytes) * 1000.0 / double(m_DecodeNS) : 0.0; }
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    class report
+    {
+    public:
+
+        void Clear(void) noexcept { m_Streams.clear(); }
+        bool empty(void) const noexcept { return m_Streams.empty(); }
+
+        //--------------------------------------------------------------------------------------
+        // Runs Decode (which must decode all the stream) and records how long it took
+        //--------------------------------------------------------------------------------------
+        template< typename T_DECODE >
+        void Add(std::string Name, std::uint64_t nElements, std::uint64_t RawBytes, std::uint64_t EncodedBytes, T_DECODE&& Decode)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            Decode();
+            const auto DecodeNS = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+
+            m_Streams.push_back({ std::move(Name), nElements, RawBytes, EncodedBytes, DecodeNS });
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        bool Save(const std::wstring& Path) const noexcept
+        {
+            std::ofstream File(std::filesystem::path(Path), std::ios::trunc);
+            if (!File) return false;
+
+            File << "Stream          Elements     RawBytes     EncodedBytes Ratio    DecodeMB/s\n";
+            for (const auto& S : m_Streams)
+            {
+                char Line[256];
+                std::snprintf(Line, sizeof(Line), "%-15s %-12llu %-12llu %-12llu %-8.2f %.1f\n"
+                    , S.m_Name.c_str()
+                    , static_cast<unsigned long long>(S.m_nElements)
+                    , static_cast<unsigned long long>(S.m_RawBytes)
+                    , static_cast<unsigned long long>(S.m_EncodedBytes)
+                    , S.getRatio()
+                    , S.getDecodeMBPerSec() );
+                File << Line;
+            }
+
+            return static_cast<bool>(File);
+        }
+
+        const std::vector<stream>& getStreams(void) const noexcept { return m_Streams; }
+
+    private:
+
+        std::vector<stream>     m_Streams   = {};
+    };
+}
+
+#endif
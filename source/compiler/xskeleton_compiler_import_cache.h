@@ -0,0 +1,420 @@
+#ifndef XSKELETON_COMPILER_IMPORT_CACHE_H
+#define XSKELETON_COMPILER_IMPORT_CACHE_H
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "xgeom_static_compiler.h"
+#include "../xskeleton_blob.h"
+#include "dependencies/xraw3d/source/xraw3d.h"
+#include "dependencies/xraw3d/source/details/xraw3d_assimp_import_v2.h"
+
+//
+// Binary cache of what the assimp importer produces (xraw3d::geom + the node tree) so a recompile
+// of an asset whose source file did not change (only the descriptor did) does not need to parse
+// the FBX/OBJ again. The cache is keyed by a hash of the content of the source file plus a hash
+// of the importer settings, of the descriptor fields that the import reads (see
+// ComputeSettingsHash) and of the layout of the cached structures.
+//
+// The file is memory mapped to check the key and read, then Load copies the blocks into the
+// vectors of the xraw3d::geom (the compiler edits them), so nothing is used from the mapping.
+//
+// File layout (little endian, every block starts at a 64 byte boundary):
+//      header
+//      xraw3d::geom::vertex[]      - Raw copy
+//      xraw3d::geom::facet[]       - Raw copy
+//      names                       - Meshes, material instances, bones and the node tree (length prefixed)
+//
+// Only the fields that the compiler reads are cached (mesh names/bone counts, material instance
+// names, bone names/parents/bind pose, node names/mesh lists/children). Bump version_v when the compiler starts to use more.
+//
+namespace xgeom_static_compiler::import_cache
+{
+    inline static constexpr std::uint32_t               version_v   = 2;
+    inline static constexpr std::array<char, 8>         magic_v     = { 'X', 'S', 'K', 'R', 'A', 'W', 'C', '\0' };
+    inline static constexpr std::size_t                 alignment_v = 64;
+
+    static_assert(std::endian::native == std::endian::little, "The import cache is stored in little endian");
+    static_assert(std::is_trivially_copyable_v<xraw3d::geom::vertex>);
+    static_assert(std::is_trivially_copyable_v<xraw3d::geom::facet>);
+
+    struct key
+    {
+        std::uint64_t   m_SourceHash    = 0;
+        std::uint64_t   m_SourceSize    = 0;
+        std::uint64_t   m_SettingsHash  = 0;
+    };
+
+    struct header
+    {
+        std::array<char, 8>     m_Magic;
+        std::uint32_t           m_Version;
+        std::uint32_t           m_HeaderSize;
+        key                     m_Key;
+        std::uint64_t           m_VertexOffset;
+        std::uint64_t           m_nVertices;
+        std::uint64_t           m_FacetOffset;
+        std::uint64_t           m_nFacets;
+        std::uint64_t           m_NamesOffset;
+        std::uint64_t           m_NamesSize;
+        std::uint64_t           m_FileSize;
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Memory mapped file (shared with the runtime geom blob)
+    //--------------------------------------------------------------------------------------
+    using mapped_file = xgeom_static::blob::mapped_file;
+
+    namespace details
+    {
+        //--------------------------------------------------------------------------------------
+        // 64 bit hash, 4 independent lanes of 8 bytes so it runs close to memory speed
+        //--------------------------------------------------------------------------------------
+        inline std::uint64_t Hash(std::span<const std::byte> Data, std::uint64_t Seed = 0) noexcept
+        {
+            constexpr std::uint64_t k0 = 0x9E3779B185EBCA87ull;
+            constexpr std::uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+
+            auto Round = [](std::uint64_t Acc, std::uint64_t V) constexpr
+            {
+                Acc += V * k1;
+                Acc  = std::rotl(Acc, 31);
+                return Acc * k0;
+            };
+
+            std::array<std::uint64_t, 4>    Lanes   = { Seed + k0 + k1, Seed + k1, Seed, Seed - k0 };
+            const std::byte*                p       = Data.data();
+            std::size_t                     n       = Data.size();
+
+            for (; n >= 32; n -= 32, p += 32)
+            {
+                std::uint64_t V[4];
+                std::memcpy(V, p, 32);
+                for (int i = 0; i < 4; ++i) Lanes[i] = Round(Lanes[i], V[i]);
+            }
+
+            std::uint64_t H = std::rotl(Lanes[0], 1) + std::rotl(Lanes[1], 7) + std::rotl(Lanes[2], 12) + std::rotl(Lanes[3], 18);
+            H ^= Data.size() * k0;
+
+            for (; n >= 8; n -= 8, p += 8)
+            {
+                std::uint64_t V;
+                std::memcpy(&V, p, 8);
+                H = std::rotl(H ^ Round(0, V), 27) * k0 + k1;
+            }
+            for (; n; --n, ++p) H = std::rotl(H ^ (static_cast<std::uint64_t>(*p) * k0), 11) * k1;
+
+            H ^= H >> 33; H *= k1;
+            H ^= H >> 29; H *= k0;
+            H ^= H >> 32;
+            return H;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        constexpr std::size_t Align(std::size_t Offset) noexcept
+        {
+            return (Offset + alignment_v - 1) & ~(alignment_v - 1);
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Writer/reader for the names block (also used by the stage cache)
+        //--------------------------------------------------------------------------------------
+        struct writer
+        {
+            std::vector<std::byte> m_Data;
+
+            template< typename T > void Write(const T& V)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto* p = reinterpret_cast<const std::byte*>(&V);
+                m_Data.insert(m_Data.end(), p, p + sizeof(T));
+            }
+
+            void WriteString(const std::string& S)
+            {
+                Write(static_cast<std::uint32_t>(S.size()));
+                const auto* p = reinterpret_cast<const std::byte*>(S.data());
+                m_Data.insert(m_Data.end(), p, p + S.size());
+            }
+
+            template< typename T > void WriteVector(const std::vector<T>& V)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                Write(static_cast<std::uint64_t>(V.size()));
+                const auto* p = reinterpret_cast<const std::byte*>(V.data());
+                m_Data.insert(m_Data.end(), p, p + V.size() * sizeof(T));
+            }
+
+            void WriteNode(const xraw3d::assimp_v2::node& Node)
+            {
+                WriteString(Node.m_Name);
+                Write(static_cast<std::uint32_t>(Node.m_MeshList.size()));
+                for (auto& E : Node.m_MeshList) Write(static_cast<std::uint32_t>(E));
+                Write(static_cast<std::uint32_t>(Node.m_Children.size()));
+                for (auto& E : Node.m_Children) WriteNode(E);
+            }
+        };
+
+        struct reader
+        {
+            std::span<const std::byte>  m_Data;
+            std::size_t                 m_Pos   = 0;
+            bool                        m_bOK   = true;
+
+            template< typename T > T Read(void) noexcept
+            {
+                T V{};
+                if (m_bOK && m_Pos + sizeof(T) <= m_Data.size()) std::memcpy(&V, m_Data.data() + m_Pos, sizeof(T)), m_Pos += sizeof(T);
+                else                                             m_bOK = false;
+                return V;
+            }
+
+            void ReadString(std::string& S)
+            {
+                const auto Size = Read<std::uint32_t>();
+                if (m_bOK && m_Pos + Size <= m_Data.size()) S.assign(reinterpret_cast<const char*>(m_Data.data() + m_Pos), Size), m_Pos += Size;
+                else                                        m_bOK = false;
+            }
+
+            template< typename T > void ReadVector(std::vector<T>& V)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto Count = Read<std::uint64_t>();
+                if (m_bOK && Count <= (m_Data.size() - m_Pos) / sizeof(T))
+                {
+                    V.resize(Count);
+                    std::memcpy(V.data(), m_Data.data() + m_Pos, Count * sizeof(T));
+                    m_Pos += Count * sizeof(T);
+                }
+                else m_bOK = false;
+            }
+
+            void ReadNode(xraw3d::assimp_v2::node& Node)
+            {
+                ReadString(Node.m_Name);
+
+                const auto nMeshes = Read<std::uint32_t>();
+                if (!m_bOK || nMeshes > m_Data.size()) { m_bOK = false; return; }
+                Node.m_MeshList.resize(nMeshes);
+                for (auto& E : Node.m_MeshList) E = static_cast<std::remove_reference_t<decltype(E)>>(Read<std::uint32_t>());
+
+                const auto nChildren = Read<std::uint32_t>();
+                if (!m_bOK || nChildren > m_Data.size()) { m_bOK = false; return; }
+                Node.m_Children.resize(nChildren);
+                for (auto& E : Node.m_Children) ReadNode(E);
+            }
+        };
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Everything besides the content of the source file that changes what the import produces:
+    // every importer setting and every descriptor field that the import reads (the import only
+    // reads the asset path, the pre translation and the rest are applied after the cache).
+    // Add a field here when the import starts to depend on it.
+    //--------------------------------------------------------------------------------------
+    inline std::uint64_t ComputeSettingsHash(const xraw3d::assimp_v2::importer& Importer, std::wstring_view ImportAsset) noexcept
+    {
+        const std::array<std::uint64_t, 1> Settings = { Importer.m_Settings.m_bAnimated ? 1u : 0u };
+
+        return details::Hash(std::as_bytes(std::span{ ImportAsset }), details::Hash(std::as_bytes(std::span{ Settings })));
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Hashes the source file, SettingsHash should come from ComputeSettingsHash
+    //--------------------------------------------------------------------------------------
+    inline xerr ComputeKey(key& Key, const std::wstring& SourcePath, std::uint64_t SettingsHash) noexcept
+    {
+        mapped_file Source;
+        if (!Source.Open(SourcePath))
+            return xerr::create_f<state, "Unable to open the source asset to compute its hash">();
+
+        const std::array<std::uint64_t, 4> Layout = { version_v, sizeof(xraw3d::geom::vertex), sizeof(xraw3d::geom::facet), SettingsHash };
+
+        Key.m_SourceHash    = details::Hash(Source.getData());
+        Key.m_SourceSize    = Source.getData().size();
+        Key.m_SettingsHash  = details::Hash(std::as_bytes(std::span{ Layout }));
+        return {};
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Fails when there is no cache or it was built from a different source/settings
+    //--------------------------------------------------------------------------------------
+    inline xerr Load(const std::wstring& CachePath, const key& Key, xraw3d::geom& Geom, xraw3d::assimp_v2::node& RootNode)
+    {
+        mapped_file File;
+        if (!File.Open(CachePath))
+            return xerr::create_f<state, "No import cache">();
+
+        const auto Data = File.getData();
+        if (Data.size() < sizeof(header))
+            return xerr::create_f<state, "Import cache is too small">();
+
+        header Header;
+        std::memcpy(&Header, Data.data(), sizeof(header));
+
+        if (   Header.m_Magic                != magic_v
+            || Header.m_Version              != version_v
+            || Header.m_HeaderSize           != sizeof(header)
+            || Header.m_FileSize             != Data.size() )
+            return xerr::create_f<state, "Import cache has a different format">();
+
+        if (   Header.m_Key.m_SourceHash     != Key.m_SourceHash
+            || Header.m_Key.m_SourceSize     != Key.m_SourceSize
+            || Header.m_Key.m_SettingsHash   != Key.m_SettingsHash )
+            return xerr::create_f<state, "Import cache is out of date">();
+
+        auto InFile = [&](std::uint64_t Offset, std::uint64_t Count, std::size_t Size)
+        {
+            return Offset <= Data.size() && Count <= (Data.size() - Offset) / Size;
+        };
+
+        if (   !InFile(Header.m_VertexOffset, Header.m_nVertices, sizeof(xraw3d::geom::vertex))
+            || !InFile(Header.m_FacetOffset,  Header.m_nFacets,   sizeof(xraw3d::geom::facet))
+            || !InFile(Header.m_NamesOffset,  Header.m_NamesSize, 1) )
+            return xerr::create_f<state, "Import cache is corrupted">();
+
+        Geom = {};
+        RootNode = {};
+
+        Geom.m_Vertex.resize(Header.m_nVertices);
+        Geom.m_Facet.resize(Header.m_nFacets);
+        std::memcpy(Geom.m_Vertex.data(), Data.data() + Header.m_VertexOffset, Header.m_nVertices * sizeof(xraw3d::geom::vertex));
+        std::memcpy(Geom.m_Facet.data(),  Data.data() + Header.m_FacetOffset,  Header.m_nFacets   * sizeof(xraw3d::geom::facet));
+
+        details::reader Reader{ .m_Data = Data.subspan(Header.m_NamesOffset, Header.m_NamesSize) };
+
+        const auto nMeshes = Reader.Read<std::uint32_t>();
+        if (Reader.m_bOK && nMeshes <= Header.m_NamesSize)
+        {
+            Geom.m_Mesh.resize(nMeshes);
+            for (auto& M : Geom.m_Mesh)
+            {
+                Reader.ReadString(M.m_Name);
+                M.m_nBones = Reader.Read<std::int32_t>();
+            }
+        }
+
+        const auto nMaterials = Reader.Read<std::uint32_t>();
+        if (Reader.m_bOK && nMaterials <= Header.m_NamesSize)
+        {
+            Geom.m_MaterialInstance.resize(nMaterials);
+            for (auto& M : Geom.m_MaterialInstance) Reader.ReadString(M.m_Name);
+        }
+
+        const auto nBones = Reader.Read<std::uint32_t>();
+        if (Reader.m_bOK && nBones <= Header.m_NamesSize)
+        {
+            Geom.m_Bone.resize(nBones);
+            for (auto& B : Geom.m_Bone)
+            {
+                Reader.ReadString(B.m_Name);
+                B.m_iParent     = Reader.Read<std::int32_t>();
+                B.m_nChildren   = Reader.Read<std::int32_t>();
+
+                // Scale XYZ, rotation XYZW, position XYZ (read one by one, argument order is unspecified)
+                std::array<float, 10> V;
+                for (auto& E : V) E = Reader.Read<float>();
+                B.m_Scale       = xmath::fvec3(V[0], V[1], V[2]);
+                B.m_Rotation    = xmath::fquat(V[3], V[4], V[5], V[6]);
+                B.m_Position    = xmath::fvec3(V[7], V[8], V[9]);
+            }
+        }
+
+        Reader.ReadNode(RootNode);
+
+        if (!Reader.m_bOK)
+        {
+            Geom = {};
+            RootNode = {};
+            return xerr::create_f<state, "Import cache is corrupted">();
+        }
+
+        return {};
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Writes into a temporary file first so an interrupted compile never leaves a broken cache
+    //--------------------------------------------------------------------------------------
+    inline xerr Save(const std::wstring& CachePath, const key& Key, const xraw3d::geom& Geom, const xraw3d::assimp_v2::node& RootNode)
+    {
+        details::writer Names;
+        Names.Write(static_cast<std::uint32_t>(Geom.m_Mesh.size()));
+        for (auto& M : Geom.m_Mesh)
+        {
+            Names.WriteString(M.m_Name);
+            Names.Write(static_cast<std::int32_t>(M.m_nBones));
+        }
+        Names.Write(static_cast<std::uint32_t>(Geom.m_MaterialInstance.size()));
+        for (auto& M : Geom.m_MaterialInstance) Names.WriteString(M.m_Name);
+        Names.Write(static_cast<std::uint32_t>(Geom.m_Bone.size()));
+        for (auto& B : Geom.m_Bone)
+        {
+            Names.WriteString(B.m_Name);
+            Names.Write(static_cast<std::int32_t>(B.m_iParent));
+            Names.Write(static_cast<std::int32_t>(B.m_nChildren));
+            for (float V : { B.m_Scale.m_X, B.m_Scale.m_Y, B.m_Scale.m_Z, B.m_Rotation.m_X, B.m_Rotation.m_Y, B.m_Rotation.m_Z, B.m_Rotation.m_W, B.m_Position.m_X, B.m_Position.m_Y, B.m_Position.m_Z })
+                Names.Write(V);
+        }
+        Names.WriteNode(RootNode);
+
+        header Header{};
+        Header.m_Magic          = magic_v;
+        Header.m_Version        = version_v;
+        Header.m_HeaderSize     = sizeof(header);
+        Header.m_Key            = Key;
+        Header.m_nVertices      = Geom.m_Vertex.size();
+        Header.m_nFacets        = Geom.m_Facet.size();
+        Header.m_NamesSize      = Names.m_Data.size();
+        Header.m_VertexOffset   = details::Align(sizeof(header));
+        Header.m_FacetOffset    = details::Align(Header.m_VertexOffset + Header.m_nVertices * sizeof(xraw3d::geom::vertex));
+        Header.m_NamesOffset    = details::Align(Header.m_FacetOffset  + Header.m_nFacets   * sizeof(xraw3d::geom::facet));
+        Header.m_FileSize       = Header.m_NamesOffset + Header.m_NamesSize;
+
+        const auto TempPath = std::filesystem::path(CachePath + L".tmp");
+        {
+            std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+            if (!File)
+                return xerr::create_f<state, "Unable to create the import cache">();
+
+            auto WriteAt = [&](std::uint64_t Offset, const void* pData, std::size_t Size)
+            {
+                static constexpr std::array<char, alignment_v> Zeros{};
+                const auto Pos = static_cast<std::uint64_t>(File.tellp());
+                File.write(Zeros.data(), static_cast<std::streamsize>(Offset - Pos));
+                File.write(static_cast<const char*>(pData), static_cast<std::streamsize>(Size));
+            };
+
+            WriteAt(0,                      &Header,                sizeof(header));
+            WriteAt(Header.m_VertexOffset,  Geom.m_Vertex.data(),   Header.m_nVertices * sizeof(xraw3d::geom::vertex));
+            WriteAt(Header.m_FacetOffset,   Geom.m_Facet.data(),    Header.m_nFacets   * sizeof(xraw3d::geom::facet));
+            WriteAt(Header.m_NamesOffset,   Names.m_Data.data(),    Names.m_Data.size());
+
+            if (!File)
+                return xerr::create_f<state, "Failed to write the import cache">();
+        }
+
+        std::error_code Error;
+        std::filesystem::rename(TempPath, CachePath, Error);
+        if (Error)
+        {
+            std::filesystem::remove(TempPath, Error);
+            return xerr::create_f<state, "Failed to replace the import cache">();
+        }
+
+        return {};
+    }
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef XSKELETON_COMPILER_MESH_LOOKUP_H
+#define XSKELETON_COMPILER_MESH_LOOKUP_H
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "../xskeleton.h"
+
+//
+// Builds geom::m_pLookup, the tables that make geom::findMeshIndex and geom::getSubMeshIndex
+// constant time at runtime:
+//
+//      std::uint16_t Seeds[nBuckets]                   - Per bucket seed of the mesh name hash
+//      std::uint16_t Slots[nSlots]                     - Mesh index or geom::invalid_index_v
+//      std::uint16_t SubMesh[nLODs][nMaterialInstances] - Submesh index or geom::invalid_index_v
+//
+// The mesh name hash is a perfect hash built with hash and displace: the names are grouped in
+// buckets by their hash and, starting with the largest bucket, every bucket searches for the
+// seed that moves all its names to free slots. There are twice as many slots as meshes so the
+// search ends after a few tries. When two meshes have the same name only the first one is in
+// the hash, which is what the old linear search returned.
+//
+namespace xgeom_static_compiler::mesh_lookup
+{
+    struct tables
+    {
+        std::vector<std::uint16_t>  m_Lookup;
+        std::uint32_t               m_nBuckets  = 0;
+        std::uint32_t               m_nSlots    = 0;
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    inline tables Build( std::span<const xgeom_static::geom::mesh> Meshes, std::span<const xgeom_static::geom::lod> LODs, std::span<const xgeom_static::geom::submesh> SubMeshes, std::size_t nMaterialInstances )
+    {
+        using geom = xgeom_static::geom;
+
+        struct entry
+        {
+            std::uint32_t   m_Hash;
+            std::uint16_t   m_iMesh;
+        };
+
+        tables Tables;
+        if (Meshes.empty() == false)
+        {
+            Tables.m_nBuckets = static_cast<std::uint32_t>(std::bit_ceil(std::max<std::size_t>(1, Meshes.size() / 2)));
+            Tables.m_nSlots   = static_cast<std::uint32_t>(std::bit_ceil(Meshes.size() * 2));
+        }
+
+        Tables.m_Lookup.assign(std::size_t(Tables.m_nBuckets) + Tables.m_nSlots + LODs.size() * nMaterialInstances, geom::invalid_index_v);
+
+        const auto Seeds     = std::span{ Tables.m_Lookup }.subspan(0, Tables.m_nBuckets);
+        const auto Slots     = std::span{ Tables.m_Lookup }.subspan(Tables.m_nBuckets, Tables.m_nSlots);
+        const auto SubMesh   = std::span{ Tables.m_Lookup }.subspan(std::size_t(Tables.m_nBuckets) + Tables.m_nSlots);
+
+        std::ranges::fill(Seeds, std::uint16_t{ 0 });
+
+        //
+        // Mesh name perfect hash
+        //
+        std::vector<std::vector<entry>>         Buckets(Tables.m_nBuckets);
+        std::unordered_set<std::string_view>    Names;
+        for (std::size_t i = 0; i < Meshes.size(); ++i)
+        {
+            if (Names.insert(Meshes[i].m_Name.data()).second == false) continue;
+
+            const auto Hash = geom::HashMeshName(Meshes[i].m_Name.data());
+            Buckets[Hash & (Tables.m_nBuckets - 1)].push_back({ Hash, static_cast<std::uint16_t>(i) });
+        }
+
+        std::vector<std::uint32_t> Order(Buckets.size());
+        for (std::uint32_t i = 0; i < Order.size(); ++i) Order[i] = i;
+        std::ranges::stable_sort(Order, [&](std::uint32_t A, std::uint32_t B) { return Buckets[A].size() > Buckets[B].size(); });
+
+        std::vector<std::uint32_t> Taken;
+        for (const auto iBucket : Order)
+        {
+            const auto& Bucket = Buckets[iBucket];
+            if (Bucket.empty()) break;
+
+            bool bPlaced = false;
+            for (std::uint32_t Seed = 0; Seed <= 0xffff && !bPlaced; ++Seed)
+            {
+                Taken.clear();
+                bPlaced = true;
+                for (const auto& E : Bucket)
+                {
+                    const auto iSlot = geom::getMeshHashSlot(E.m_Hash, static_cast<std::uint16_t>(Seed)) & (Tables.m_nSlots - 1);
+                    if (Slots[iSlot] != geom::invalid_index_v || std::ranges::find(Taken, iSlot) != Taken.end())
+                    {
+                        bPlaced = false;
+                        break;
+                    }
+                    Taken.push_back(iSlot);
+                }
+
+                if (bPlaced)
+                {
+                    Seeds[iBucket] = static_cast<std::uint16_t>(Seed);
+                    for (std::size_t i = 0; i < Bucket.size(); ++i) Slots[Taken[i]] = Bucket[i].m_iMesh;
+                }
+            }
+
+            if (bPlaced == false) throw(std::runtime_error("Unable to build the perfect hash of the mesh names"));
+        }
+
+        //
+        // (LOD, material instance) -> submesh, the first submesh with the material wins
+        //
+        for (std::size_t iLOD = 0; iLOD < LODs.size(); ++iLOD)
+        {
+            const auto& LOD = LODs[iLOD];
+            for (std::size_t iSubMesh = LOD.m_iSubmesh; iSubMesh < std::size_t(LOD.m_iSubmesh) + LOD.m_nSubmesh; ++iSubMesh)
+            {
+                const auto iMaterial = SubMeshes[iSubMesh].m_iMaterial;
+                if (iMaterial >= nMaterialInstances) continue;
+
+                auto& Entry = SubMesh[iLOD * nMaterialInstances + iMaterial];
+                if (Entry == geom::invalid_index_v) Entry = static_cast<std::uint16_t>(iSubMesh);
+            }
+        }
+
+        return Tables;
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef XSKELETON_COMPILER_SKELETON_H
+#define XSKELETON_COMPILER_SKELETON_H
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../xskeleton.h"
+#include "dependencies/xraw3d/source/xraw3d.h"
+
+//
+// Builds the tables of geom::m_Skeleton (see xskeleton_skeleton.h) from the bones of the import.
+// The bones are sorted breadth first starting from the roots (in import order), so the parent
+// of every bone is before it, and the position, rotation and scale of an xraw3d bone are taken
+// as its bind pose relative to its parent. m_Remap goes from the index of a bone in the import
+// to its index in the tables, which is what the vertex weights need.
+//
+namespace xgeom_static_compiler::skeleton_builder
+{
+    using skeleton = xskeleton::skeleton;
+
+    struct tables
+    {
+        std::vector<std::int16_t>       m_Parent;
+        std::vector<skeleton::name>     m_Name;
+        std::vector<skeleton::vec4>     m_BindTranslation;
+        std::vector<skeleton::vec4>     m_BindRotation;
+        std::vector<skeleton::vec4>     m_BindScale;
+        std::vector<skeleton::affine>   m_InverseBind;
+        std::vector<int>                m_Remap;            // Import bone index -> table index
+        std::uint16_t                   m_nRoots = 0;
+
+        std::size_t size(void) const noexcept { return m_Parent.size(); }
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Throws if a parent index is out of range or the parents form a loop. Names longer than
+    // skeleton::name can hold are cut.
+    //--------------------------------------------------------------------------------------
+    inline tables Build(std::span<const xraw3d::geom::bone> Bones)
+    {
+        if (Bones.size() > std::size_t(std::numeric_limits<std::int16_t>::max()))
+            throw(std::runtime_error("The skeleton has too many bones"));
+
+        const int nBones = static_cast<int>(Bones.size());
+
+        //
+        // Children of every bone (in import order), the roots are the children of -1
+        //
+        std::vector<int> nChildren(nBones + 1, 0);
+        for (const auto& B : Bones)
+        {
+            if (B.m_iParent >= nBones || B.m_iParent == static_cast<int>(&B - Bones.data()))
+                throw(std::runtime_error(std::string("Bone ") + B.m_Name + " has an invalid parent"));
+            ++nChildren[std::max(B.m_iParent, -1) + 1];
+        }
+
+        std::vector<int> FirstChild(nBones + 2, 0);
+        for (int i = 0; i <= nBones; ++i) FirstChild[i + 1] = FirstChild[i] + nChildren[i];
+
+        std::vector<int> Children(nBones);
+        std::vector<int> Fill(FirstChild.begin(), FirstChild.end() - 1);
+        for (int i = 0; i < nBones; ++i) Children[Fill[std::max(Bones[i].m_iParent, -1) + 1]++] = i;
+
+        //
+        // Breadth first order, the roots are the children of -1 so they go first
+        //
+        tables Tables;
+        Tables.m_nRoots = static_cast<std::uint16_t>(nChildren[0]);
+        Tables.m_Remap.assign(nBones, -1);
+
+        std::vector<int> Order(Children.begin(), Children.begin() + nChildren[0]);
+        Order.reserve(nBones);
+        for (std::size_t i = 0; i < Order.size(); ++i)
+        {
+            const int iBone = Order[i];
+            Tables.m_Remap[iBone] = static_cast<int>(i);
+            Order.insert(Order.end(), Children.begin() + FirstChild[iBone + 1], Children.begin() + FirstChild[iBone + 2]);
+        }
+
+        // Any bone that was not reached is in a loop that never gets to a root
+        if (Order.size() != Bones.size())
+            throw(std::runtime_error("The parents of the bones form a loop"));
+
+        //
+        // Fill the tables in the new order
+        //
+        Tables.m_Parent.resize(nBones);
+        Tables.m_Name.resize(nBones);
+        Tables.m_BindTranslation.resize(nBones);
+        Tables.m_BindRotation.resize(nBones);
+        Tables.m_BindScale.resize(nBones);
+        Tables.m_InverseBind.resize(nBones);
+
+        for (int i = 0; i < nBones; ++i)
+        {
+            const auto& B = Bones[Order[i]];
+
+            Tables.m_Parent[i]          = B.m_iParent < 0 ? skeleton::invalid_bone_v : static_cast<std::int16_t>(Tables.m_Remap[B.m_iParent]);
+            Tables.m_Name[i]            = {};
+            B.m_Name.copy(Tables.m_Name[i].data(), Tables.m_Name[i].size() - 1);
+            Tables.m_BindTranslation[i] = { B.m_Position.m_X, B.m_Position.m_Y, B.m_Position.m_Z, 0 };
+            Tables.m_BindRotation[i]    = { B.m_Rotation.m_X, B.m_Rotation.m_Y, B.m_Rotation.m_Z, B.m_Rotation.m_W };
+            Tables.m_BindScale[i]       = { B.m_Scale.m_X, B.m_Scale.m_Y, B.m_Scale.m_Z, 0 };
+        }
+
+        //
+        // Inverse bind matrices from the model space bind pose
+        //
+        skeleton View{};
+        View.m_pParent          = Tables.m_Parent.data();
+        View.m_pBindTranslation = Tables.m_BindTranslation.data();
+        View.m_pBindRotation    = Tables.m_BindRotation.data();
+        View.m_pBindScale       = Tables.m_BindScale.data();
+        View.m_nBones           = static_cast<std::uint16_t>(nBones);
+        View.m_nRoots           = Tables.m_nRoots;
+
+        std::vector<skeleton::affine> Local(nBones);
+        View.ComputeBindLocal(Local);
+        View.ComputeModelPose(Local, Tables.m_InverseBind);
+        for (auto& M : Tables.m_InverseBind) M = skeleton::Inverse(M);
+
+        return Tables;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Copies the tables into a skeleton that already has room for all the bones
+    //--------------------------------------------------------------------------------------
+    inline void Copy(const tables& Tables, skeleton& Skeleton) noexcept
+    {
+        std::ranges::copy(Tables.m_Parent,          Skeleton.m_pParent);
+        std::ranges::copy(Tables.m_Name,            Skeleton.m_pName);
+        std::ranges::copy(Tables.m_BindTranslation, Skeleton.m_pBindTranslation);
+        std::ranges::copy(Tables.m_BindRotation,    Skeleton.m_pBindRotation);
+        std::ranges::copy(Tables.m_BindScale,       Skeleton.m_pBindScale);
+        std::ranges::copy(Tables.m_InverseBind,     Skeleton.m_pInverseBind);
+        Skeleton.m_nRoots = Tables.m_nRoots;
+    }
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef XSKELETON_COMPILER_STAGE_CACHE_H
+#define XSKELETON_COMPILER_STAGE_CACHE_H
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+#include "xskeleton_compiler_import_cache.h"
+
+//
+// On disk memoization of the expensive compiler stages (LOD generation and clustering). Every
+// entry is keyed by a fingerprint of everything that produced it: the fingerprint of the stage
+// that feeds it plus the descriptor fields that the stage reads. When nothing changed the stage
+// loads its previous output instead of recomputing it.
+//
+// Entries are files named <Kind>_<Fingerprint>.bin inside the cache folder. Files that were not
+// used by a successful compile are removed by Prune, so the folder only keeps the last compile.
+//
+namespace xgeom_static_compiler::stage_cache
+{
+    inline static constexpr std::uint32_t           version_v   = 1;
+    inline static constexpr std::array<char, 8>     magic_v     = { 'X', 'S', 'K', 'S', 'T', 'G', 'C', '\0' };
+
+    //--------------------------------------------------------------------------------------
+    // Incremental hash of the inputs of a stage
+    //--------------------------------------------------------------------------------------
+    struct fingerprint
+    {
+        std::uint64_t m_Value = version_v;
+
+        template< typename T >
+        fingerprint& Add(const T& V) noexcept
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            m_Value = import_cache::details::Hash(std::as_bytes(std::span{ &V, 1 }), m_Value);
+            return *this;
+        }
+
+        fingerprint& Add(std::string_view S) noexcept
+        {
+            m_Value = import_cache::details::Hash(std::as_bytes(std::span{ S.data(), S.size() }), m_Value + S.size());
+            return *this;
+        }
+    };
+
+    struct header
+    {
+        std::array<char, 8>     m_Magic;
+        std::uint32_t           m_Version;
+        std::uint32_t           m_HeaderSize;
+        std::uint64_t           m_Fingerprint;
+        std::uint64_t           m_PayloadSize;
+        std::uint64_t           m_PayloadHash;
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    class store
+    {
+    public:
+
+        // An empty folder disables the cache
+        void Initialize(std::wstring Folder)
+        {
+            std::error_code Error;
+            m_Used.clear();
+            m_Folder = std::move(Folder);
+            if (m_Folder.empty() || (std::filesystem::create_directories(m_Folder, Error), Error))
+                m_Folder.clear();
+        }
+
+        bool isEnabled(void) const noexcept { return !m_Folder.empty(); }
+
+        //--------------------------------------------------------------------------------------
+        // Read is called with an import_cache::details::reader over the payload. Returns false
+        // when there is no valid entry (Read failing also counts as a miss, in which case Read may
+        // have filled part of its outputs already).
+        //--------------------------------------------------------------------------------------
+        template< typename T_FUNCTION >
+        bool Load(std::string_view Kind, std::uint64_t Fingerprint, T_FUNCTION&& Read)
+        {
+            if (!isEnabled()) return false;
+
+            const auto                  Path = getPath(Kind, Fingerprint);
+            import_cache::mapped_file   File;
+            if (!File.Open(Path)) return false;
+
+            const auto Data = File.getData();
+            if (Data.size() < sizeof(header)) return false;
+
+            header Header;
+            std::memcpy(&Header, Data.data(), sizeof(header));
+
+            const auto Payload = Data.subspan(sizeof(header));
+            if (   Header.m_Magic       != magic_v
+                || Header.m_Version     != version_v
+                || Header.m_HeaderSize  != sizeof(header)
+                || Header.m_Fingerprint != Fingerprint
+                || Header.m_PayloadSize != Payload.size()
+                || Header.m_PayloadHash != import_cache::details::Hash(Payload) )
+                return false;
+
+            import_cache::details::reader Reader{ .m_Data = Payload };
+            Read(Reader);
+            if (!Reader.m_bOK) return false;
+
+            MarkUsed(Path);
+            return true;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Write is called with an import_cache::details::writer. Failing to save is not an error,
+        // the next compile will simply recompute the stage.
+        //--------------------------------------------------------------------------------------
+        template< typename T_FUNCTION >
+        void Save(std::string_view Kind, std::uint64_t Fingerprint, T_FUNCTION&& Write)
+        {
+            if (!isEnabled()) return;
+
+            import_cache::details::writer Writer;
+            Write(Writer);
+
+            header Header;
+            Header.m_Magic          = magic_v;
+            Header.m_Version        = version_v;
+            Header.m_HeaderSize     = sizeof(header);
+            Header.m_Fingerprint    = Fingerprint;
+            Header.m_PayloadSize    = Writer.m_Data.size();
+            Header.m_PayloadHash    = import_cache::details::Hash(Writer.m_Data);
+
+            // The jobs save concurrently, so every save needs its own temporary file
+            const auto Path     = getPath(Kind, Fingerprint);
+            const auto TempPath = std::filesystem::path(std::format(L"{}.{}.tmp", Path, m_nTempFiles.fetch_add(1, std::memory_order_relaxed)));
+            {
+                std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+                File.write(reinterpret_cast<const char*>(&Header), sizeof(header));
+                File.write(reinterpret_cast<const char*>(Writer.m_Data.data()), static_cast<std::streamsize>(Writer.m_Data.size()));
+                if (!File) return;
+            }
+
+            std::error_code Error;
+            std::filesystem::rename(TempPath, Path, Error);
+            if (Error) std::filesystem::remove(TempPath, Error);
+            else       MarkUsed(Path);
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Removes every entry that was not loaded or saved since Initialize
+        //--------------------------------------------------------------------------------------
+        void Prune(void)
+        {
+            if (!isEnabled()) return;
+
+            std::error_code Error;
+            for (const auto& Entry : std::filesystem::directory_iterator(m_Folder, Error))
+            {
+                if (!Entry.is_regular_file(Error)) continue;
+                if (m_Used.contains(Entry.path().wstring())) continue;
+                std::filesystem::remove(Entry.path(), Error);
+            }
+        }
+
+    private:
+
+        std::wstring getPath(std::string_view Kind, std::uint64_t Fingerprint) const
+        {
+            return (std::filesystem::path(m_Folder) / std::format("{}_{:016X}.bin", Kind, Fingerprint)).wstring();
+        }
+
+        void MarkUsed(const std::wstring& Path)
+        {
+            std::scoped_lock Lock(m_Mutex);
+            m_Used.insert(Path);
+        }
+
+        std::wstring                        m_Folder        = {};
+        std::mutex                          m_Mutex         = {};
+        std::unordered_set<std::wstring>    m_Used          = {};
+        std::atomic<std::uint64_t>          m_nTempFiles    = 0;        // Makes the temporary file of every save unique
+    };
+}
+
+#endif
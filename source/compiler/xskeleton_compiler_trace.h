@@ -0,0 +1,307 @@
+#ifndef XSKELETON_COMPILER_TRACE_H
+#define XSKELETON_COMPILER_TRACE_H
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//
+// Timing trace of a compile written as a Chrome trace (chrome://tracing, ui.perfetto.dev). Every
+// stage and every parallel job opens a scope, which becomes a complete event with its thread,
+// its triangle/vertex counts and the memory it used.
+//
+// Memory is tracked when the compiler is built with XSKELETON_TRACE_MEMORY (CMake option of the
+// same name): the global operator new/delete of the compiler executable (see main.cpp) call
+// alloc::OnAlloc/OnFree, otherwise the memory numbers of the trace are 0. Every open scope has a
+// node with the bytes allocated inside it, its live bytes (allocated minus freed since it opened)
+// and the peak of those. An allocation or free only touches the innermost scope of its thread,
+// without atomics, and a scope adds its totals to its parent when it closes. A job that opens on
+// a worker thread takes the current stage of its recorder as its parent and hands its totals to
+// it when it closes; the stage folds them in on its own thread with the bytes it has live at that
+// point, so the peak of a stage assumes its jobs ran one after the other. The live bytes of the
+// memory counter track are process wide (with the batch mode they include the other assets being
+// compiled) and every thread adds its share when one of its scopes opens or closes.
+//
+namespace xgeom_static_compiler::trace
+{
+    namespace alloc
+    {
+        struct node
+        {
+            std::uint64_t                       m_Allocated     = 0;        // Only used by the thread of the scope
+            std::int64_t                        m_Live          = 0;
+            std::int64_t                        m_Peak          = 0;
+            node*                               m_pParent       = nullptr;
+            const void*                         m_pRecorder     = nullptr;
+
+            // Totals of the jobs that closed on other threads, waiting to be folded in
+            std::mutex                          m_JobsMutex     = {};
+            std::atomic<bool>                   m_bJobs         = false;
+            std::uint64_t                       m_JobsAllocated = 0;
+            std::int64_t                        m_JobsLive      = 0;
+            std::int64_t                        m_JobsPeak      = 0;
+
+            // Adds a child that ran on top of the bytes this node has live now
+            void Add(std::uint64_t Allocated, std::int64_t Live, std::int64_t Peak) noexcept
+            {
+                m_Peak       = std::max(m_Peak, m_Live + Peak);
+                m_Allocated += Allocated;
+                m_Live      += Live;
+            }
+
+            // Called by a job of another thread when it closes
+            void AddJob(std::uint64_t Allocated, std::int64_t Live, std::int64_t Peak) noexcept
+            {
+                std::scoped_lock Lock(m_JobsMutex);
+                m_JobsPeak       = std::max(m_JobsPeak, m_JobsLive + Peak);
+                m_JobsAllocated += Allocated;
+                m_JobsLive      += Live;
+                m_bJobs.store(true, std::memory_order_release);
+            }
+
+            // Called by the thread of the scope
+            void FoldJobs(void) noexcept
+            {
+                if (m_bJobs.load(std::memory_order_acquire) == false) return;
+
+                std::scoped_lock Lock(m_JobsMutex);
+                Add(m_JobsAllocated, m_JobsLive, m_JobsPeak);
+                m_JobsAllocated = 0;
+                m_JobsLive      = 0;
+                m_JobsPeak      = 0;
+                m_bJobs.store(false, std::memory_order_relaxed);
+            }
+        };
+
+        inline std::atomic<std::int64_t>        g_LiveBytes     = 0;
+        inline thread_local std::int64_t        t_LiveBytes     = 0;           // Not yet added to g_LiveBytes
+        inline thread_local node*               t_pCurrent      = nullptr;     // Innermost open scope of the thread
+
+        inline void OnAlloc(std::size_t Size) noexcept
+        {
+            const auto Bytes = static_cast<std::int64_t>(Size);
+            t_LiveBytes += Bytes;
+
+            if (node* pNode = t_pCurrent; pNode)
+            {
+                pNode->FoldJobs();
+                pNode->m_Allocated += Size;
+                pNode->m_Live      += Bytes;
+                pNode->m_Peak       = std::max(pNode->m_Peak, pNode->m_Live);
+            }
+        }
+
+        inline void OnFree(std::size_t Size) noexcept
+        {
+            const auto Bytes = static_cast<std::int64_t>(Size);
+            t_LiveBytes -= Bytes;
+
+            if (node* pNode = t_pCurrent; pNode)
+            {
+                pNode->FoldJobs();
+                pNode->m_Live -= Bytes;
+            }
+        }
+
+        // Adds the live bytes of the thread to the process wide count and returns it
+        inline std::int64_t FlushLiveBytes(void) noexcept
+        {
+            const auto Bytes = t_LiveBytes;
+            t_LiveBytes = 0;
+            return g_LiveBytes.fetch_add(Bytes, std::memory_order_relaxed) + Bytes;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    struct event
+    {
+        std::string             m_Name;
+        const char*             m_pCategory;
+        std::uint64_t           m_StartUS;
+        std::uint64_t           m_DurationUS;
+        std::size_t             m_ThreadID;
+        std::uint64_t           m_nTriangles;
+        std::uint64_t           m_nVertices;
+        std::uint64_t           m_AllocatedBytes;       // Inside the scope and its children
+        std::int64_t            m_PeakBytes;            // Most bytes the scope and its children had live at once
+        std::int64_t            m_LiveBytes;            // Process wide when the scope ended
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    class recorder
+    {
+    public:
+
+        void Begin(void) noexcept
+        {
+            std::scoped_lock Lock(m_Mutex);
+            m_Events.clear();
+            m_Origin = std::chrono::steady_clock::now();
+        }
+
+        std::uint64_t getTimeUS(void) const noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_Origin).count());
+        }
+
+        void Add(event&& Event) noexcept
+        {
+            std::scoped_lock Lock(m_Mutex);
+            m_Events.push_back(std::move(Event));
+        }
+
+        // Innermost stage scope, the parent of the jobs that open on other threads
+        std::atomic<alloc::node*>& getStage(void) noexcept
+        {
+            return m_pStage;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Writes the events as a JSON array of complete events plus a memory counter track
+        //--------------------------------------------------------------------------------------
+        bool Save(const std::wstring& Path) noexcept
+        {
+            std::scoped_lock Lock(m_Mutex);
+
+            std::ofstream File(std::filesystem::path(Path), std::ios::trunc);
+            if (!File) return false;
+
+            auto Escape = [](std::string_view S)
+            {
+                std::string Out;
+                Out.reserve(S.size());
+                for (char c : S)
+                {
+                    if (c == '"' || c == '\\')                 { Out += '\\'; Out += c; }
+                    else if (static_cast<unsigned char>(c) < 32) Out += ' ';
+                    else                                         Out += c;
+                }
+                return Out;
+            };
+
+            File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            for (std::size_t i = 0; i < m_Events.size(); ++i)
+            {
+                const auto& E = m_Events[i];
+                File << (i ? ",\n" : "")
+                     << "{\"name\":\"" << Escape(E.m_Name) << "\",\"cat\":\"" << E.m_pCategory << "\",\"ph\":\"X\",\"pid\":1"
+                     << ",\"tid\":"     << E.m_ThreadID
+                     << ",\"ts\":"      << E.m_StartUS
+                     << ",\"dur\":"     << E.m_DurationUS
+                     << ",\"args\":{\"triangles\":" << E.m_nTriangles
+                     << ",\"vertices\":"            << E.m_nVertices
+                     << ",\"allocated_bytes\":"     << E.m_AllocatedBytes
+                     << ",\"live_bytes\":"          << E.m_LiveBytes
+                     << ",\"peak_bytes\":"          << E.m_PeakBytes
+                     << "}}";
+
+                File << ",\n{\"name\":\"Memory\",\"ph\":\"C\",\"pid\":1,\"ts\":" << (E.m_StartUS + E.m_DurationUS)
+                     << ",\"args\":{\"live_bytes\":" << E.m_LiveBytes << "}}";
+            }
+            File << "\n]}\n";
+
+            return static_cast<bool>(File);
+        }
+
+    private:
+
+        std::mutex                                  m_Mutex     = {};
+        std::vector<event>                          m_Events    = {};
+        std::chrono::steady_clock::time_point       m_Origin    = std::chrono::steady_clock::now();
+        std::atomic<alloc::node*>                   m_pStage    = nullptr;
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Records one event from construction to destruction. The counts can be filled in at any
+    // point before the scope ends (usually once the stage knows what it produced). A scope is
+    // the child of the open scope of its thread (for the same recorder) or else of the current
+    // stage of the recorder, and the scopes of the "stage" category become the current stage.
+    //--------------------------------------------------------------------------------------
+    class scope
+    {
+    public:
+
+        scope(recorder& Recorder, std::string Name, const char* pCategory = "stage") noexcept
+            : m_Recorder        { Recorder }
+            , m_Name            { std::move(Name) }
+            , m_pCategory       { pCategory }
+            , m_StartUS         { Recorder.getTimeUS() }
+            , m_pPrevious       { alloc::t_pCurrent }
+            , m_pPreviousStage  { Recorder.getStage().load(std::memory_order_relaxed) }
+        {
+            m_Node.m_pRecorder = &Recorder;
+            m_Node.m_pParent   = (m_pPrevious && m_pPrevious->m_pRecorder == &Recorder) ? m_pPrevious : m_pPreviousStage;
+            m_bStage           = std::string_view(pCategory) == "stage";
+
+            alloc::FlushLiveBytes();
+            alloc::t_pCurrent = &m_Node;
+            if (m_bStage) Recorder.getStage().store(&m_Node, std::memory_order_relaxed);
+        }
+
+        scope(const scope&)                 = delete;
+        scope& operator = (const scope&)    = delete;
+
+        ~scope(void) noexcept
+        {
+            // Close the node first so recording the event is not counted in it
+            m_Node.FoldJobs();
+            alloc::t_pCurrent = m_pPrevious;
+            if (m_bStage) m_Recorder.getStage().store(m_pPreviousStage, std::memory_order_relaxed);
+
+            // The parent is either the previous scope of this thread or the stage of a job
+            if (auto* pParent = m_Node.m_pParent; pParent)
+            {
+                if (pParent == m_pPrevious) pParent->Add   (m_Node.m_Allocated, m_Node.m_Live, m_Node.m_Peak);
+                else                        pParent->AddJob(m_Node.m_Allocated, m_Node.m_Live, m_Node.m_Peak);
+            }
+
+            const auto LiveBytes = alloc::FlushLiveBytes();
+
+            m_Recorder.Add(event
+            { .m_Name           = std::move(m_Name)
+            , .m_pCategory      = m_pCategory
+            , .m_StartUS        = m_StartUS
+            , .m_DurationUS     = m_Recorder.getTimeUS() - m_StartUS
+            , .m_ThreadID       = std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xffffff
+            , .m_nTriangles     = m_nTriangles
+            , .m_nVertices      = m_nVertices
+            , .m_AllocatedBytes = m_Node.m_Allocated
+            , .m_PeakBytes      = m_Node.m_Peak
+            , .m_LiveBytes      = LiveBytes
+            });
+        }
+
+        void setCounts(std::uint64_t nTriangles, std::uint64_t nVertices) noexcept
+        {
+            m_nTriangles = nTriangles;
+            m_nVertices  = nVertices;
+        }
+
+    private:
+
+        recorder&           m_Recorder;
+        std::string         m_Name;
+        const char*         m_pCategory;
+        std::uint64_t       m_StartUS;
+        alloc::node         m_Node              = {};
+        alloc::node*        m_pPrevious;                    // Open scope of the thread before this one
+        alloc::node*        m_pPreviousStage;
+        bool                m_bStage            = false;
+        std::uint64_t       m_nTriangles        = 0;
+        std::uint64_t       m_nVertices         = 0;
+    };
+}
+
+#endif
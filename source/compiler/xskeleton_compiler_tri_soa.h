@@ -0,0 +1,448 @@
+#ifndef XSKELETON_COMPILER_TRI_SOA_H
+#define XSKELETON_COMPILER_TRI_SOA_H
+#pragma once
+
+#include <array>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XSKELETON_TRI_SOA_SSE2
+#endif
+
+//
+// Triangles of a submesh LOD as used while clustering. Every triangle keeps its id, its centroid
+// and its min/max for positions (XYZ) and UV0 (UV). There are two copies of the ids: a partition
+// reads a range from one buffer and writes both sides into the other one (so there is no copy
+// back), and the bounds of both sides are reduced while partitioning so the next level does not
+// need to read the range again.
+//
+// With AVX2 the centroids and bounds are structure of arrays streams that move with the ids, so
+// every kernel runs 8 wide over contiguous ranges. Without AVX2 moving the 31 streams costs more
+// than it saves (there are no 8 wide permutes to left pack them), so only the ids move and the
+// centroid/bounds of a triangle are one cache line record read through its id, like the original
+// partition did with the vertices but with a single fetch per triangle.
+//
+namespace xgeom_static_compiler::tri_soa
+{
+    // Axis 0..2 are the position XYZ, 3..4 are UV0
+    inline static constexpr int axis_count_v = 5;
+
+    struct streams
+    {
+        std::uint32_t*                      m_Id;
+    #if defined(__AVX2__)
+        std::array<float*, axis_count_v>    m_Centroid;
+        std::array<float*, axis_count_v>    m_Min;
+        std::array<float*, axis_count_v>    m_Max;
+    #endif
+    };
+
+    // Centroid and bounds of one triangle (no AVX2 only), XYZ and U are together so they can be
+    // reduced as one SSE register
+    struct alignas(64) record
+    {
+        std::array<float, 4>    m_MinXYZU;
+        std::array<float, 4>    m_MaxXYZU;
+        std::array<float, 5>    m_Centroid;
+        float                   m_MinV;
+        float                   m_MaxV;
+    };
+
+    struct triangles
+    {
+        std::array<streams, 2>      m_Buffer        {};
+        std::uint32_t*              m_Dest          {};         // Right side of a partition before it is copied back (no AVX2 only)
+        std::vector<std::byte>      m_Storage       {};
+        std::vector<record>         m_Record        {};         // By triangle id (no AVX2 only)
+        std::size_t                 m_Count         {};
+
+        // All the streams live in one block. Each stream starts 64 bytes further (modulo 4K) than
+        // the previous one, otherwise every stream would have the same address bits at the same
+        // index and the loads/stores of a partition would keep aliasing each other.
+        void resize(std::size_t Count) noexcept
+        {
+        #if defined(__AVX2__)
+            constexpr std::size_t   nStreams    = 2 * (1 + 3 * axis_count_v);
+        #else
+            constexpr std::size_t   nStreams    = 2 + 1;
+            m_Record.resize(Count);
+        #endif
+            const std::size_t       Stride      = (((Count + 1023) & ~std::size_t{ 1023 }) + 16) * sizeof(float);
+
+            m_Count = Count;
+            m_Storage.resize(Stride * nStreams + 64);
+
+            // Start the block at a 64 byte boundary
+            std::byte* pNext = m_Storage.data() + ((64 - (reinterpret_cast<std::uintptr_t>(m_Storage.data()) & 63)) & 63);
+            auto       Take  = [&]<typename T>(T*& p) { p = reinterpret_cast<T*>(pNext); pNext += Stride; };
+
+            for (auto& B : m_Buffer)
+            {
+                Take(B.m_Id);
+            #if defined(__AVX2__)
+                for (int a = 0; a < axis_count_v; ++a)
+                {
+                    Take(B.m_Centroid[a]);
+                    Take(B.m_Min[a]);
+                    Take(B.m_Max[a]);
+                }
+            #endif
+            }
+        #if !defined(__AVX2__)
+            Take(m_Dest);
+        #endif
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Fills triangle i of the first buffer (its id is i), axis are XYZ followed by UV
+        //--------------------------------------------------------------------------------------
+        void Set(std::uint32_t i, const std::array<float, axis_count_v>& Centroid, const std::array<float, axis_count_v>& Min, const std::array<float, axis_count_v>& Max) noexcept
+        {
+            auto& B = m_Buffer[0];
+            B.m_Id[i] = i;
+        #if defined(__AVX2__)
+            for (int a = 0; a < axis_count_v; ++a)
+            {
+                B.m_Centroid[a][i] = Centroid[a];
+                B.m_Min[a][i]      = Min[a];
+                B.m_Max[a][i]      = Max[a];
+            }
+        #else
+            auto& R = m_Record[i];
+            for (int a = 0; a < 4; ++a)
+            {
+                R.m_MinXYZU[a] = Min[a];
+                R.m_MaxXYZU[a] = Max[a];
+            }
+            R.m_Centroid = Centroid;
+            R.m_MinV     = Min[4];
+            R.m_MaxV     = Max[4];
+        #endif
+        }
+
+        std::size_t size(void) const noexcept { return m_Count; }
+    };
+
+    struct bounds
+    {
+        std::array<float, axis_count_v> m_Min;
+        std::array<float, axis_count_v> m_Max;
+
+        static constexpr bounds Empty(void) noexcept
+        {
+            bounds B{};
+            B.m_Min.fill(std::numeric_limits<float>::max());
+            B.m_Max.fill(std::numeric_limits<float>::lowest());
+            return B;
+        }
+    };
+
+    namespace details
+    {
+    #if defined(__AVX2__)
+        //--------------------------------------------------------------------------------------
+
+        inline float ReduceMin(const float* p, std::uint32_t Begin, std::uint32_t End) noexcept
+        {
+            float           Result = std::numeric_limits<float>::max();
+            std::uint32_t   i      = Begin;
+            __m256          V      = _mm256_set1_ps(Result);
+            for (; i + 8 <= End; i += 8) V = _mm256_min_ps(V, _mm256_loadu_ps(p + i));
+            __m128 H = _mm_min_ps(_mm256_castps256_ps128(V), _mm256_extractf128_ps(V, 1));
+            H = _mm_min_ps(H, _mm_movehl_ps(H, H));
+            H = _mm_min_ss(H, _mm_shuffle_ps(H, H, 1));
+            Result = _mm_cvtss_f32(H);
+            for (; i < End; ++i) Result = std::min(Result, p[i]);
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        inline float ReduceMax(const float* p, std::uint32_t Begin, std::uint32_t End) noexcept
+        {
+            float           Result = std::numeric_limits<float>::lowest();
+            std::uint32_t   i      = Begin;
+            __m256          V      = _mm256_set1_ps(Result);
+            for (; i + 8 <= End; i += 8) V = _mm256_max_ps(V, _mm256_loadu_ps(p + i));
+            __m128 H = _mm_max_ps(_mm256_castps256_ps128(V), _mm256_extractf128_ps(V, 1));
+            H = _mm_max_ps(H, _mm_movehl_ps(H, H));
+            H = _mm_max_ss(H, _mm_shuffle_ps(H, H, 1));
+            Result = _mm_cvtss_f32(H);
+            for (; i < End; ++i) Result = std::max(Result, p[i]);
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        inline std::uint32_t CountLess(const float* p, std::uint32_t Begin, std::uint32_t End, float Split) noexcept
+        {
+            std::uint32_t   Count = 0;
+            std::uint32_t   i     = Begin;
+            const __m256    S     = _mm256_set1_ps(Split);
+            for (; i + 8 <= End; i += 8) Count += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + i), S, _CMP_LT_OQ))));
+            for (; i < End; ++i) Count += p[i] < Split;
+            return Count;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Permutations that move the lanes selected by an 8 bit mask to the front, keeping their order
+        //--------------------------------------------------------------------------------------
+        struct left_pack_table
+        {
+            alignas(32) std::array<std::array<std::int32_t, 8>, 256> m_Perm;
+
+            constexpr left_pack_table() noexcept : m_Perm{}
+            {
+                for (int Mask = 0; Mask < 256; ++Mask)
+                {
+                    int n = 0;
+                    for (int b = 0; b < 8; ++b) if (Mask & (1 << b))    m_Perm[Mask][n++] = b;
+                    for (int b = 0; b < 8; ++b) if (!(Mask & (1 << b))) m_Perm[Mask][n++] = b;
+                }
+            }
+        };
+
+        inline static constexpr left_pack_table left_pack_v{};
+
+        //--------------------------------------------------------------------------------------
+        // Writes the 8 lanes to both sides. The lanes past the real count are garbage that later
+        // stores overwrite (see Partition for the one place where that is not true)
+        //--------------------------------------------------------------------------------------
+        template< typename T >
+        inline void PackStream(T* pLeft, T* pRight, __m256i V, __m256i LeftPerm, __m256i RightPerm) noexcept
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pLeft),  _mm256_permutevar8x32_epi32(V, LeftPerm));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pRight), _mm256_permutevar8x32_epi32(V, RightPerm));
+        }
+    #else
+        //--------------------------------------------------------------------------------------
+        // Running bounds of a set of records
+        //--------------------------------------------------------------------------------------
+        struct record_bounds
+        {
+        #if defined(XSKELETON_TRI_SOA_SSE2)
+            __m128  m_MinXYZU = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128  m_MaxXYZU = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        #else
+            bounds  m_Bounds  = bounds::Empty();
+        #endif
+            float   m_MinV    = std::numeric_limits<float>::max();
+            float   m_MaxV    = std::numeric_limits<float>::lowest();
+
+            void Add(const record& R) noexcept
+            {
+            #if defined(XSKELETON_TRI_SOA_SSE2)
+                m_MinXYZU = _mm_min_ps(m_MinXYZU, _mm_load_ps(R.m_MinXYZU.data()));
+                m_MaxXYZU = _mm_max_ps(m_MaxXYZU, _mm_load_ps(R.m_MaxXYZU.data()));
+            #else
+                for (int a = 0; a < 4; ++a)
+                {
+                    m_Bounds.m_Min[a] = std::min(m_Bounds.m_Min[a], R.m_MinXYZU[a]);
+                    m_Bounds.m_Max[a] = std::max(m_Bounds.m_Max[a], R.m_MaxXYZU[a]);
+                }
+            #endif
+                m_MinV = std::min(m_MinV, R.m_MinV);
+                m_MaxV = std::max(m_MaxV, R.m_MaxV);
+            }
+
+            bounds get(void) const noexcept
+            {
+            #if defined(XSKELETON_TRI_SOA_SSE2)
+                bounds B;
+                alignas(16) float Min[4], Max[4];
+                _mm_store_ps(Min, m_MinXYZU);
+                _mm_store_ps(Max, m_MaxXYZU);
+                for (int a = 0; a < 4; ++a)
+                {
+                    B.m_Min[a] = Min[a];
+                    B.m_Max[a] = Max[a];
+                }
+            #else
+                bounds B = m_Bounds;
+            #endif
+                B.m_Min[4] = m_MinV;
+                B.m_Max[4] = m_MaxV;
+                return B;
+            }
+        };
+    #endif
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Min/Max of the triangle bounds for all the axis over [Begin, End) of one of the buffers
+    //--------------------------------------------------------------------------------------
+    inline bounds ComputeBounds(const triangles& Tris, int iBuffer, std::uint32_t Begin, std::uint32_t End) noexcept
+    {
+        const auto& Src = Tris.m_Buffer[iBuffer];
+    #if defined(__AVX2__)
+        bounds      B;
+        for (int a = 0; a < axis_count_v; ++a)
+        {
+            B.m_Min[a] = details::ReduceMin(Src.m_Min[a], Begin, End);
+            B.m_Max[a] = details::ReduceMax(Src.m_Max[a], Begin, End);
+        }
+        return B;
+    #else
+        details::record_bounds B;
+        for (std::uint32_t i = Begin; i < End; ++i) B.Add(Tris.m_Record[Src.m_Id[i]]);
+        return B.get();
+    #endif
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Stable partition of [Begin, End) by (Centroid[Axis] < Split). The triangles move from
+    // buffer iSrc to buffer 1 - iSrc, and the bounds of each side are returned in Left/Right.
+    // Returns the number of triangles that ended up on the left side.
+    //--------------------------------------------------------------------------------------
+    inline std::uint32_t Partition(triangles& Tris, int iSrc, std::uint32_t Begin, std::uint32_t End, int Axis, float Split, bounds& Left, bounds& Right) noexcept
+    {
+        const auto&         Src     = Tris.m_Buffer[iSrc];
+        auto&               Dst     = Tris.m_Buffer[1 - iSrc];
+
+    #if defined(__AVX2__)
+        const float*        pKey    = Src.m_Centroid[Axis];
+        const std::uint32_t nTotalL = details::CountLess(pKey, Begin, End, Split);
+        std::uint32_t       L       = Begin;
+        std::uint32_t       R       = Begin + nTotalL;
+        std::uint32_t       i       = Begin;
+
+        Left  = bounds::Empty();
+        Right = bounds::Empty();
+
+        {
+            const __m256    SplitV  = _mm256_set1_ps(Split);
+            const __m256    MaxV    = _mm256_set1_ps(std::numeric_limits<float>::max());
+            const __m256    LowV    = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+            __m256          LMin[axis_count_v], LMax[axis_count_v], RMin[axis_count_v], RMax[axis_count_v];
+
+            for (int a = 0; a < axis_count_v; ++a)
+            {
+                LMin[a] = RMin[a] = MaxV;
+                LMax[a] = RMax[a] = LowV;
+            }
+
+            // Full 8 wide stores: the right side never goes past End because of the loop condition,
+            // and its garbage lanes land on right slots that are written later. The left side
+            // garbage lanes can only land on the first 8 slots of the right side, which are
+            // fixed after the loop.
+            for (; i + 8 <= End && R + 8 <= End; i += 8)
+            {
+                const __m256    IsLeft      = _mm256_cmp_ps(_mm256_loadu_ps(pKey + i), SplitV, _CMP_LT_OQ);
+                const int       Mask        = _mm256_movemask_ps(IsLeft);
+                const int       nL          = std::popcount(static_cast<unsigned>(Mask));
+                const __m256i   LeftPerm    = _mm256_load_si256(reinterpret_cast<const __m256i*>(details::left_pack_v.m_Perm[Mask].data()));
+                const __m256i   RightPerm   = _mm256_load_si256(reinterpret_cast<const __m256i*>(details::left_pack_v.m_Perm[(~Mask) & 0xff].data()));
+
+                details::PackStream(Dst.m_Id + L, Dst.m_Id + R, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Src.m_Id + i)), LeftPerm, RightPerm);
+
+                for (int a = 0; a < axis_count_v; ++a)
+                {
+                    const __m256 C  = _mm256_loadu_ps(Src.m_Centroid[a] + i);
+                    const __m256 Mn = _mm256_loadu_ps(Src.m_Min[a] + i);
+                    const __m256 Mx = _mm256_loadu_ps(Src.m_Max[a] + i);
+
+                    details::PackStream(Dst.m_Centroid[a] + L, Dst.m_Centroid[a] + R, _mm256_castps_si256(C),  LeftPerm, RightPerm);
+                    details::PackStream(Dst.m_Min[a]      + L, Dst.m_Min[a]      + R, _mm256_castps_si256(Mn), LeftPerm, RightPerm);
+                    details::PackStream(Dst.m_Max[a]      + L, Dst.m_Max[a]      + R, _mm256_castps_si256(Mx), LeftPerm, RightPerm);
+
+                    LMin[a] = _mm256_min_ps(LMin[a], _mm256_blendv_ps(MaxV, Mn, IsLeft));
+                    LMax[a] = _mm256_max_ps(LMax[a], _mm256_blendv_ps(LowV, Mx, IsLeft));
+                    RMin[a] = _mm256_min_ps(RMin[a], _mm256_blendv_ps(Mn, MaxV, IsLeft));
+                    RMax[a] = _mm256_max_ps(RMax[a], _mm256_blendv_ps(Mx, LowV, IsLeft));
+                }
+
+                L += nL;
+                R += 8 - nL;
+            }
+
+            for (int a = 0; a < axis_count_v; ++a)
+            {
+                alignas(32) float Tmp[4][8];
+                _mm256_store_ps(Tmp[0], LMin[a]);
+                _mm256_store_ps(Tmp[1], LMax[a]);
+                _mm256_store_ps(Tmp[2], RMin[a]);
+                _mm256_store_ps(Tmp[3], RMax[a]);
+                for (int k = 0; k < 8; ++k)
+                {
+                    Left.m_Min[a]  = std::min(Left.m_Min[a],  Tmp[0][k]);
+                    Left.m_Max[a]  = std::max(Left.m_Max[a],  Tmp[1][k]);
+                    Right.m_Min[a] = std::min(Right.m_Min[a], Tmp[2][k]);
+                    Right.m_Max[a] = std::max(Right.m_Max[a], Tmp[3][k]);
+                }
+            }
+        }
+
+        // Restore the first right side slots that the left side garbage may have overwritten
+        {
+            const std::uint32_t RightBegin = Begin + nTotalL;
+            const std::uint32_t nFix       = std::min<std::uint32_t>(8, R - RightBegin);
+            for (std::uint32_t s = Begin, d = RightBegin; d < RightBegin + nFix; ++s)
+            {
+                if (pKey[s] < Split) continue;
+
+                Dst.m_Id[d] = Src.m_Id[s];
+                for (int a = 0; a < axis_count_v; ++a)
+                {
+                    Dst.m_Centroid[a][d] = Src.m_Centroid[a][s];
+                    Dst.m_Min[a][d]      = Src.m_Min[a][s];
+                    Dst.m_Max[a][d]      = Src.m_Max[a][s];
+                }
+                ++d;
+            }
+        }
+
+        for (; i < End; ++i)
+        {
+            const bool      bLeft   = pKey[i] < Split;
+            const auto      d       = bLeft ? L++ : R++;
+            auto&           Side    = bLeft ? Left : Right;
+
+            Dst.m_Id[d] = Src.m_Id[i];
+            for (int a = 0; a < axis_count_v; ++a)
+            {
+                Dst.m_Centroid[a][d] = Src.m_Centroid[a][i];
+                Dst.m_Min[a][d]      = Src.m_Min[a][i];
+                Dst.m_Max[a][d]      = Src.m_Max[a][i];
+                Side.m_Min[a]        = std::min(Side.m_Min[a], Src.m_Min[a][i]);
+                Side.m_Max[a]        = std::max(Side.m_Max[a], Src.m_Max[a][i]);
+            }
+        }
+
+        return nTotalL;
+    #else
+        // One pass over the records: the left ids are compacted into the destination and the
+        // right ids go to m_Dest, both are written every time so there is no branch on the side
+        details::record_bounds  LeftBounds, RightBounds;
+        std::uint32_t           nL = 0;
+        std::uint32_t           nR = 0;
+        for (std::uint32_t i = Begin; i < End; ++i)
+        {
+            const std::uint32_t Id      = Src.m_Id[i];
+            const auto&         Record  = Tris.m_Record[Id];
+            const bool          bLeft   = Record.m_Centroid[Axis] < Split;
+
+            Dst.m_Id[Begin + nL] = Id;
+            Tris.m_Dest[nR]      = Id;
+            nL +=  bLeft;
+            nR += !bLeft;
+
+            (bLeft ? LeftBounds : RightBounds).Add(Record);
+        }
+        std::copy_n(Tris.m_Dest, nR, Dst.m_Id + Begin + nL);
+
+        Left  = LeftBounds.get();
+        Right = RightBounds.get();
+        return nL;
+    #endif
+    }
+}
+
+#endif
@@ -4,13 +4,20 @@
 
 #include "dependencies/xmath/source/xmath_fshapes.h"
 #include "dependencies/xserializer/source/xserializer.h"
+#include "xskeleton_skeleton.h"
 #include <span>  // Add for std::span
+#include <cassert>
+#include <bit>
+#include <new>
+#include <type_traits>
 
 namespace xgeom_static
 {
     struct geom
     {
-        inline static constexpr auto xserializer_version_v = 1;
+        inline static constexpr auto xserializer_version_v = 12;
+        inline static constexpr auto arena_alignment_v     = std::align_val_t{ 64 };
+        inline static constexpr auto invalid_index_v       = std::uint16_t{ 0xffff };
         struct mesh
         {
             std::array<char, 32>    m_Name;
@@ -22,16 +29,22 @@ namespace xgeom_static
 
         struct lod
         {
-            float                   m_ScreenArea;
+            float                   m_ScreenArea;       // Pixels covered by the mesh bbox diagonal under which this LOD can be used
+            float                   m_GeometricError;   // Simplification error in world units compared to LOD 0
             std::uint16_t           m_iSubmesh;         // Start the submeshes
             std::uint16_t           m_nSubmesh;
+            std::uint32_t           m_iVertex;          // Page of the LOD: all its vertices/extras and indices are in these ranges
+            std::uint32_t           m_nVertices;        // (each range starts on a cache line, see lod_pager)
+            std::uint32_t           m_iIndex;
+            std::uint32_t           m_nIndices;
         };
 
         struct submesh
         {
-            std::uint16_t           m_iCluster;         // Where the index starts
-            std::uint16_t           m_nCluster;         // Where the index starts
+            std::uint32_t           m_iCluster;         // Where the clusters start
+            std::uint32_t           m_nCluster;         // Number of clusters (meshlets can produce a lot of them)
             std::uint16_t           m_iMaterial;        // Index of the Material that this SubMesh uses
+            std::uint16_t           m_Padding = 0;      // The tables are saved as raw memory (see table_io), so no byte can be left undefined
         };
 
         struct vec3
@@ -55,10 +68,14 @@ namespace xgeom_static
             vec4                    m_PosTrasnlationAndVScale;  // XYZ scale for the cluster, W = V Scale
             vec2                    m_UVTranslation;            // UV Translation.            
             xmath::fbbox            m_BBox;                     // Optional fine-grained CPU culling (e.g., per-cluster frustum/occlusion)
+            vec4                    m_BoundingSphere;           // XYZ center, W radius
+            vec4                    m_NormalCone;               // XYZ axis, W cutoff. Backface culled when dot(Center - Eye, Axis) >= W * |Center - Eye| + Radius (W >= 1 never culls)
             std::uint32_t           m_iIndex;                   // Where the index starts
             std::uint32_t           m_nIndices;                 // number of
             std::uint32_t           m_iVertex;                  // Where the vertex starts
             std::uint32_t           m_nVertices;                // number of
+            std::uint32_t           m_iBone;                    // Where the bone palette starts in m_pClusterBone
+            std::uint32_t           m_nBones;                   // number of (0 for a static geom)
         };
 
         struct vertex
@@ -74,7 +91,25 @@ namespace xgeom_static
             std::array<std::uint8_t, 2>     m_OctTangent;
         };
 
-        using runtime_allocation = std::array<std::size_t, 3*2>;
+        // Up to 4 influences, m_iBone indexes the bone palette of the cluster (not the skeleton)
+        // and the weights are UNORM8 that add up to 255, unused influences have a weight of 0
+        struct vertex_skin
+        {
+            std::array<std::uint8_t, 4>     m_iBone;
+            std::array<std::uint8_t, 4>     m_Weight;
+        };
+
+        using runtime_allocation = std::array<std::size_t, 4*2>;        // Vertex, vertex extras, index and vertex skin buffers
+
+        enum class index_encoding : std::uint8_t
+        { RAW                                           // uint16 indices
+        , MESHOPT                                       // Per cluster meshopt streams (see xskeleton_index_codec.h)
+        };
+
+        enum class vertex_encoding : std::uint8_t
+        { RAW                                           // vertex / vertex_extras arrays
+        , MESHOPT                                       // Chunked meshopt streams (see xskeleton_vertex_codec.h)
+        };
 
         //-------------------------------------------------------------------------
 
@@ -84,34 +119,53 @@ namespace xgeom_static
         inline void                                     Initialize                  (void)                                      noexcept;
         inline int                                      findMeshIndex               (const char* pName)                 const   noexcept;
         inline int                                      getSubMeshIndex             (int iMesh, int iMaterialInstance)  const   noexcept;
+        inline int                                      getLODSubMeshIndex          (int iLOD, int iMaterialInstance)   const   noexcept;
+        constexpr static std::uint32_t                  HashMeshName                (const char* pName)                         noexcept;
+        constexpr static std::uint32_t                  getMeshHashSlot             (std::uint32_t Hash, std::uint16_t Seed)    noexcept;
         inline std::span<mesh>                          getMeshes                   (void)                              const   noexcept { return { m_pMesh, m_nMeshes }; }
         inline std::span<lod>                           getLODs                     (void)                              const   noexcept { return { m_pLOD, m_nLODs }; }
         inline std::span<submesh>                       getSubmeshes                (void)                              const   noexcept { return { m_pSubMesh, m_nSubMeshs }; }
         inline std::span<cluster>                       getClusters                 (void)                              const   noexcept { return { m_pCluster, m_nClusters }; }
-        inline std::span<vertex>                        getVertices                 (void)                              const   noexcept { return { reinterpret_cast<vertex*>(m_pData + m_VertexOffset), m_nVertices }; }
-        inline std::span<vertex_extras>                 getVertexExtras             (void)                              const   noexcept { return { reinterpret_cast<vertex_extras*>(m_pData + m_VertexExtrasOffset), m_nVertices }; }
-        inline std::span<std::uint16_t>                 getIndices                  (void)                              const   noexcept { return { reinterpret_cast<std::uint16_t*>(m_pData + m_IndicesOffset), m_nIndices }; }
+        inline std::span<vertex>                        getVertices                 (void)                              const   noexcept { assert(m_VertexEncoding == vertex_encoding::RAW); return { reinterpret_cast<vertex*>(m_pData + m_VertexOffset), m_nVertices }; }
+        inline std::span<vertex_extras>                 getVertexExtras             (void)                              const   noexcept { assert(m_VertexExtrasEncoding == vertex_encoding::RAW); return { reinterpret_cast<vertex_extras*>(m_pData + m_VertexExtrasOffset), m_nVertices }; }
+        inline std::span<std::uint16_t>                 getIndices                  (void)                              const   noexcept { assert(m_IndexEncoding == index_encoding::RAW); return { reinterpret_cast<std::uint16_t*>(m_pData + m_IndicesOffset), m_nIndices }; }
+        inline std::span<vertex_skin>                   getVertexSkins              (void)                              const   noexcept { return { reinterpret_cast<vertex_skin*>(m_pData + m_VertexSkinOffset), isSkinned() ? m_nVertices : 0u }; }
+        inline std::span<std::uint16_t>                 getClusterBones             (const cluster& Cluster)            const   noexcept { return { m_pClusterBone + Cluster.m_iBone, Cluster.m_nBones }; }
+        inline bool                                     isSkinned                   (void)                              const   noexcept { return m_nClusterBones != 0; }
         inline std::span<xrsc::material_instance_ref>   getDefaultMaterialInstances (void)                              const   noexcept { return { m_pDefaultMaterialInstances, m_nDefaultMaterialInstances }; }
 
         xmath::fbbox                    m_BBox;
-        char*                           m_pData;  // Contiguous buffer for GPU data ( vertices, extras, indices)
+        char*                           m_pData;  // Contiguous buffer for GPU data ( vertices, extras, indices, skins)
+        void*                           m_pBlob;  // Set when the tables live inside a flat blob (see xskeleton_blob.h), handle of whoever owns it
+        std::byte*                      m_pArena; // Set when all the tables are in a single allocation (see blob::AllocateArena), owned by the geom
         mesh*                           m_pMesh;  // Separate allocations for CPU-persistent data
         lod*                            m_pLOD;
         submesh*                        m_pSubMesh;
         cluster*                        m_pCluster;
         xrsc::material_instance_ref*    m_pDefaultMaterialInstances;
+        std::uint16_t*                  m_pLookup;  // Mesh name hash (bucket seeds then slots) followed by the [LOD][material instance] -> submesh table
+        std::uint16_t*                  m_pClusterBone; // Bone palettes of the clusters, skeleton bone of every entry
         runtime_allocation              m_RunTimeSpace;
         std::size_t                     m_DataSize;
         std::size_t                     m_VertexOffset;
         std::size_t                     m_VertexExtrasOffset;
         std::size_t                     m_IndicesOffset;
+        std::size_t                     m_VertexSkinOffset;     // vertex_skin array, always RAW (empty for a static geom)
         std::uint16_t                   m_nMeshes;
         std::uint16_t                   m_nLODs;
         std::uint16_t                   m_nSubMeshs;
-        std::uint16_t                   m_nClusters;
+        std::uint32_t                   m_nClusters;
         std::uint32_t                   m_nIndices;
         std::uint32_t                   m_nVertices;
         std::uint16_t                   m_nDefaultMaterialInstances;
+        std::uint32_t                   m_nLookup;
+        std::uint32_t                   m_nClusterBones;        // 0 for a static geom
+        std::uint32_t                   m_nMeshHashBuckets;     // Power of two (0 when there are no meshes)
+        std::uint32_t                   m_nMeshHashSlots;       // Power of two
+        index_encoding                  m_IndexEncoding;        // How the indices are stored in m_pData
+        vertex_encoding                 m_VertexEncoding;       // How the vertices are stored in m_pData
+        vertex_encoding                 m_VertexExtrasEncoding; // How the vertex extras are stored in m_pData
+        xskeleton::skeleton             m_Skeleton;             // Bones of the skinned meshes (m_nBones is 0 for a static geom)
     };
 
     //-------------------------------------------------------------------------
@@ -131,116 +185,136 @@ namespace xgeom_static
     //-------------------------------------------------------------------------
     void geom::Kill(void) noexcept
     {
+        // The tables of a blob belong to whoever mapped it
+        if (m_pBlob)
+        {
+            Initialize();
+            return;
+        }
+
+        // All the tables go away with the arena
+        if (m_pArena)
+        {
+            ::operator delete(m_pArena, arena_alignment_v);
+            Initialize();
+            return;
+        }
+
         if (m_pMesh)                        delete[] m_pMesh;
         if (m_pLOD)                         delete[] m_pLOD;
         if (m_pSubMesh)                     delete[] m_pSubMesh;
         if (m_pCluster)                     delete[] m_pCluster;
         if (m_pDefaultMaterialInstances)    delete[] m_pDefaultMaterialInstances;
+        if (m_pLookup)                      delete[] m_pLookup;
+        if (m_pClusterBone)                 delete[] m_pClusterBone;
         if (m_pData)                        delete[] m_pData;
 
+        if (m_Skeleton.m_pParent)           delete[] m_Skeleton.m_pParent;
+        if (m_Skeleton.m_pName)             delete[] m_Skeleton.m_pName;
+        if (m_Skeleton.m_pBindTranslation)  delete[] m_Skeleton.m_pBindTranslation;
+        if (m_Skeleton.m_pBindRotation)     delete[] m_Skeleton.m_pBindRotation;
+        if (m_Skeleton.m_pBindScale)        delete[] m_Skeleton.m_pBindScale;
+        if (m_Skeleton.m_pInverseBind)      delete[] m_Skeleton.m_pInverseBind;
+
         Initialize();
     }
 
     //-------------------------------------------------------------------------
 
-    int geom::findMeshIndex(const char* pName) const noexcept
+    // FNV-1a of the name, the compiler builds the mesh hash with the same function
+    constexpr std::uint32_t geom::HashMeshName(const char* pName) noexcept
     {
-        auto meshes = getMeshes();
-        for (auto i = 0u; i < meshes.size(); i++)
-        {
-            if (!std::strcmp(meshes[i].m_Name.data(), pName))
-            {
-                return i;
-            }
-        }
-        return -1;
+        std::uint32_t Hash = 2166136261u;
+        for (; *pName; ++pName) Hash = (Hash ^ static_cast<std::uint8_t>(*pName)) * 16777619u;
+        return Hash;
     }
-}
 
-//-------------------------------------------------------------------------
-// serializer
-//-------------------------------------------------------------------------
-namespace xserializer::io_functions
-{
     //-------------------------------------------------------------------------
-    template<> inline
-        xerr SerializeIO<xgeom_static::geom::lod>(xserializer::stream& Stream, const xgeom_static::geom::lod& Lod) noexcept
+    // Slot of a name inside the hash given the seed of its bucket (the seeds are chosen by the
+    // compiler so that no two meshes share a slot)
+    //-------------------------------------------------------------------------
+    constexpr std::uint32_t geom::getMeshHashSlot(std::uint32_t Hash, std::uint16_t Seed) noexcept
     {
-        xerr Err;
-        false
-            || (Err = Stream.Serialize(Lod.m_ScreenArea))
-            || (Err = Stream.Serialize(Lod.m_iSubmesh))
-            || (Err = Stream.Serialize(Lod.m_nSubmesh))
-            ;
-        return Err;
+        Hash ^= (Seed + 1u) * 0x9E3779B9u;
+        Hash ^= Hash >> 16;
+        Hash *= 0x85EBCA6Bu;
+        Hash ^= Hash >> 13;
+        Hash *= 0xC2B2AE35u;
+        Hash ^= Hash >> 16;
+        return Hash;
     }
 
     //-------------------------------------------------------------------------
-    template<> inline
-    xerr SerializeIO<xgeom_static::geom::mesh>(xserializer::stream& Stream, const xgeom_static::geom::mesh& Mesh) noexcept
+    // Perfect hash: one seed lookup, one slot lookup and a single strcmp to reject unknown names
+    //-------------------------------------------------------------------------
+    int geom::findMeshIndex(const char* pName) const noexcept
     {
-        xerr Err;
-        false
-            || (Err = Stream.Serialize(Mesh.m_Name))
-            || (Err = Stream.Serialize(Mesh.m_WorldPixelSize))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_X))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_Y))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Min.m_Z))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_X))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_Y))
-            || (Err = Stream.Serialize(Mesh.m_BBox.m_Max.m_Z))
-            || (Err = Stream.Serialize(Mesh.m_nLODs))
-            || (Err = Stream.Serialize(Mesh.m_iLOD))
-            ;
-        return Err;
+        if (m_nMeshHashBuckets == 0) return -1;
+
+        const auto Hash  = HashMeshName(pName);
+        const auto Seed  = m_pLookup[Hash & (m_nMeshHashBuckets - 1)];
+        const auto iMesh = m_pLookup[m_nMeshHashBuckets + (getMeshHashSlot(Hash, Seed) & (m_nMeshHashSlots - 1))];
+
+        if (iMesh == invalid_index_v || std::strcmp(m_pMesh[iMesh].m_Name.data(), pName)) return -1;
+        return iMesh;
     }
 
     //-------------------------------------------------------------------------
-    template<> inline
-    xerr SerializeIO<xgeom_static::geom::submesh>(xserializer::stream& Stream, const xgeom_static::geom::submesh& Submesh) noexcept
+    // Submesh of the most detailed LOD of the mesh that uses the material instance, -1 if none
+    //-------------------------------------------------------------------------
+    int geom::getSubMeshIndex(int iMesh, int iMaterialInstance) const noexcept
     {
-        xerr Err;
-        false
-            || (Err = Stream.Serialize(Submesh.m_iCluster))
-            || (Err = Stream.Serialize(Submesh.m_nCluster))
-            || (Err = Stream.Serialize(Submesh.m_iMaterial))
-            ;
-        return Err;
+        return getLODSubMeshIndex(m_pMesh[iMesh].m_iLOD, iMaterialInstance);
     }
 
     //-------------------------------------------------------------------------
-    template<> inline
-    xerr SerializeIO<xgeom_static::geom::cluster>(xserializer::stream& Stream, const xgeom_static::geom::cluster& Cluster) noexcept
+
+    int geom::getLODSubMeshIndex(int iLOD, int iMaterialInstance) const noexcept
     {
-        xerr Err;
-        false
-            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_X))
-            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_Y))
-            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_Z))
-            || (Err = Stream.Serialize(Cluster.m_PosScaleAndUScale.m_W))
-
-            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_X))
-            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_Y))
-            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_Z))
-            || (Err = Stream.Serialize(Cluster.m_PosTrasnlationAndVScale.m_W))
-
-            || (Err = Stream.Serialize(Cluster.m_UVTranslation.m_X))
-            || (Err = Stream.Serialize(Cluster.m_UVTranslation.m_Y))
-
-            || (Err = Stream.Serialize(Cluster.m_nVertices))
-            || (Err = Stream.Serialize(Cluster.m_nIndices))
-            || (Err = Stream.Serialize(Cluster.m_iIndex))
-            || (Err = Stream.Serialize(Cluster.m_iVertex))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_X))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_Y))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Min.m_Z))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_X))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_Y))
-            || (Err = Stream.Serialize(Cluster.m_BBox.m_Max.m_Z))
-            ;
-        return Err;
+        const auto iSubmesh = m_pLookup[m_nMeshHashBuckets + m_nMeshHashSlots + std::size_t(iLOD) * m_nDefaultMaterialInstances + iMaterialInstance];
+        return iSubmesh == invalid_index_v ? -1 : iSubmesh;
+    }
+}
+
+//-------------------------------------------------------------------------
+// serializer
+//-------------------------------------------------------------------------
+namespace xgeom_static::table_io
+{
+    //-------------------------------------------------------------------------
+    // Writes a table as a single block with the layout of the runtime structure (little
+    // endian), so saving and loading it is one copy instead of a call per field. The block is
+    // an array of the unsigned word that matches the alignment of T (not of chars), so the
+    // serializer places the loaded table with at least the alignment that T needs.
+    // Since the padding of T would be saved too, the table structures have none (padding is
+    // an explicit zeroed field, see the asserts below); xserializer_version_v must change
+    // whenever one of the table structures does.
+    //-------------------------------------------------------------------------
+    template< std::size_t T_ALIGNMENT_V >
+    using table_word = std::conditional_t< T_ALIGNMENT_V >= 8, std::uint64_t
+                     , std::conditional_t< T_ALIGNMENT_V >= 4, std::uint32_t
+                     , std::conditional_t< T_ALIGNMENT_V >= 2, std::uint16_t
+                     , std::uint8_t >>>;
+
+    template< typename T > inline
+    xerr SerializeTable(xserializer::stream& Stream, T* const& pTable, std::size_t Count) noexcept
+    {
+        using word = table_word<alignof(T)>;
+
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(std::endian::native == std::endian::little, "The bulk tables are stored in little endian");
+        static_assert(alignof(T) <= alignof(word) && sizeof(T) % sizeof(word) == 0, "The table needs a wider word");
+        return Stream.Serialize(reinterpret_cast<word* const&>(pTable), Count * (sizeof(T) / sizeof(word)));
     }
 
+    static_assert(sizeof(geom::mesh)    == sizeof(std::array<char, 32>) + sizeof(float) + sizeof(xmath::fbbox) + 2 * sizeof(std::uint16_t), "geom::mesh has padding");
+    static_assert(sizeof(geom::lod)     == 2 * sizeof(float) + 2 * sizeof(std::uint16_t) + 4 * sizeof(std::uint32_t),                       "geom::lod has padding");
+    static_assert(sizeof(geom::submesh) == 2 * sizeof(std::uint32_t) + 2 * sizeof(std::uint16_t),                                           "geom::submesh has padding");
+    static_assert(sizeof(geom::cluster) == 4 * sizeof(geom::vec4) + sizeof(geom::vec2) + sizeof(xmath::fbbox) + 6 * sizeof(std::uint32_t),  "geom::cluster has padding");
+}
+
+namespace xserializer::io_functions
+{
     //-------------------------------------------------------------------------
     template<> inline
     xerr SerializeIO<xrsc::material_instance_ref>(xserializer::stream& Stream, const xrsc::material_instance_ref& IR) noexcept
@@ -255,15 +329,19 @@ namespace xserializer::io_functions
         xerr Err;
         false
             || (Err = Stream.Serialize(Geom.m_nMeshes))
-            || (Err = Stream.Serialize(Geom.m_pMesh,                        Geom.m_nMeshes))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pMesh,       Geom.m_nMeshes))
             || (Err = Stream.Serialize(Geom.m_nLODs))
-            || (Err = Stream.Serialize(Geom.m_pLOD,                         Geom.m_nLODs))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pLOD,        Geom.m_nLODs))
             || (Err = Stream.Serialize(Geom.m_nSubMeshs))
-            || (Err = Stream.Serialize(Geom.m_pSubMesh,                     Geom.m_nSubMeshs))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pSubMesh,    Geom.m_nSubMeshs))
             || (Err = Stream.Serialize(Geom.m_nClusters))
-            || (Err = Stream.Serialize(Geom.m_pCluster,                     Geom.m_nClusters))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pCluster,    Geom.m_nClusters))
             || (Err = Stream.Serialize(Geom.m_nDefaultMaterialInstances))
             || (Err = Stream.Serialize(Geom.m_pDefaultMaterialInstances,    Geom.m_nDefaultMaterialInstances))
+            || (Err = Stream.Serialize(Geom.m_nLookup))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pLookup,     Geom.m_nLookup))
+            || (Err = Stream.Serialize(Geom.m_nMeshHashBuckets))
+            || (Err = Stream.Serialize(Geom.m_nMeshHashSlots))
             || (Err = Stream.Serialize(Geom.m_DataSize))
             || (Err = Stream.Serialize(Geom.m_pData,                        Geom.m_DataSize))
             || (Err = Stream.Serialize(Geom.m_RunTimeSpace))
@@ -276,8 +354,22 @@ namespace xserializer::io_functions
             || (Err = Stream.Serialize(Geom.m_VertexOffset))
             || (Err = Stream.Serialize(Geom.m_VertexExtrasOffset))
             || (Err = Stream.Serialize(Geom.m_IndicesOffset))
+            || (Err = Stream.Serialize(Geom.m_VertexSkinOffset))
             || (Err = Stream.Serialize(Geom.m_nVertices))
             || (Err = Stream.Serialize(Geom.m_nIndices))
+            || (Err = Stream.Serialize(reinterpret_cast<const std::uint8_t&>(Geom.m_IndexEncoding)))
+            || (Err = Stream.Serialize(reinterpret_cast<const std::uint8_t&>(Geom.m_VertexEncoding)))
+            || (Err = Stream.Serialize(reinterpret_cast<const std::uint8_t&>(Geom.m_VertexExtrasEncoding)))
+            || (Err = Stream.Serialize(Geom.m_Skeleton.m_nBones))
+            || (Err = Stream.Serialize(Geom.m_Skeleton.m_nRoots))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pParent,          Geom.m_Skeleton.m_nBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pName,            Geom.m_Skeleton.m_nBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pBindTranslation, Geom.m_Skeleton.m_nBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pBindRotation,    Geom.m_Skeleton.m_nBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pBindScale,       Geom.m_Skeleton.m_nBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_Skeleton.m_pInverseBind,     Geom.m_Skeleton.m_nBones))
+            || (Err = Stream.Serialize(Geom.m_nClusterBones))
+            || (Err = xgeom_static::table_io::SerializeTable(Stream, Geom.m_pClusterBone,                Geom.m_nClusterBones))
             ;
         return Err;
     }
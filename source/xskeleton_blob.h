@@ -0,0 +1,524 @@
+#ifndef XSKELETON_BLOB_H
+#define XSKELETON_BLOB_H
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "xskeleton.h"
+
+//
+// Flat, self relative version of xgeom_static::geom. The whole resource is a single block that
+// holds offsets instead of pointers, so an uncompressed file can be memory mapped and used in
+// place: View validates the header and the tables and points a geom to them, the data block
+// (vertices, indices, ...) is not read and is paged in when it is first touched.
+//
+// Layout (little endian, every table starts at a 64 byte boundary):
+//      header
+//      geom::mesh[]
+//      geom::lod[]
+//      geom::submesh[]
+//      geom::cluster[]
+//      xrsc::material_instance_ref[]
+//      std::uint16_t[]                 - Same table as geom::m_pLookup (mesh name hash, submesh table)
+//      std::int16_t[]                  - Skeleton parents (see xskeleton_skeleton.h)
+//      skeleton::name[]
+//      skeleton::vec4[]                - Bind translations
+//      skeleton::vec4[]                - Bind rotations
+//      skeleton::vec4[]                - Bind scales
+//      skeleton::affine[]              - Inverse bind matrices
+//      std::uint16_t[]                 - Same table as geom::m_pClusterBone (cluster bone palettes)
+//      data                            - Same block as geom::m_pData (vertices, extras, indices, skins)
+//
+// The tables are raw copies of the runtime structures, so the header records their sizes and
+// the blob is rejected if they do not match. The material instance refs are resolved in place
+// by the resource manager, so the file must be mapped copy on write (see mapped_file).
+//
+namespace xgeom_static::blob
+{
+    enum class state : std::uint8_t
+    { OK
+    , FAILURE
+    };
+
+    inline static constexpr std::uint32_t           version_v       = 7;
+    inline static constexpr std::array<char, 8>     magic_v         = { 'X', 'S', 'K', 'G', 'E', 'O', 'M', '\0' };
+    inline static constexpr std::uint32_t           endian_tag_v    = 0x01020304;
+    inline static constexpr std::size_t             alignment_v     = 64;
+
+    static_assert(std::endian::native == std::endian::little, "The geom blob is stored in little endian");
+
+    struct table
+    {
+        std::uint64_t           m_Offset;           // From the start of the blob
+        std::uint64_t           m_Count;
+    };
+
+    struct header
+    {
+        std::array<char, 8>     m_Magic;
+        std::uint32_t           m_Version;
+        std::uint32_t           m_EndianTag;
+        std::uint32_t           m_HeaderSize;
+        std::uint32_t           m_Alignment;
+        std::uint64_t           m_BlobSize;
+        std::array<std::uint32_t, 5> m_StructSizes;     // mesh, lod, submesh, cluster, material_instance_ref
+        table                   m_Meshes;
+        table                   m_LODs;
+        table                   m_SubMeshes;
+        table                   m_Clusters;
+        table                   m_MaterialInstances;
+        table                   m_Lookup;
+        table                   m_BoneParents;
+        table                   m_BoneNames;
+        table                   m_BindTranslations;
+        table                   m_BindRotations;
+        table                   m_BindScales;
+        table                   m_InverseBinds;
+        table                   m_ClusterBones;
+        table                   m_Data;             // Count is in bytes
+        std::uint64_t           m_VertexOffset;     // These four are relative to the data table
+        std::uint64_t           m_VertexExtrasOffset;
+        std::uint64_t           m_IndicesOffset;
+        std::uint64_t           m_VertexSkinOffset;
+        std::uint32_t           m_nVertices;
+        std::uint32_t           m_nIndices;
+        std::uint32_t           m_nMeshHashBuckets;
+        std::uint32_t           m_nMeshHashSlots;
+        std::uint32_t           m_IndexEncoding;    // geom::index_encoding
+        std::uint32_t           m_VertexEncoding;   // geom::vertex_encoding
+        std::uint32_t           m_VertexExtrasEncoding; // geom::vertex_encoding
+        std::uint32_t           m_nRootBones;
+        std::array<float, 6>    m_BBox;             // Min XYZ, Max XYZ
+    };
+
+    inline static constexpr std::array<std::uint32_t, 5> struct_sizes_v =
+    { sizeof(geom::mesh), sizeof(geom::lod), sizeof(geom::submesh), sizeof(geom::cluster), sizeof(xrsc::material_instance_ref) };
+
+    //--------------------------------------------------------------------------------------
+    // Memory mapped file. Writable maps the file copy on write: the pages that are modified
+    // become private to the process and the file itself is never changed.
+    //--------------------------------------------------------------------------------------
+    class mapped_file
+    {
+    public:
+
+        mapped_file(void)                               noexcept = default;
+        mapped_file(const mapped_file&)                 = delete;
+        mapped_file& operator = (const mapped_file&)    = delete;
+        ~mapped_file(void)                              noexcept { Close(); }
+
+        bool Open(const std::wstring& Path, bool bWritable = false) noexcept
+        {
+            Close();
+        #if defined(_WIN32)
+            m_hFile = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER Size;
+            if (!GetFileSizeEx(m_hFile, &Size)) return Close(), false;
+            m_Size = static_cast<std::size_t>(Size.QuadPart);
+            if (m_Size == 0) return true;
+
+            m_hMapping = CreateFileMappingW(m_hFile, nullptr, bWritable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+            if (m_hMapping == nullptr) return Close(), false;
+
+            m_pData = static_cast<std::byte*>(MapViewOfFile(m_hMapping, bWritable ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+            if (m_pData == nullptr) return Close(), false;
+        #else
+            m_File = ::open(std::filesystem::path(Path).string().c_str(), O_RDONLY);
+            if (m_File < 0) return false;
+
+            struct stat Stat;
+            if (::fstat(m_File, &Stat) != 0) return Close(), false;
+            m_Size = static_cast<std::size_t>(Stat.st_size);
+            if (m_Size == 0) return true;
+
+            void* p = ::mmap(nullptr, m_Size, bWritable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, m_File, 0);
+            if (p == MAP_FAILED) return Close(), false;
+            m_pData = static_cast<std::byte*>(p);
+        #endif
+            return true;
+        }
+
+        void Close(void) noexcept
+        {
+        #if defined(_WIN32)
+            if (m_pData)                        UnmapViewOfFile(m_pData);
+            if (m_hMapping)                     CloseHandle(m_hMapping);
+            if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+            m_hMapping  = nullptr;
+            m_hFile     = INVALID_HANDLE_VALUE;
+        #else
+            if (m_pData)        ::munmap(m_pData, m_Size);
+            if (m_File >= 0)    ::close(m_File);
+            m_File = -1;
+        #endif
+            m_pData = nullptr;
+            m_Size  = 0;
+        }
+
+        std::span<const std::byte>  getData         (void) const noexcept { return { m_pData, m_Size }; }
+        std::span<std::byte>        getWritableData (void)       noexcept { return { m_pData, m_Size }; }
+
+    private:
+
+    #if defined(_WIN32)
+        HANDLE              m_hFile     = INVALID_HANDLE_VALUE;
+        HANDLE              m_hMapping  = nullptr;
+    #else
+        int                 m_File      = -1;
+    #endif
+        std::byte*          m_pData     = nullptr;
+        std::size_t         m_Size      = 0;
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    inline bool isBlob(std::span<const std::byte> Data) noexcept
+    {
+        return Data.size() >= sizeof(magic_v) && std::memcmp(Data.data(), magic_v.data(), sizeof(magic_v)) == 0;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Places the header and the tables one after the other, returns the total size
+    //--------------------------------------------------------------------------------------
+    inline std::uint64_t Layout( header& Header, std::uint64_t nMeshes, std::uint64_t nLODs, std::uint64_t nSubMeshes, std::uint64_t nClusters, std::uint64_t nMaterialInstances, std::uint64_t nLookup, std::uint64_t nBones, std::uint64_t nClusterBones, std::uint64_t DataSize ) noexcept
+    {
+        auto Align = [](std::uint64_t Offset) constexpr { return (Offset + alignment_v - 1) & ~std::uint64_t(alignment_v - 1); };
+
+        Header.m_Magic          = magic_v;
+        Header.m_Version        = version_v;
+        Header.m_EndianTag      = endian_tag_v;
+        Header.m_HeaderSize     = sizeof(header);
+        Header.m_Alignment      = alignment_v;
+        Header.m_StructSizes    = struct_sizes_v;
+
+        std::uint64_t Offset = sizeof(header);
+        auto Place = [&](table& Table, std::uint64_t Count, std::size_t ElementSize)
+        {
+            Offset          = Align(Offset);
+            Table.m_Offset  = Offset;
+            Table.m_Count   = Count;
+            Offset         += Count * ElementSize;
+        };
+
+        Place(Header.m_Meshes,              nMeshes,            sizeof(geom::mesh));
+        Place(Header.m_LODs,                nLODs,              sizeof(geom::lod));
+        Place(Header.m_SubMeshes,           nSubMeshes,         sizeof(geom::submesh));
+        Place(Header.m_Clusters,            nClusters,          sizeof(geom::cluster));
+        Place(Header.m_MaterialInstances,   nMaterialInstances, sizeof(xrsc::material_instance_ref));
+        Place(Header.m_Lookup,              nLookup,            sizeof(std::uint16_t));
+        Place(Header.m_BoneParents,         nBones,             sizeof(std::int16_t));
+        Place(Header.m_BoneNames,           nBones,             sizeof(xskeleton::skeleton::name));
+        Place(Header.m_BindTranslations,    nBones,             sizeof(xskeleton::skeleton::vec4));
+        Place(Header.m_BindRotations,       nBones,             sizeof(xskeleton::skeleton::vec4));
+        Place(Header.m_BindScales,          nBones,             sizeof(xskeleton::skeleton::vec4));
+        Place(Header.m_InverseBinds,        nBones,             sizeof(xskeleton::skeleton::affine));
+        Place(Header.m_ClusterBones,        nClusterBones,      sizeof(std::uint16_t));
+        Place(Header.m_Data,                DataSize,           1);
+
+        Header.m_BlobSize = Align(Offset);
+        return Header.m_BlobSize;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Allocates every table of a geom in a single cache line aligned block that starts with a
+    // blob header, so the metadata of a geom is contiguous (the mesh, LOD, submesh and cluster
+    // tables that the culling walks are next to each other) and a load/unload is one allocation.
+    // The tables are zeroed and the counts set (m_nRoots of the skeleton is left to the caller);
+    // Geom.Kill frees the block.
+    //--------------------------------------------------------------------------------------
+    inline void AllocateArena( geom& Geom, std::uint16_t nMeshes, std::uint16_t nLODs, std::uint16_t nSubMeshes, std::uint32_t nClusters, std::uint16_t nMaterialInstances, std::uint32_t nLookup, std::uint16_t nBones, std::uint32_t nClusterBones, std::size_t DataSize ) noexcept
+    {
+        Geom.Kill();
+
+        header      Header{};
+        const auto  Size    = static_cast<std::size_t>(Layout(Header, nMeshes, nLODs, nSubMeshes, nClusters, nMaterialInstances, nLookup, nBones, nClusterBones, DataSize));
+        auto*       pArena  = static_cast<std::byte*>(::operator new(Size, geom::arena_alignment_v));
+
+        std::memset(pArena, 0, Size);
+        std::memcpy(pArena, &Header, sizeof(header));
+
+        Geom.m_pArena                       = pArena;
+        Geom.m_pMesh                        = reinterpret_cast<geom::mesh*>(pArena + Header.m_Meshes.m_Offset);
+        Geom.m_pLOD                         = reinterpret_cast<geom::lod*>(pArena + Header.m_LODs.m_Offset);
+        Geom.m_pSubMesh                     = reinterpret_cast<geom::submesh*>(pArena + Header.m_SubMeshes.m_Offset);
+        Geom.m_pCluster                     = reinterpret_cast<geom::cluster*>(pArena + Header.m_Clusters.m_Offset);
+        Geom.m_pDefaultMaterialInstances    = reinterpret_cast<xrsc::material_instance_ref*>(pArena + Header.m_MaterialInstances.m_Offset);
+        Geom.m_pLookup                      = reinterpret_cast<std::uint16_t*>(pArena + Header.m_Lookup.m_Offset);
+        Geom.m_pClusterBone                 = reinterpret_cast<std::uint16_t*>(pArena + Header.m_ClusterBones.m_Offset);
+        Geom.m_pData                        = reinterpret_cast<char*>(pArena + Header.m_Data.m_Offset);
+        Geom.m_Skeleton.m_pParent           = reinterpret_cast<std::int16_t*>(pArena + Header.m_BoneParents.m_Offset);
+        Geom.m_Skeleton.m_pName             = reinterpret_cast<xskeleton::skeleton::name*>(pArena + Header.m_BoneNames.m_Offset);
+        Geom.m_Skeleton.m_pBindTranslation  = reinterpret_cast<xskeleton::skeleton::vec4*>(pArena + Header.m_BindTranslations.m_Offset);
+        Geom.m_Skeleton.m_pBindRotation     = reinterpret_cast<xskeleton::skeleton::vec4*>(pArena + Header.m_BindRotations.m_Offset);
+        Geom.m_Skeleton.m_pBindScale        = reinterpret_cast<xskeleton::skeleton::vec4*>(pArena + Header.m_BindScales.m_Offset);
+        Geom.m_Skeleton.m_pInverseBind      = reinterpret_cast<xskeleton::skeleton::affine*>(pArena + Header.m_InverseBinds.m_Offset);
+        Geom.m_Skeleton.m_nBones            = nBones;
+        Geom.m_nMeshes                      = nMeshes;
+        Geom.m_nLODs                        = nLODs;
+        Geom.m_nSubMeshs                    = nSubMeshes;
+        Geom.m_nClusters                    = nClusters;
+        Geom.m_nDefaultMaterialInstances    = nMaterialInstances;
+        Geom.m_nLookup                      = nLookup;
+        Geom.m_nClusterBones                = nClusterBones;
+        Geom.m_DataSize                     = DataSize;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Flattens a geom into a blob
+    //--------------------------------------------------------------------------------------
+    inline void Write(const geom& Geom, std::vector<std::byte>& Blob) noexcept
+    {
+        header Header{};
+        Layout(Header, Geom.m_nMeshes, Geom.m_nLODs, Geom.m_nSubMeshs, Geom.m_nClusters, Geom.m_nDefaultMaterialInstances, Geom.m_nLookup, Geom.m_Skeleton.m_nBones, Geom.m_nClusterBones, Geom.m_DataSize);
+        Header.m_VertexOffset         = Geom.m_VertexOffset;
+        Header.m_VertexExtrasOffset   = Geom.m_VertexExtrasOffset;
+        Header.m_IndicesOffset        = Geom.m_IndicesOffset;
+        Header.m_VertexSkinOffset     = Geom.m_VertexSkinOffset;
+        Header.m_nVertices            = Geom.m_nVertices;
+        Header.m_nIndices             = Geom.m_nIndices;
+        Header.m_nMeshHashBuckets     = Geom.m_nMeshHashBuckets;
+        Header.m_nMeshHashSlots       = Geom.m_nMeshHashSlots;
+        Header.m_IndexEncoding        = static_cast<std::uint32_t>(Geom.m_IndexEncoding);
+        Header.m_VertexEncoding       = static_cast<std::uint32_t>(Geom.m_VertexEncoding);
+        Header.m_VertexExtrasEncoding = static_cast<std::uint32_t>(Geom.m_VertexExtrasEncoding);
+        Header.m_nRootBones           = Geom.m_Skeleton.m_nRoots;
+        Header.m_BBox                 = { Geom.m_BBox.m_Min.m_X, Geom.m_BBox.m_Min.m_Y, Geom.m_BBox.m_Min.m_Z
+                                        , Geom.m_BBox.m_Max.m_X, Geom.m_BBox.m_Max.m_Y, Geom.m_BBox.m_Max.m_Z };
+
+        Blob.assign(Header.m_BlobSize, std::byte{ 0 });
+
+        auto Copy = [&](const table& Table, const void* pSrc, std::size_t ElementSize)
+        {
+            if (Table.m_Count) std::memcpy(Blob.data() + Table.m_Offset, pSrc, Table.m_Count * ElementSize);
+        };
+
+        std::memcpy(Blob.data(), &Header, sizeof(header));
+        Copy(Header.m_Meshes,               Geom.m_pMesh,                       sizeof(geom::mesh));
+        Copy(Header.m_LODs,                 Geom.m_pLOD,                        sizeof(geom::lod));
+        Copy(Header.m_SubMeshes,            Geom.m_pSubMesh,                    sizeof(geom::submesh));
+        Copy(Header.m_Clusters,             Geom.m_pCluster,                    sizeof(geom::cluster));
+        Copy(Header.m_MaterialInstances,    Geom.m_pDefaultMaterialInstances,   sizeof(xrsc::material_instance_ref));
+        Copy(Header.m_Lookup,               Geom.m_pLookup,                     sizeof(std::uint16_t));
+        Copy(Header.m_BoneParents,          Geom.m_Skeleton.m_pParent,          sizeof(std::int16_t));
+        Copy(Header.m_BoneNames,            Geom.m_Skeleton.m_pName,            sizeof(xskeleton::skeleton::name));
+        Copy(Header.m_BindTranslations,     Geom.m_Skeleton.m_pBindTranslation, sizeof(xskeleton::skeleton::vec4));
+        Copy(Header.m_BindRotations,        Geom.m_Skeleton.m_pBindRotation,    sizeof(xskeleton::skeleton::vec4));
+        Copy(Header.m_BindScales,           Geom.m_Skeleton.m_pBindScale,       sizeof(xskeleton::skeleton::vec4));
+        Copy(Header.m_InverseBinds,         Geom.m_Skeleton.m_pInverseBind,     sizeof(xskeleton::skeleton::affine));
+        Copy(Header.m_ClusterBones,         Geom.m_pClusterBone,                sizeof(std::uint16_t));
+        Copy(Header.m_Data,                 Geom.m_pData,                       1);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Points Geom to the tables inside the blob, nothing is copied. The blob must stay alive
+    // (and at the same address) for as long as the geom is used and Geom.Kill will not free it.
+    // m_pBlob is set to the blob, the owner can replace it with its own handle.
+    //--------------------------------------------------------------------------------------
+    inline xerr View(geom& Geom, std::span<std::byte> Blob) noexcept
+    {
+        if (Blob.size() < sizeof(header) || !isBlob(Blob))
+            return xerr::create_f<state, "The data is not a geom blob">();
+
+        if (reinterpret_cast<std::uintptr_t>(Blob.data()) % alignment_v)
+            return xerr::create_f<state, "The geom blob is not aligned">();
+
+        const auto& Header = *reinterpret_cast<const header*>(Blob.data());
+        if (   Header.m_Version     != version_v
+            || Header.m_EndianTag   != endian_tag_v
+            || Header.m_HeaderSize  != sizeof(header)
+            || Header.m_Alignment   != alignment_v
+            || Header.m_StructSizes != struct_sizes_v )
+            return xerr::create_f<state, "The geom blob was built with a different format">();
+
+        if (Header.m_BlobSize > Blob.size())
+            return xerr::create_f<state, "The geom blob is truncated">();
+
+        auto InBlob = [&](const table& Table, std::size_t ElementSize)
+        {
+            return Table.m_Offset % alignment_v == 0 && Table.m_Offset <= Header.m_BlobSize && Table.m_Count <= (Header.m_BlobSize - Table.m_Offset) / ElementSize;
+        };
+
+        // Encoded streams only need their offset table here, the codec checks the rest when decoding
+        auto VertexStreamSize = [&](std::uint32_t Encoding, std::size_t ElementSize) -> std::uint64_t
+        {
+            return Encoding == static_cast<std::uint32_t>(geom::vertex_encoding::RAW) ? Header.m_nVertices * ElementSize : sizeof(std::uint32_t);
+        };
+
+        // Every bone table has one entry per bone and the parents keep the order that
+        // skeleton::ComputeModelPose relies on: the roots first, then parents before children
+        auto ValidBones = [&]
+        {
+            const auto nBones = Header.m_BoneParents.m_Count;
+            if (   nBones > std::uint64_t(std::numeric_limits<std::int16_t>::max())
+                || Header.m_nRootBones               > nBones
+                || Header.m_BoneNames.m_Count        != nBones
+                || Header.m_BindTranslations.m_Count != nBones
+                || Header.m_BindRotations.m_Count    != nBones
+                || Header.m_BindScales.m_Count       != nBones
+                || Header.m_InverseBinds.m_Count     != nBones )
+                return false;
+
+            const auto* pParent = reinterpret_cast<const std::int16_t*>(Blob.data() + Header.m_BoneParents.m_Offset);
+            for (std::uint64_t i = 0; i < nBones; ++i)
+            {
+                if (i < Header.m_nRootBones ? pParent[i] != xskeleton::skeleton::invalid_bone_v
+                                            : (pParent[i] < 0 || std::uint64_t(pParent[i]) >= i))
+                    return false;
+            }
+            return true;
+        };
+
+        // The bone palettes of the clusters point to bones of the skeleton
+        auto ValidClusterBones = [&]
+        {
+            const auto* pBone = reinterpret_cast<const std::uint16_t*>(Blob.data() + Header.m_ClusterBones.m_Offset);
+            for (std::uint64_t i = 0; i < Header.m_ClusterBones.m_Count; ++i)
+                if (pBone[i] >= Header.m_BoneParents.m_Count) return false;
+            return true;
+        };
+
+        if (   !InBlob(Header.m_Meshes,             sizeof(geom::mesh))
+            || !InBlob(Header.m_LODs,               sizeof(geom::lod))
+            || !InBlob(Header.m_SubMeshes,          sizeof(geom::submesh))
+            || !InBlob(Header.m_Clusters,           sizeof(geom::cluster))
+            || !InBlob(Header.m_MaterialInstances,  sizeof(xrsc::material_instance_ref))
+            || !InBlob(Header.m_Lookup,             sizeof(std::uint16_t))
+            || (Header.m_Meshes.m_Count && (!std::has_single_bit(Header.m_nMeshHashBuckets) || !std::has_single_bit(Header.m_nMeshHashSlots)))
+            || std::uint64_t(Header.m_nMeshHashBuckets) + Header.m_nMeshHashSlots + Header.m_LODs.m_Count * Header.m_MaterialInstances.m_Count != Header.m_Lookup.m_Count
+            || !InBlob(Header.m_BoneParents,        sizeof(std::int16_t))
+            || !InBlob(Header.m_BoneNames,          sizeof(xskeleton::skeleton::name))
+            || !InBlob(Header.m_BindTranslations,   sizeof(xskeleton::skeleton::vec4))
+            || !InBlob(Header.m_BindRotations,      sizeof(xskeleton::skeleton::vec4))
+            || !InBlob(Header.m_BindScales,         sizeof(xskeleton::skeleton::vec4))
+            || !InBlob(Header.m_InverseBinds,       sizeof(xskeleton::skeleton::affine))
+            || !ValidBones()
+            || !InBlob(Header.m_ClusterBones,       sizeof(std::uint16_t))
+            || !ValidClusterBones()
+            || !InBlob(Header.m_Data,               1)
+            || Header.m_VertexEncoding       > static_cast<std::uint32_t>(geom::vertex_encoding::MESHOPT)
+            || Header.m_VertexExtrasEncoding > static_cast<std::uint32_t>(geom::vertex_encoding::MESHOPT)
+            || Header.m_VertexOffset > Header.m_VertexExtrasOffset || Header.m_VertexExtrasOffset > Header.m_IndicesOffset
+            || Header.m_VertexOffset       + VertexStreamSize(Header.m_VertexEncoding,       sizeof(geom::vertex))        > Header.m_Data.m_Count
+            || Header.m_VertexExtrasOffset + VertexStreamSize(Header.m_VertexExtrasEncoding, sizeof(geom::vertex_extras)) > Header.m_Data.m_Count
+            || Header.m_IndexEncoding > static_cast<std::uint32_t>(geom::index_encoding::MESHOPT)
+            || Header.m_IndicesOffset + (Header.m_IndexEncoding == static_cast<std::uint32_t>(geom::index_encoding::RAW)
+                                        ? Header.m_nIndices * sizeof(std::uint16_t)
+                                        : (Header.m_Clusters.m_Count + 1) * sizeof(std::uint32_t)) > Header.m_VertexSkinOffset
+            || Header.m_VertexSkinOffset + (Header.m_ClusterBones.m_Count ? Header.m_nVertices * sizeof(geom::vertex_skin) : 0) > Header.m_Data.m_Count )
+            return xerr::create_f<state, "The geom blob is corrupted">();
+
+        auto At = [&](const table& Table) { return Blob.data() + Table.m_Offset; };
+
+        // The runtime indexes the tables with the ranges and the lookup stored in them (findMeshIndex,
+        // the loader streams, the skinning), so every range must stay inside the table it points to.
+        // Only the content of the data block (the values of the indices, ...) is left unchecked.
+        auto ValidTables = [&]
+        {
+            auto InRange = [](std::uint64_t Start, std::uint64_t Count, std::uint64_t Size) { return Start <= Size && Count <= Size - Start; };
+
+            const std::span Meshes      { reinterpret_cast<const geom::mesh*>   (At(Header.m_Meshes)),    static_cast<std::size_t>(Header.m_Meshes.m_Count)    };
+            const std::span LODs        { reinterpret_cast<const geom::lod*>    (At(Header.m_LODs)),      static_cast<std::size_t>(Header.m_LODs.m_Count)      };
+            const std::span SubMeshes   { reinterpret_cast<const geom::submesh*>(At(Header.m_SubMeshes)), static_cast<std::size_t>(Header.m_SubMeshes.m_Count) };
+            const std::span Clusters    { reinterpret_cast<const geom::cluster*>(At(Header.m_Clusters)),  static_cast<std::size_t>(Header.m_Clusters.m_Count)  };
+            const std::span Lookup      { reinterpret_cast<const std::uint16_t*>(At(Header.m_Lookup)),    static_cast<std::size_t>(Header.m_Lookup.m_Count)    };
+
+            for (const auto& M : Meshes)
+                if (   std::memchr(M.m_Name.data(), 0, M.m_Name.size()) == nullptr
+                    || M.m_iLOD >= LODs.size() || !InRange(M.m_iLOD, M.m_nLODs, LODs.size()) )
+                    return false;
+
+            for (const auto& L : LODs)
+                if (   !InRange(L.m_iSubmesh, L.m_nSubmesh,  SubMeshes.size())
+                    || !InRange(L.m_iVertex,  L.m_nVertices, Header.m_nVertices)
+                    || !InRange(L.m_iIndex,   L.m_nIndices,  Header.m_nIndices) )
+                    return false;
+
+            for (const auto& S : SubMeshes)
+                if (!InRange(S.m_iCluster, S.m_nCluster, Clusters.size()))
+                    return false;
+
+            for (const auto& C : Clusters)
+                if (   !InRange(C.m_iIndex,  C.m_nIndices,  Header.m_nIndices)
+                    || !InRange(C.m_iVertex, C.m_nVertices, Header.m_nVertices)
+                    || !InRange(C.m_iBone,   C.m_nBones,    Header.m_ClusterBones.m_Count) )
+                    return false;
+
+            // The bucket seeds can be any value, the slots hold a mesh and the last table a submesh
+            const auto Slots        = Lookup.subspan(Header.m_nMeshHashBuckets, Header.m_nMeshHashSlots);
+            const auto SubMeshTable = Lookup.subspan(std::size_t(Header.m_nMeshHashBuckets) + Header.m_nMeshHashSlots);
+            for (const auto i : Slots)        if (i != geom::invalid_index_v && i >= Meshes.size())    return false;
+            for (const auto i : SubMeshTable) if (i != geom::invalid_index_v && i >= SubMeshes.size()) return false;
+
+            return true;
+        };
+
+        if (!ValidTables())
+            return xerr::create_f<state, "The geom blob is corrupted">();
+
+        Geom.Initialize();
+        Geom.m_pBlob                        = Blob.data();
+        Geom.m_pMesh                        = reinterpret_cast<geom::mesh*>(At(Header.m_Meshes));
+        Geom.m_pLOD                         = reinterpret_cast<geom::lod*>(At(Header.m_LODs));
+        Geom.m_pSubMesh                     = reinterpret_cast<geom::submesh*>(At(Header.m_SubMeshes));
+        Geom.m_pCluster                     = reinterpret_cast<geom::cluster*>(At(Header.m_Clusters));
+        Geom.m_pDefaultMaterialInstances    = reinterpret_cast<xrsc::material_instance_ref*>(At(Header.m_MaterialInstances));
+        Geom.m_pLookup                      = reinterpret_cast<std::uint16_t*>(At(Header.m_Lookup));
+        Geom.m_pClusterBone                 = reinterpret_cast<std::uint16_t*>(At(Header.m_ClusterBones));
+        Geom.m_pData                        = reinterpret_cast<char*>(At(Header.m_Data));
+        Geom.m_Skeleton.m_pParent           = reinterpret_cast<std::int16_t*>(At(Header.m_BoneParents));
+        Geom.m_Skeleton.m_pName             = reinterpret_cast<xskeleton::skeleton::name*>(At(Header.m_BoneNames));
+        Geom.m_Skeleton.m_pBindTranslation  = reinterpret_cast<xskeleton::skeleton::vec4*>(At(Header.m_BindTranslations));
+        Geom.m_Skeleton.m_pBindRotation     = reinterpret_cast<xskeleton::skeleton::vec4*>(At(Header.m_BindRotations));
+        Geom.m_Skeleton.m_pBindScale        = reinterpret_cast<xskeleton::skeleton::vec4*>(At(Header.m_BindScales));
+        Geom.m_Skeleton.m_pInverseBind      = reinterpret_cast<xskeleton::skeleton::affine*>(At(Header.m_InverseBinds));
+        Geom.m_Skeleton.m_nBones            = static_cast<std::uint16_t>(Header.m_BoneParents.m_Count);
+        Geom.m_Skeleton.m_nRoots            = static_cast<std::uint16_t>(Header.m_nRootBones);
+        Geom.m_nMeshes                      = static_cast<std::uint16_t>(Header.m_Meshes.m_Count);
+        Geom.m_nLODs                        = static_cast<std::uint16_t>(Header.m_LODs.m_Count);
+        Geom.m_nSubMeshs                    = static_cast<std::uint16_t>(Header.m_SubMeshes.m_Count);
+        Geom.m_nClusters                    = static_cast<std::uint32_t>(Header.m_Clusters.m_Count);
+        Geom.m_nDefaultMaterialInstances    = static_cast<std::uint16_t>(Header.m_MaterialInstances.m_Count);
+        Geom.m_nLookup                      = static_cast<std::uint32_t>(Header.m_Lookup.m_Count);
+        Geom.m_nClusterBones                = static_cast<std::uint32_t>(Header.m_ClusterBones.m_Count);
+        Geom.m_nMeshHashBuckets             = Header.m_nMeshHashBuckets;
+        Geom.m_nMeshHashSlots               = Header.m_nMeshHashSlots;
+        Geom.m_DataSize                     = static_cast<std::size_t>(Header.m_Data.m_Count);
+        Geom.m_VertexOffset                 = static_cast<std::size_t>(Header.m_VertexOffset);
+        Geom.m_VertexExtrasOffset           = static_cast<std::size_t>(Header.m_VertexExtrasOffset);
+        Geom.m_IndicesOffset                = static_cast<std::size_t>(Header.m_IndicesOffset);
+        Geom.m_VertexSkinOffset             = static_cast<std::size_t>(Header.m_VertexSkinOffset);
+        Geom.m_nVertices                    = Header.m_nVertices;
+        Geom.m_nIndices                     = Header.m_nIndices;
+        Geom.m_IndexEncoding                = static_cast<geom::index_encoding>(Header.m_IndexEncoding);
+        Geom.m_VertexEncoding               = static_cast<geom::vertex_encoding>(Header.m_VertexEncoding);
+        Geom.m_VertexExtrasEncoding         = static_cast<geom::vertex_encoding>(Header.m_VertexExtrasEncoding);
+        Geom.m_BBox.m_Min                   = xmath::fvec3(Header.m_BBox[0], Header.m_BBox[1], Header.m_BBox[2]);
+        Geom.m_BBox.m_Max                   = xmath::fvec3(Header.m_BBox[3], Header.m_BBox[4], Header.m_BBox[5]);
+
+        return {};
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef XSKELETON_CROWD_H
+#define XSKELETON_CROWD_H
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <span>
+
+#include "xskeleton_pose.h"
+#include "xskeleton_parallel.h"
+
+//
+// Skinning palettes of many instances of the same skeleton (geom::m_Skeleton) in one call.
+// The local poses of all the instances are one after the other (getLocalPoseSize floats each,
+// see xskeleton_pose.h) and so are their palettes (m_nBones matrices each), so the result is a
+// single block that can be uploaded as it is.
+//
+// The instances are cut in batches whose poses, palettes and scratch fit in batch_bytes_v, and
+// the batches are split in contiguous runs, one job per run on the xscheduler workers (see
+// ParallelFor). Every job needs m_nBones model matrices of scratch, which the caller passes in
+// (getScratchSize), so the number of jobs is also how many workers the call can use. The jobs
+// share nothing, so the time goes down with the number of jobs until memory bandwidth is the
+// limit.
+//
+namespace xskeleton::crowd
+{
+    inline static constexpr std::size_t batch_bytes_v = 256 * 1024;     // About half of a L2
+
+    //--------------------------------------------------------------------------------------
+    // Instances per batch for a skeleton, at least one
+    //--------------------------------------------------------------------------------------
+    inline std::size_t getBatchSize(const skeleton& Skeleton) noexcept
+    {
+        const std::size_t InstanceBytes = pose::getLocalPoseSize(Skeleton.m_nBones) * sizeof(float) + Skeleton.m_nBones * sizeof(skeleton::affine);
+        return std::max<std::size_t>(1, batch_bytes_v / std::max<std::size_t>(1, InstanceBytes));
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Matrices of scratch that ComputePalettes needs to run nJobs jobs (usually one per worker)
+    //--------------------------------------------------------------------------------------
+    inline std::size_t getScratchSize(const skeleton& Skeleton, std::size_t nJobs) noexcept
+    {
+        return nJobs * Skeleton.m_nBones;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // LocalPoses has nInstances * getLocalPoseSize(m_nBones) floats and Palettes has
+    // nInstances * m_nBones matrices, nInstances comes from the size of Palettes. The number
+    // of jobs is Scratch.size() / m_nBones (at least one) up to the number of batches.
+    //--------------------------------------------------------------------------------------
+    inline void ComputePalettes(const skeleton& Skeleton, std::span<const float> LocalPoses, std::span<skeleton::affine> Palettes, std::span<skeleton::affine> Scratch) noexcept
+    {
+        const std::size_t nBones = Skeleton.m_nBones;
+        if (nBones == 0) return;
+
+        const std::size_t PoseSize      = pose::getLocalPoseSize(nBones);
+        const std::size_t nInstances    = Palettes.size() / nBones;
+        const std::size_t BatchSize     = getBatchSize(Skeleton);
+        const std::size_t nBatches      = (nInstances + BatchSize - 1) / BatchSize;
+        const std::size_t nJobs         = std::min(nBatches, Scratch.size() / nBones);
+        assert(nJobs > 0 || nBatches == 0);
+
+        ParallelFor(nJobs, [&](std::size_t iJob)
+        {
+            const auto Model = Scratch.subspan(iJob * nBones, nBones);
+            const auto Begin = std::min(nInstances, iJob       * nBatches / nJobs * BatchSize);
+            const auto End   = std::min(nInstances, (iJob + 1) * nBatches / nJobs * BatchSize);
+
+            for (std::size_t i = Begin; i < End; ++i)
+            {
+                pose::ComputePalette
+                ( Skeleton
+                , LocalPoses.subspan(i * PoseSize, PoseSize)
+                , Model
+                , Palettes.subspan(i * nBones, nBones)
+                );
+            }
+        });
+    }
+}
+
+#endif
@@ -16,10 +16,12 @@ namespace xgeom_static
     struct lod
     {
         float               m_LODReduction  = 0.7f;
-        float               m_ScreenArea    = 1;            // in pixels
+        float               m_MaxError      = 0.01f;        // Max simplification error from the previous LOD, relative to the mesh size
+        float               m_ScreenArea    = 1;            // in pixels, only used when the screen area is not computed from the error
         XPROPERTY_DEF
         ( "lod", lod
         , obj_member<"LODReduction",    &lod::m_LODReduction >
+        , obj_member<"MaxError",        &lod::m_MaxError >
         , obj_member<"ScreenArea",      &lod::m_ScreenArea >
         )
     };
@@ -69,6 +71,25 @@ namespace xgeom_static
     };
     XPROPERTY_REG(pre_transform)
 
+    // When enabled the clusters are split into small fixed budget meshlets (each with its own
+    // bounding sphere and normal cone) so they can be culled individually
+    struct meshlets
+    {
+        bool                m_bEnable       = false;
+        int                 m_MaxVertices   = 64;           // 3..255
+        int                 m_MaxTriangles  = 124;          // 4..512, multiple of 4 (meshopt_buildMeshlets requires it)
+        float               m_ConeWeight    = 0.25f;        // 0 = best spatial locality, 1 = tightest normal cones
+
+        XPROPERTY_DEF
+        ( "meshlets", meshlets
+        , obj_member<"Enable",          &meshlets::m_bEnable >
+        , obj_member<"MaxVertices",     &meshlets::m_MaxVertices >
+        , obj_member<"MaxTriangles",    &meshlets::m_MaxTriangles >
+        , obj_member<"ConeWeight",      &meshlets::m_ConeWeight >
+        )
+    };
+    XPROPERTY_REG(meshlets)
+
 /*
     struct data
     {
@@ -94,6 +115,15 @@ namespace xgeom_static
 
         void Validate(std::vector<std::string>& Errors) const noexcept override
         {
+            if (m_LODPixelError <= 0) Errors.emplace_back("LODPixelError must be greater than zero");
+
+            if (m_Meshlets.m_bEnable)
+            {
+                if (m_Meshlets.m_MaxVertices < 3 || m_Meshlets.m_MaxVertices > 255)   Errors.emplace_back("Meshlets MaxVertices must be between 3 and 255");
+                if (m_Meshlets.m_MaxTriangles < 4 || m_Meshlets.m_MaxTriangles > 512) Errors.emplace_back("Meshlets MaxTriangles must be between 4 and 512");
+                if (m_Meshlets.m_MaxTriangles % 4 != 0)                               Errors.emplace_back("Meshlets MaxTriangles must be a multiple of 4");
+                if (m_Meshlets.m_ConeWeight < 0 || m_Meshlets.m_ConeWeight > 1)       Errors.emplace_back("Meshlets ConeWeight must be between 0 and 1");
+            }
         }
 
         int findMesh(std::string_view Name)
@@ -145,8 +175,15 @@ namespace xgeom_static
 
         std::wstring                                m_ImportAsset                   = {};
         pre_transform                               m_PreTranslation                = {};
+        meshlets                                    m_Meshlets                      = {};
+        bool                                        m_bAutoLODScreenArea            = true;     // Compute the LOD screen area from the simplification error
+        float                                       m_LODPixelError                 = 1.0f;     // Error in pixels allowed when computing the LOD screen area
         bool                                        m_bMergeMeshes                  = true;
         bool                                        m_bHideCopasedMeshes            = true;
+        bool                                        m_bFlatBlob                     = false;    // Save as an uncompressed blob that the runtime memory maps (see xskeleton_blob.h)
+        bool                                        m_bEncodeIndices                = false;    // Store the indices of every cluster as a meshopt stream (see xskeleton_index_codec.h)
+        bool                                        m_bEncodeVertices               = false;    // Store the positions as meshopt vertex streams (see xskeleton_vertex_codec.h)
+        bool                                        m_bEncodeVertexExtras           = false;    // Store the UVs, normals and tangents as meshopt vertex streams
         std::vector<mesh>                           m_MeshList                      = {};
         std::vector<xrsc::material_instance_ref>    m_MaterialInstRefList           = {};
         std::vector<std::string>                    m_MaterialInstNamesList         = {};
@@ -156,6 +193,14 @@ namespace xgeom_static
         ( "GeomStatic", descriptor
         , obj_member<"ImportAsset",         &descriptor::m_ImportAsset, member_ui<std::wstring>::file_dialog<mesh_filter_v, true, 1> >
         , obj_member<"PreTranslation",      &descriptor::m_PreTranslation >
+        , obj_member<"Meshlets",            &descriptor::m_Meshlets >
+        , obj_member<"bAutoLODScreenArea",  &descriptor::m_bAutoLODScreenArea >
+        , obj_member<"LODPixelError",       &descriptor::m_LODPixelError, member_dynamic_flags < +[](const descriptor& O)
+            {
+                xproperty::flags::type Flags = {};
+                Flags.m_bDontShow = !O.m_bAutoLODScreenArea;
+                return Flags;
+            } >>
         , obj_member<"bMergeMeshes",        +[](descriptor& O, bool bRead, bool& Value)
             {
                 if (bRead) Value = O.m_bMergeMeshes;
@@ -207,6 +252,10 @@ namespace xgeom_static
                 return Flags;
             }>>
 
+        , obj_member<"bFlatBlob",           &descriptor::m_bFlatBlob >
+        , obj_member<"bEncodeIndices",      &descriptor::m_bEncodeIndices >
+        , obj_member<"bEncodeVertices",     &descriptor::m_bEncodeVertices >
+        , obj_member<"bEncodeVertexExtras", &descriptor::m_bEncodeVertexExtras >
         , obj_member<"MaterialInstance",    &descriptor::m_MaterialInstRefList, member_ui_open<true> >
         )
     };
@@ -0,0 +1,151 @@
+#ifndef XSKELETON_HEADLESS_DEVICE_H
+#define XSKELETON_HEADLESS_DEVICE_H
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+
+#include "plugins/xmaterial_instance.plugin/source/xmaterial_instance_xgpu_rsc_loader.h"
+#include "xskeleton.h"
+
+//
+// CPU only stand-in for the part of xgpu that the geom loader uses, so the load path can run
+// (and be measured) on machines without a GPU. Build xskeleton_xgpu_rsc_loader.cpp with
+// XSKELETON_HEADLESS_DEVICE defined and it includes this header instead of the xgpu runtime.
+//
+// Buffers are plain host allocations that receive a copy of the data, which is the same work
+// that a staging upload does on the CPU side. The device counts what it creates so a benchmark
+// can report the bytes that would have gone to the GPU and check that nothing leaks. Every call
+// to Create is one submission, the batched Create takes many buffers in a single submission.
+//
+namespace xgpu
+{
+    struct buffer
+    {
+        enum class type : std::uint8_t
+        { VERTEX
+        , INDEX
+        , UNIFORM
+        };
+
+        struct setup
+        {
+            type                    m_Type              = type::VERTEX;
+            int                     m_EntryByteSize     = 0;
+            int                     m_EntryCount        = 0;
+            const void*             m_pData             = nullptr;
+        };
+
+        std::byte*                  m_pMemory           = nullptr;
+        std::size_t                 m_ByteSize          = 0;
+    };
+
+    //--------------------------------------------------------------------------------------
+
+    class device
+    {
+    public:
+
+        struct error
+        {
+            const char*             m_pMessage;
+        };
+
+        struct create_entry
+        {
+            buffer*                 m_pBuffer;
+            buffer::setup           m_Setup;
+        };
+
+        error* Create(buffer& Buffer, const buffer::setup& Setup) noexcept
+        {
+            m_nSubmits.fetch_add(1, std::memory_order_relaxed);
+            return CreateBuffer(Buffer, Setup);
+        }
+
+        error* Create(std::span<const create_entry> Entries) noexcept
+        {
+            m_nSubmits.fetch_add(1, std::memory_order_relaxed);
+            for (const auto& E : Entries)
+            {
+                if (auto p = CreateBuffer(*E.m_pBuffer, E.m_Setup); p) return p;
+            }
+            return nullptr;
+        }
+
+        void Destroy(buffer&& Buffer) noexcept
+        {
+            if (Buffer.m_pMemory == nullptr) return;
+
+            m_nLiveBuffers.fetch_sub(1, std::memory_order_relaxed);
+            m_LiveBytes.fetch_sub(Buffer.m_ByteSize, std::memory_order_relaxed);
+            delete[] Buffer.m_pMemory;
+            Buffer = {};
+        }
+
+        std::size_t getLiveBuffers  (void) const noexcept { return m_nLiveBuffers.load(std::memory_order_relaxed); }
+        std::size_t getLiveBytes    (void) const noexcept { return m_LiveBytes.load(std::memory_order_relaxed); }
+        std::size_t getCreatedBytes (void) const noexcept { return m_CreatedBytes.load(std::memory_order_relaxed); }
+        std::size_t getSubmitCount  (void) const noexcept { return m_nSubmits.load(std::memory_order_relaxed); }
+
+    private:
+
+        error* CreateBuffer(buffer& Buffer, const buffer::setup& Setup) noexcept
+        {
+            static error OutOfMemory{ "Out of host memory creating a headless buffer" };
+
+            const auto ByteSize = static_cast<std::size_t>(Setup.m_EntryByteSize) * static_cast<std::size_t>(Setup.m_EntryCount);
+            Buffer = {};
+
+            // Empty buffers hold nothing, so they are not counted
+            if (ByteSize == 0) return nullptr;
+
+            Buffer.m_pMemory = new (std::nothrow) std::byte[ByteSize];
+            if (Buffer.m_pMemory == nullptr) return &OutOfMemory;
+
+            Buffer.m_ByteSize = ByteSize;
+            if (Setup.m_pData) std::memcpy(Buffer.m_pMemory, Setup.m_pData, ByteSize);
+
+            m_nLiveBuffers.fetch_add(1, std::memory_order_relaxed);
+            m_LiveBytes.fetch_add(ByteSize, std::memory_order_relaxed);
+            m_CreatedBytes.fetch_add(ByteSize, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        std::atomic<std::size_t>    m_nLiveBuffers      = 0;
+        std::atomic<std::size_t>    m_LiveBytes         = 0;
+        std::atomic<std::size_t>    m_CreatedBytes      = 0;
+        std::atomic<std::size_t>    m_nSubmits          = 0;
+    };
+}
+
+//------------------------------------------------------------------------------------------
+// Runtime geom, the buffers live in geom::m_RunTimeSpace like they do with xgpu
+//------------------------------------------------------------------------------------------
+namespace xgeom_static::xgpu
+{
+    struct geom : xgeom_static::geom
+    {
+        ::xgpu::buffer& VertexBuffer        (void) noexcept { return *reinterpret_cast<::xgpu::buffer*>(&m_RunTimeSpace[0]); }
+        ::xgpu::buffer& VertexExtrasBuffer  (void) noexcept { return *reinterpret_cast<::xgpu::buffer*>(&m_RunTimeSpace[2]); }
+        ::xgpu::buffer& IndexBuffer         (void) noexcept { return *reinterpret_cast<::xgpu::buffer*>(&m_RunTimeSpace[4]); }
+        ::xgpu::buffer& VertexSkinBuffer    (void) noexcept { return *reinterpret_cast<::xgpu::buffer*>(&m_RunTimeSpace[6]); }
+    };
+
+    static_assert(sizeof(::xgpu::buffer) <= 2 * sizeof(std::size_t));
+    static_assert(sizeof(geom) == sizeof(xgeom_static::geom));
+}
+
+//------------------------------------------------------------------------------------------
+// What the loader expects to find as the user data of the resource manager
+//------------------------------------------------------------------------------------------
+struct resource_mgr_user_data
+{
+    xgpu::device            m_Device;
+};
+
+#endif
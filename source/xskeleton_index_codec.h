@@ -0,0 +1,181 @@
+#ifndef XSKELETON_INDEX_CODEC_H
+#define XSKELETON_INDEX_CODEC_H
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "dependencies/meshoptimizer/src/meshoptimizer.h"
+#include "xskeleton.h"
+#include "xskeleton_parallel.h"
+
+//
+// Compressed index stream of a geom (geom::index_encoding::MESHOPT). Every cluster is encoded
+// on its own with meshopt_encodeIndexBuffer, so the clusters can be decoded in parallel and in
+// any order. The index region of geom::m_pData (from m_IndicesOffset to m_VertexSkinOffset) then holds:
+//
+//      std::uint32_t   Offsets[nClusters + 1]  - Start of the stream of every cluster, relative
+//                                                to the end of the table (the last one is the size)
+//      std::byte       Streams[]
+//
+// The decoded indices are the raw triangles in the same order and with the same winding, but
+// meshopt_encodeIndexBuffer may rotate the vertices of a triangle (abc can come back as bca or
+// cab), see isSameTriangles. cluster::m_iIndex/m_nIndices still tell where each cluster goes
+// and the ranges between clusters (the page padding) decode as zeros.
+//
+namespace xgeom_static::index_codec
+{
+    inline static constexpr std::size_t clusters_per_job_v = 256;       // Clusters are small, batch them per job
+
+    //--------------------------------------------------------------------------------------
+
+    inline std::size_t getJobCount(std::size_t nClusters) noexcept
+    {
+        return (nClusters + clusters_per_job_v - 1) / clusters_per_job_v;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Encodes the indices of every cluster, T is the index type of the source (16 or 32 bits)
+    // Throws if meshoptimizer fails to encode a cluster.
+    //--------------------------------------------------------------------------------------
+    template< typename T >
+    std::vector<std::byte> Encode(std::span<const geom::cluster> Clusters, std::span<const T> Indices)
+    {
+        std::vector<std::vector<unsigned char>> Streams(Clusters.size());
+        std::atomic<bool>                       bFailed = false;
+        xskeleton::ParallelFor(getJobCount(Clusters.size()), [&](std::size_t iJob)
+        {
+            const auto End = std::min(Clusters.size(), (iJob + 1) * clusters_per_job_v);
+            for (auto i = iJob * clusters_per_job_v; i < End; ++i)
+            {
+                const auto& C       = Clusters[i];
+                const auto  Source  = Indices.subspan(C.m_iIndex, C.m_nIndices);
+                auto&       S       = Streams[i];
+                if (Source.empty()) continue;
+
+                // The bound depends on the largest index, not on the number of vertices.
+                // ParallelFor is noexcept, a failed allocation is reported like a failed encode
+                try
+                {
+                    S.resize(meshopt_encodeIndexBufferBound(Source.size(), std::size_t(*std::ranges::max_element(Source)) + 1));
+                    S.resize(meshopt_encodeIndexBuffer(S.data(), S.size(), Source.data(), Source.size()));
+                }
+                catch (...)
+                {
+                    S.clear();
+                }
+                if (S.empty()) bFailed.store(true, std::memory_order_relaxed);
+            }
+        });
+
+        if (bFailed) throw(std::runtime_error("Failed to encode the indices of a cluster"));
+
+        const std::size_t   TableSize = (Clusters.size() + 1) * sizeof(std::uint32_t);
+        std::size_t         Total     = 0;
+        for (const auto& S : Streams) Total += S.size();
+
+        std::vector<std::byte> Encoded(TableSize + Total);
+        auto*       pOffsets = reinterpret_cast<std::uint32_t*>(Encoded.data());
+        std::size_t Offset   = 0;
+        for (std::size_t i = 0; i < Streams.size(); ++i)
+        {
+            pOffsets[i] = static_cast<std::uint32_t>(Offset);
+            if (Streams[i].size()) std::memcpy(Encoded.data() + TableSize + Offset, Streams[i].data(), Streams[i].size());
+            Offset += Streams[i].size();
+        }
+        pOffsets[Streams.size()] = static_cast<std::uint32_t>(Offset);
+
+        return Encoded;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Checks that the offset table fits in Size bytes and that the streams are inside it
+    //--------------------------------------------------------------------------------------
+    inline bool isValid(const std::byte* pEncoded, std::size_t Size, std::size_t nClusters) noexcept
+    {
+        const std::size_t TableSize = (nClusters + 1) * sizeof(std::uint32_t);
+        if (Size < TableSize) return false;
+
+        const auto* pOffsets = reinterpret_cast<const std::uint32_t*>(pEncoded);
+        for (std::size_t i = 0; i < nClusters; ++i)
+            if (pOffsets[i] > pOffsets[i + 1]) return false;
+
+        return pOffsets[nClusters] <= Size - TableSize;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Decodes all the indices of the geom into Out (geom::m_nIndices entries), the clusters
+    // are decoded in parallel straight into their final place. Returns false if the stream is
+    // corrupted or any cluster fails to decode.
+    //--------------------------------------------------------------------------------------
+    inline bool Decode(const geom& Geom, std::span<std::uint16_t> Out) noexcept
+    {
+        const auto* pEncoded = reinterpret_cast<const std::byte*>(Geom.m_pData + Geom.m_IndicesOffset);
+        if (Out.size() < Geom.m_nIndices || Geom.m_IndicesOffset > Geom.m_VertexSkinOffset || Geom.m_VertexSkinOffset > Geom.m_DataSize || !isValid(pEncoded, Geom.m_VertexSkinOffset - Geom.m_IndicesOffset, Geom.m_nClusters))
+            return false;
+
+        const auto*         pOffsets  = reinterpret_cast<const std::uint32_t*>(pEncoded);
+        const auto*         pStreams  = reinterpret_cast<const unsigned char*>(pEncoded + (Geom.m_nClusters + 1) * sizeof(std::uint32_t));
+        std::atomic<bool>   bOK       = true;
+
+        // The padding between the pages is not part of any cluster
+        std::memset(Out.data(), 0, Out.size_bytes());
+
+        xskeleton::ParallelFor(getJobCount(Geom.m_nClusters), [&](std::size_t iJob)
+        {
+            const auto End = std::min<std::size_t>(Geom.m_nClusters, (iJob + 1) * clusters_per_job_v);
+            for (auto i = iJob * clusters_per_job_v; i < End; ++i)
+            {
+                const auto& C = Geom.m_pCluster[i];
+                if (C.m_nIndices == 0) continue;
+                if (C.m_iIndex + std::size_t(C.m_nIndices) > Out.size()
+                    || meshopt_decodeIndexBuffer(Out.data() + C.m_iIndex, C.m_nIndices, sizeof(std::uint16_t), pStreams + pOffsets[i], pOffsets[i + 1] - pOffsets[i]) != 0)
+                {
+                    bOK.store(false, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        });
+
+        return bOK.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // True if Decoded holds the indices of Source with every triangle of the clusters equal up
+    // to a rotation of its vertices (the winding must match) and anything else equal as is
+    //--------------------------------------------------------------------------------------
+    template< typename T >
+    bool isSameTriangles(std::span<const geom::cluster> Clusters, std::span<const std::uint16_t> Decoded, std::span<const T> Source)
+    {
+        if (Decoded.size() != Source.size()) return false;
+
+        // Source with the rotation of every matching triangle taken from Decoded
+        std::vector<std::uint16_t> Expected(Source.begin(), Source.end());
+        for (const auto& C : Clusters)
+        {
+            if (C.m_iIndex + std::size_t(C.m_nIndices) > Expected.size()) return false;
+
+            for (auto i = std::size_t(C.m_iIndex); i + 3 <= C.m_iIndex + std::size_t(C.m_nIndices); i += 3)
+            {
+                for (int r = 1; r < 3; ++r)
+                {
+                    if (Decoded[i] == Expected[i + r] && Decoded[i + 1] == Expected[i + (r + 1) % 3] && Decoded[i + 2] == Expected[i + (r + 2) % 3])
+                    {
+                        std::rotate(Expected.begin() + i, Expected.begin() + i + r, Expected.begin() + i + 3);
+                        break;
+                    }
+                }
+            }
+        }
+
+        return std::ranges::equal(Decoded, Expected);
+    }
+}
+
+#endif
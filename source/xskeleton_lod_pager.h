@@ -0,0 +1,219 @@
+#ifndef XSKELETON_LOD_PAGER_H
+#define XSKELETON_LOD_PAGER_H
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "xskeleton_blob.h"
+
+//
+// Residency of the per LOD pages of a geom. Every geom::lod owns a contiguous range of vertices,
+// vertex extras, vertex skins and indices (its page), so the data of the LODs that are not in use does not
+// need to be in memory.
+//
+// The pager works on geoms that are memory mapped blobs (see xskeleton_blob.h): Request asks the
+// OS to bring the pages of a LOD in, Evict drops them. Only the OS pages that are completely
+// inside the ranges of the LOD are evicted, so very small LODs stay resident. The coarsest LOD
+// of every mesh is requested on Initialize and can not be evicted, so there is always something
+// to draw. For any other geom (or when a stream is encoded, see xskeleton_index_codec.h and
+// xskeleton_vertex_codec.h) every LOD is always resident, the calls do nothing and the pages
+// leave out the encoded streams.
+//
+// The pager starts from what the loader touched: by default the loader uploads every LOD, so
+// every LOD starts resident and can be evicted right away. With load_options::m_bUploadAllLODs
+// off the loader only reads the coarsest LODs and the others start evicted.
+//
+// Typical use: request the LOD that the camera will need next, upload getPage once isResident
+// and evict the LODs that are far from the camera.
+//
+namespace xgeom_static
+{
+    class lod_pager
+    {
+    public:
+
+        struct page
+        {
+            std::span<const geom::vertex>           m_Vertices;
+            std::span<const geom::vertex_extras>    m_VertexExtras;
+            std::span<const geom::vertex_skin>      m_VertexSkins;      // Empty for a static geom
+            std::span<const std::uint16_t>          m_Indices;
+        };
+
+        //--------------------------------------------------------------------------------------
+        // A geom can be paged when it is a mapped blob and none of its streams is encoded
+        //--------------------------------------------------------------------------------------
+        static bool isPageable(const geom& Geom) noexcept
+        {
+            return Geom.m_pBlob != nullptr
+                && Geom.m_IndexEncoding        == geom::index_encoding::RAW
+                && Geom.m_VertexEncoding       == geom::vertex_encoding::RAW
+                && Geom.m_VertexExtrasEncoding == geom::vertex_encoding::RAW;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // bAllResident tells if the data of every LOD was touched while loading (see
+        // xgpu::load_options::m_bUploadAllLODs), otherwise only the coarsest LODs are resident
+        //--------------------------------------------------------------------------------------
+        void Initialize(const geom& Geom, bool bAllResident = true) noexcept
+        {
+            m_pGeom     = &Geom;
+            m_bPaged    = isPageable(Geom);
+            m_State.assign(Geom.m_nLODs, m_bPaged == false ? state::PINNED : bAllResident ? state::RESIDENT : state::EVICTED);
+
+            if (m_bPaged == false) return;
+
+            for (const auto& Mesh : Geom.getMeshes())
+            {
+                if (Mesh.m_nLODs == 0) continue;
+
+                const auto iCoarsest = static_cast<std::size_t>(Mesh.m_iLOD) + Mesh.m_nLODs - 1;
+                Request(iCoarsest);
+                m_State[iCoarsest] = state::PINNED;
+            }
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Asks the OS to read the LOD in the background (does not block)
+        //--------------------------------------------------------------------------------------
+        void Request(std::size_t iLOD) noexcept
+        {
+            if (isResident(iLOD)) return;
+            m_State[iLOD] = state::RESIDENT;
+
+            ForEachRange(iLOD, [](std::byte* pBegin, std::byte* pEnd)
+            {
+            #if defined(_WIN32)
+                WIN32_MEMORY_RANGE_ENTRY Entry{ pBegin, static_cast<SIZE_T>(pEnd - pBegin) };
+                PrefetchVirtualMemory(GetCurrentProcess(), 1, &Entry, 0);
+            #else
+                ::madvise(pBegin, static_cast<std::size_t>(pEnd - pBegin), MADV_WILLNEED);
+            #endif
+            }, false);
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Releases the memory of the LOD, the data is read again from the file if it is used.
+        // On Windows VirtualUnlock on pages that are not locked removes them from the working set
+        // (Offer/ReclaimVirtualMemory only take private memory, not the pages of a file view).
+        //--------------------------------------------------------------------------------------
+        void Evict(std::size_t iLOD) noexcept
+        {
+            if (m_State[iLOD] != state::RESIDENT) return;
+            m_State[iLOD] = state::EVICTED;
+
+            // The data pages are never written (they are still the pages of the file), so
+            // dropping them just forces a read from the file
+            ForEachRange(iLOD, [](std::byte* pBegin, std::byte* pEnd)
+            {
+            #if defined(_WIN32)
+                VirtualUnlock(pBegin, static_cast<SIZE_T>(pEnd - pBegin));
+            #else
+                ::madvise(pBegin, static_cast<std::size_t>(pEnd - pBegin), MADV_DONTNEED);
+            #endif
+            }, true);
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        bool isResident(std::size_t iLOD) const noexcept
+        {
+            return m_State[iLOD] == state::RESIDENT || m_State[iLOD] == state::PINNED;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Finest LOD of a mesh that is resident (the coarsest one always is)
+        //--------------------------------------------------------------------------------------
+        std::size_t getFinestResident(std::size_t iMesh) const noexcept
+        {
+            const auto& Mesh = m_pGeom->m_pMesh[iMesh];
+            for (std::size_t i = Mesh.m_iLOD; i + 1 < std::size_t(Mesh.m_iLOD) + Mesh.m_nLODs; ++i)
+                if (isResident(i)) return i;
+            return std::size_t(Mesh.m_iLOD) + Mesh.m_nLODs - 1;
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        page getPage(std::size_t iLOD) const noexcept
+        {
+            const auto& L = m_pGeom->m_pLOD[iLOD];
+            return
+            { .m_Vertices       = m_pGeom->m_VertexEncoding       == geom::vertex_encoding::RAW ? m_pGeom->getVertices().subspan(L.m_iVertex, L.m_nVertices)     : std::span<const geom::vertex>{}
+            , .m_VertexExtras   = m_pGeom->m_VertexExtrasEncoding == geom::vertex_encoding::RAW ? m_pGeom->getVertexExtras().subspan(L.m_iVertex, L.m_nVertices) : std::span<const geom::vertex_extras>{}
+            , .m_VertexSkins    = m_pGeom->isSkinned() ? m_pGeom->getVertexSkins().subspan(L.m_iVertex, L.m_nVertices) : std::span<const geom::vertex_skin>{}
+            , .m_Indices        = m_pGeom->m_IndexEncoding == geom::index_encoding::RAW ? m_pGeom->getIndices().subspan(L.m_iIndex, L.m_nIndices) : std::span<const std::uint16_t>{}
+            };
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Bytes of vertex/index data that the resident LODs use
+        //--------------------------------------------------------------------------------------
+        std::size_t getResidentBytes(void) const noexcept
+        {
+            std::size_t Total = 0;
+            for (std::size_t i = 0; i < m_State.size(); ++i)
+            {
+                if (isResident(i) == false) continue;
+                const auto& L = m_pGeom->m_pLOD[i];
+                Total += L.m_nVertices * (sizeof(geom::vertex) + sizeof(geom::vertex_extras) + (m_pGeom->isSkinned() ? sizeof(geom::vertex_skin) : 0)) + L.m_nIndices * sizeof(std::uint16_t);
+            }
+            return Total;
+        }
+
+    private:
+
+        enum class state : std::uint8_t
+        { EVICTED                   // Not read since the load or released by Evict
+        , RESIDENT
+        , PINNED
+        };
+
+        // Calls Function with the vertex, extras, skin and index ranges of the LOD. With bInnerPages the
+        // ranges shrink to the OS pages that are completely inside (neighbours share the others).
+        template< typename T_FUNCTION >
+        void ForEachRange(std::size_t iLOD, T_FUNCTION&& Function, bool bInnerPages) const noexcept
+        {
+            const auto  Page     = getPage(iLOD);
+            const auto  PageSize = getOSPageSize();
+
+            auto Call = [&](const void* pData, std::size_t Size)
+            {
+                auto Begin = reinterpret_cast<std::uintptr_t>(pData);
+                auto End   = Begin + Size;
+                if (bInnerPages)
+                {
+                    Begin = (Begin + PageSize - 1) & ~(PageSize - 1);
+                    End   = End & ~(PageSize - 1);
+                }
+                else
+                {
+                    Begin = Begin & ~(PageSize - 1);
+                }
+                if (End > Begin) Function(reinterpret_cast<std::byte*>(Begin), reinterpret_cast<std::byte*>(End));
+            };
+
+            Call(Page.m_Vertices.data(),     Page.m_Vertices.size_bytes());
+            Call(Page.m_VertexExtras.data(), Page.m_VertexExtras.size_bytes());
+            Call(Page.m_VertexSkins.data(),  Page.m_VertexSkins.size_bytes());
+            Call(Page.m_Indices.data(),      Page.m_Indices.size_bytes());
+        }
+
+        static std::uintptr_t getOSPageSize(void) noexcept
+        {
+        #if defined(_WIN32)
+            static const std::uintptr_t PageSize = []{ SYSTEM_INFO Info; GetSystemInfo(&Info); return static_cast<std::uintptr_t>(Info.dwPageSize); }();
+        #else
+            static const std::uintptr_t PageSize = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        #endif
+            return PageSize;
+        }
+
+        const geom*             m_pGeom     = nullptr;
+        bool                    m_bPaged    = false;
+        std::vector<state>      m_State     = {};
+    };
+}
+
+#endif
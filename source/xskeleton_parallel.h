@@ -0,0 +1,35 @@
+#ifndef XSKELETON_PARALLEL_H
+#define XSKELETON_PARALLEL_H
+#pragma once
+
+#include "dependencies/xscheduler/source/xscheduler.h"
+
+namespace xskeleton
+{
+    //-------------------------------------------------------------------------
+    // Runs Function(i) for every i in [0, Count) on the xscheduler workers and waits for all of them.
+    // Every index becomes a job, so callers should keep the work per index coarse (a mesh, a submesh, ...)
+    //-------------------------------------------------------------------------
+    template< typename T_FUNCTION >
+    void ParallelFor( std::size_t Count, T_FUNCTION&& Function ) noexcept
+    {
+        if (Count == 0) return;
+        if (Count == 1)
+        {
+            Function(std::size_t{ 0 });
+            return;
+        }
+
+        xscheduler::task_group Group(xscheduler::str_v<"xskeleton::ParallelFor">);
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            Group.Submit([&Function, i]
+            {
+                Function(i);
+            });
+        }
+        Group.join();
+    }
+}
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef XSKELETON_POSE_H
+#define XSKELETON_POSE_H
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "xskeleton_skeleton.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define XSKELETON_POSE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XSKELETON_POSE_SSE2
+#endif
+
+//
+// Per frame pose kernels of a skeleton. A local pose is a structure of arrays of floats with
+// one stream per component, each getStride(nBones) floats long:
+//
+//      TX TY TZ | RX RY RZ RW | SX SY SZ       - Translation, rotation quaternion and scale
+//
+// ComputePalette turns it into the skinning palette (Model[i] * InverseBind[i], see
+// skeleton) in two passes:
+//
+//      1. Local TRS to 3x4 matrices, the bones are independent so 8 (AVX2) or 4 (SSE) of them
+//         go through the same instructions and are transposed into matrices at the end.
+//      2. One forward pass in parent order that writes the model matrix and the palette entry
+//         of every bone. A bone needs its parent first, so here the SIMD works on the rows of
+//         the matrices instead of across bones.
+//
+// Without SSE2 both passes use the scalar skeleton functions, which is also what
+// ComputePaletteScalar does (the reference for the benchmark).
+//
+namespace xskeleton::pose
+{
+    using affine = skeleton::affine;
+
+    enum stream : int
+    { TX, TY, TZ
+    , RX, RY, RZ, RW
+    , SX, SY, SZ
+    , stream_count_v
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Floats between two streams, rounded up to 8 so every stream is 32 byte aligned when
+    // the pose is
+    //--------------------------------------------------------------------------------------
+    constexpr std::size_t getStride(std::size_t nBones) noexcept
+    {
+        return (nBones + 7) & ~std::size_t{ 7 };
+    }
+
+    constexpr std::size_t getLocalPoseSize(std::size_t nBones) noexcept
+    {
+        return stream_count_v * getStride(nBones);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Fills a local pose (getLocalPoseSize floats) with the bind pose of the skeleton
+    //--------------------------------------------------------------------------------------
+    inline void SetBindPose(const skeleton& Skeleton, std::span<float> Local) noexcept
+    {
+        const auto Stride = getStride(Skeleton.m_nBones);
+        for (std::size_t i = 0; i < Skeleton.m_nBones; ++i)
+        {
+            const auto& T = Skeleton.m_pBindTranslation[i];
+            const auto& R = Skeleton.m_pBindRotation[i];
+            const auto& S = Skeleton.m_pBindScale[i];
+
+            Local[TX * Stride + i] = T.m_X; Local[TY * Stride + i] = T.m_Y; Local[TZ * Stride + i] = T.m_Z;
+            Local[RX * Stride + i] = R.m_X; Local[RY * Stride + i] = R.m_Y; Local[RZ * Stride + i] = R.m_Z; Local[RW * Stride + i] = R.m_W;
+            Local[SX * Stride + i] = S.m_X; Local[SY * Stride + i] = S.m_Y; Local[SZ * Stride + i] = S.m_Z;
+        }
+    }
+
+    namespace kernels
+    {
+    #if defined(XSKELETON_POSE_SSE2)
+        //--------------------------------------------------------------------------------------
+        // Same operations for both widths, so the TRS to matrix math is written once
+        //--------------------------------------------------------------------------------------
+        struct sse
+        {
+            using type = __m128;
+            inline static constexpr std::size_t width_v = 4;
+
+            static type Load(const float* p)        noexcept { return _mm_loadu_ps(p); }
+            static type Set (float V)               noexcept { return _mm_set1_ps(V); }
+            static type Add (type A, type B)        noexcept { return _mm_add_ps(A, B); }
+            static type Sub (type A, type B)        noexcept { return _mm_sub_ps(A, B); }
+            static type Mul (type A, type B)        noexcept { return _mm_mul_ps(A, B); }
+
+            // Transposes 4 streams (a row component across 4 bones) into the row of 4 bones
+            static void StoreRows(affine* pOut, int Row, type A, type B, type C, type D) noexcept
+            {
+                const type T0 = _mm_unpacklo_ps(A, B), T1 = _mm_unpackhi_ps(A, B);
+                const type T2 = _mm_unpacklo_ps(C, D), T3 = _mm_unpackhi_ps(C, D);
+                _mm_storeu_ps(&pOut[0].m_Rows[Row].m_X, _mm_movelh_ps(T0, T2));
+                _mm_storeu_ps(&pOut[1].m_Rows[Row].m_X, _mm_movehl_ps(T2, T0));
+                _mm_storeu_ps(&pOut[2].m_Rows[Row].m_X, _mm_movelh_ps(T1, T3));
+                _mm_storeu_ps(&pOut[3].m_Rows[Row].m_X, _mm_movehl_ps(T3, T1));
+            }
+        };
+
+    #if defined(__AVX2__)
+        struct avx
+        {
+            using type = __m256;
+            inline static constexpr std::size_t width_v = 8;
+
+            static type Load(const float* p)        noexcept { return _mm256_loadu_ps(p); }
+            static type Set (float V)               noexcept { return _mm256_set1_ps(V); }
+            static type Add (type A, type B)        noexcept { return _mm256_add_ps(A, B); }
+            static type Sub (type A, type B)        noexcept { return _mm256_sub_ps(A, B); }
+            static type Mul (type A, type B)        noexcept { return _mm256_mul_ps(A, B); }
+
+            // The unpacks work inside each 128 bit lane, so the low lane ends with bones 0..3 and the high one with 4..7
+            static void StoreRows(affine* pOut, int Row, type A, type B, type C, type D) noexcept
+            {
+                const type T0 = _mm256_unpacklo_ps(A, B), T1 = _mm256_unpackhi_ps(A, B);
+                const type T2 = _mm256_unpacklo_ps(C, D), T3 = _mm256_unpackhi_ps(C, D);
+                const type R0 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(1, 0, 1, 0));
+                const type R1 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(3, 2, 3, 2));
+                const type R2 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(1, 0, 1, 0));
+                const type R3 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(3, 2, 3, 2));
+                _mm_storeu_ps(&pOut[0].m_Rows[Row].m_X, _mm256_castps256_ps128(R0));
+                _mm_storeu_ps(&pOut[1].m_Rows[Row].m_X, _mm256_castps256_ps128(R1));
+                _mm_storeu_ps(&pOut[2].m_Rows[Row].m_X, _mm256_castps256_ps128(R2));
+                _mm_storeu_ps(&pOut[3].m_Rows[Row].m_X, _mm256_castps256_ps128(R3));
+                _mm_storeu_ps(&pOut[4].m_Rows[Row].m_X, _mm256_extractf128_ps(R0, 1));
+                _mm_storeu_ps(&pOut[5].m_Rows[Row].m_X, _mm256_extractf128_ps(R1, 1));
+                _mm_storeu_ps(&pOut[6].m_Rows[Row].m_X, _mm256_extractf128_ps(R2, 1));
+                _mm_storeu_ps(&pOut[7].m_Rows[Row].m_X, _mm256_extractf128_ps(R3, 1));
+            }
+        };
+    #endif
+
+        //--------------------------------------------------------------------------------------
+        // skeleton::FromTRS for V::width_v bones starting at i
+        //--------------------------------------------------------------------------------------
+        template< typename V >
+        inline void FromTRS(const float* pLocal, std::size_t Stride, std::size_t i, affine* pOut) noexcept
+        {
+            using type = typename V::type;
+            auto S = [&](stream Stream) { return V::Load(pLocal + Stream * Stride + i); };
+
+            const type X = S(RX), Y = S(RY), Z = S(RZ), W = S(RW);
+            const type One = V::Set(1.0f), Two = V::Set(2.0f);
+
+            const type X2 = V::Mul(X, Two), Y2 = V::Mul(Y, Two), Z2 = V::Mul(Z, Two);
+            const type XX = V::Mul(X, X2),  YY = V::Mul(Y, Y2),  ZZ = V::Mul(Z, Z2);
+            const type XY = V::Mul(X, Y2),  XZ = V::Mul(X, Z2),  YZ = V::Mul(Y, Z2);
+            const type WX = V::Mul(W, X2),  WY = V::Mul(W, Y2),  WZ = V::Mul(W, Z2);
+
+            const type SX_ = S(SX), SY_ = S(SY), SZ_ = S(SZ);
+
+            V::StoreRows(pOut, 0, V::Mul(V::Sub(One, V::Add(YY, ZZ)), SX_), V::Mul(V::Sub(XY, WZ), SY_), V::Mul(V::Add(XZ, WY), SZ_), S(TX));
+            V::StoreRows(pOut, 1, V::Mul(V::Add(XY, WZ), SX_), V::Mul(V::Sub(One, V::Add(XX, ZZ)), SY_), V::Mul(V::Sub(YZ, WX), SZ_), S(TY));
+            V::StoreRows(pOut, 2, V::Mul(V::Sub(XZ, WY), SX_), V::Mul(V::Add(YZ, WX), SY_), V::Mul(V::Sub(One, V::Add(XX, YY)), SZ_), S(TZ));
+        }
+
+        //--------------------------------------------------------------------------------------
+        // A matrix in registers, one row per register, so the model matrix of a bone goes
+        // straight into its palette entry without a round trip to memory
+        //--------------------------------------------------------------------------------------
+        struct rows
+        {
+            __m128  m_Row[3];
+        };
+
+        inline rows Load(const affine& A) noexcept
+        {
+            return { { _mm_loadu_ps(&A.m_Rows[0].m_X), _mm_loadu_ps(&A.m_Rows[1].m_X), _mm_loadu_ps(&A.m_Rows[2].m_X) } };
+        }
+
+        inline void Store(affine& A, const rows& R) noexcept
+        {
+            _mm_storeu_ps(&A.m_Rows[0].m_X, R.m_Row[0]);
+            _mm_storeu_ps(&A.m_Rows[1].m_X, R.m_Row[1]);
+            _mm_storeu_ps(&A.m_Rows[2].m_X, R.m_Row[2]);
+        }
+
+        //--------------------------------------------------------------------------------------
+        // A * B, every row of the result is a linear combination of the rows of B plus the
+        // translation of A in W
+        //--------------------------------------------------------------------------------------
+        inline rows Multiply(const rows& A, const rows& B) noexcept
+        {
+            const __m128 WMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+            rows R;
+            for (int r = 0; r < 3; ++r)
+            {
+                const __m128 Row = A.m_Row[r];
+                __m128       V   = _mm_and_ps(Row, WMask);
+                V = _mm_add_ps(V, _mm_mul_ps(_mm_shuffle_ps(Row, Row, _MM_SHUFFLE(0, 0, 0, 0)), B.m_Row[0]));
+                V = _mm_add_ps(V, _mm_mul_ps(_mm_shuffle_ps(Row, Row, _MM_SHUFFLE(1, 1, 1, 1)), B.m_Row[1]));
+                V = _mm_add_ps(V, _mm_mul_ps(_mm_shuffle_ps(Row, Row, _MM_SHUFFLE(2, 2, 2, 2)), B.m_Row[2]));
+                R.m_Row[r] = V;
+            }
+            return R;
+        }
+    #endif
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Local pose (getLocalPoseSize floats) to the local matrix of every bone
+    //--------------------------------------------------------------------------------------
+    inline void LocalToAffine(std::span<const float> Local, std::size_t nBones, std::span<affine> Out) noexcept
+    {
+        const auto      Stride  = getStride(nBones);
+        const float*    p       = Local.data();
+        std::size_t     i       = 0;
+
+    #if defined(__AVX2__)
+        for (; i + 8 <= nBones; i += 8) kernels::FromTRS<kernels::avx>(p, Stride, i, &Out[i]);
+    #endif
+    #if defined(XSKELETON_POSE_SSE2)
+        for (; i + 4 <= nBones; i += 4) kernels::FromTRS<kernels::sse>(p, Stride, i, &Out[i]);
+    #endif
+        for (; i < nBones; ++i)
+        {
+            Out[i] = skeleton::FromTRS
+            ( { p[TX * Stride + i], p[TY * Stride + i], p[TZ * Stride + i], 0 }
+            , { p[RX * Stride + i], p[RY * Stride + i], p[RZ * Stride + i], p[RW * Stride + i] }
+            , { p[SX * Stride + i], p[SY * Stride + i], p[SZ * Stride + i], 0 }
+            );
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Model space matrices and skinning palette of a local pose, Model and Palette have
+    // m_nBones entries (Model can be reused as scratch once the palette is done)
+    //--------------------------------------------------------------------------------------
+    inline void ComputePalette(const skeleton& Skeleton, std::span<const float> Local, std::span<affine> Model, std::span<affine> Palette) noexcept
+    {
+        LocalToAffine(Local, Skeleton.m_nBones, Model);
+
+    #if defined(XSKELETON_POSE_SSE2)
+        using namespace kernels;
+
+        for (std::size_t i = 0; i < Skeleton.m_nRoots; ++i)
+            Store(Palette[i], Multiply(Load(Model[i]), Load(Skeleton.m_pInverseBind[i])));
+
+        for (std::size_t i = Skeleton.m_nRoots; i < Skeleton.m_nBones; ++i)
+        {
+            const rows M = Multiply(Load(Model[Skeleton.m_pParent[i]]), Load(Model[i]));
+            Store(Model[i], M);
+            Store(Palette[i], Multiply(M, Load(Skeleton.m_pInverseBind[i])));
+        }
+    #else
+        for (std::size_t i = 0; i < Skeleton.m_nRoots; ++i)
+            Palette[i] = skeleton::Multiply(Model[i], Skeleton.m_pInverseBind[i]);
+
+        for (std::size_t i = Skeleton.m_nRoots; i < Skeleton.m_nBones; ++i)
+        {
+            Model[i]   = skeleton::Multiply(Model[Skeleton.m_pParent[i]], Model[i]);
+            Palette[i] = skeleton::Multiply(Model[i], Skeleton.m_pInverseBind[i]);
+        }
+    #endif
+    }
+
+    //--------------------------------------------------------------------------------------
+    // ComputePalette with the scalar skeleton functions only
+    //--------------------------------------------------------------------------------------
+    inline void ComputePaletteScalar(const skeleton& Skeleton, std::span<const float> Local, std::span<affine> Model, std::span<affine> Palette) noexcept
+    {
+        const auto      Stride  = getStride(Skeleton.m_nBones);
+        const float*    p       = Local.data();
+
+        for (std::size_t i = 0; i < Skeleton.m_nBones; ++i)
+        {
+            Model[i] = skeleton::FromTRS
+            ( { p[TX * Stride + i], p[TY * Stride + i], p[TZ * Stride + i], 0 }
+            , { p[RX * Stride + i], p[RY * Stride + i], p[RZ * Stride + i], p[RW * Stride + i] }
+            , { p[SX * Stride + i], p[SY * Stride + i], p[SZ * Stride + i], 0 }
+            );
+        }
+
+        Skeleton.ComputeModelPose(Model, Model);
+
+        for (std::size_t i = 0; i < Skeleton.m_nBones; ++i)
+            Palette[i] = skeleton::Multiply(Model[i], Skeleton.m_pInverseBind[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef XSKELETON_SKELETON_H
+#define XSKELETON_SKELETON_H
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+//
+// Bone hierarchy of a skinned geom, stored as a structure of arrays. The bones are in breadth
+// first order, so every parent comes before its children and all the roots come first:
+//
+//      Bones [0, m_nRoots)         - Roots (parent is invalid_bone_v)
+//      Bones [m_nRoots, m_nBones)  - Parent index is always smaller than the bone index
+//
+// With that order the model space pose is a single forward pass over the arrays, a root is a
+// copy and any other bone is its parent times its local transform, without branches or
+// recursion (see ComputeModelPose).
+//
+// The bind pose is the local transform of every bone relative to its parent (translation,
+// rotation quaternion and scale). The inverse bind matrices take a model space position of the
+// bind pose to the space of the bone, so a skinning matrix is Model[i] * InverseBind[i].
+//
+namespace xskeleton
+{
+    struct skeleton
+    {
+        inline static constexpr auto invalid_bone_v = std::int16_t{ -1 };
+
+        struct vec4
+        {
+            float m_X, m_Y, m_Z, m_W;
+        };
+
+        //-------------------------------------------------------------------------
+        // Affine transform as the three rows of a 3x4 matrix: the rotation/scale is the 3x3 part
+        // and the translation is the W column. Points transform as row . (x, y, z, 1)
+        //-------------------------------------------------------------------------
+        struct affine
+        {
+            std::array<vec4, 3>     m_Rows;
+        };
+
+        using name = std::array<char, 32>;
+
+        //-------------------------------------------------------------------------
+
+        inline void                     Initialize              (void)                                                              noexcept;
+        inline int                      findBone                (const char* pName)                                         const   noexcept;
+        inline void                     ComputeBindLocal        (std::span<affine> Local)                                   const   noexcept;
+        inline void                     ComputeModelPose        (std::span<const affine> Local, std::span<affine> Model)    const   noexcept;
+        constexpr static affine         FromTRS                 (const vec4& T, const vec4& R, const vec4& S)                       noexcept;
+        constexpr static affine         Multiply                (const affine& A, const affine& B)                                  noexcept;
+        constexpr static affine         Inverse                 (const affine& A)                                                   noexcept;
+
+        inline std::span<std::int16_t>  getParents              (void)  const   noexcept { return { m_pParent,          m_nBones }; }
+        inline std::span<name>          getNames                (void)  const   noexcept { return { m_pName,            m_nBones }; }
+        inline std::span<vec4>          getBindTranslations     (void)  const   noexcept { return { m_pBindTranslation, m_nBones }; }
+        inline std::span<vec4>          getBindRotations        (void)  const   noexcept { return { m_pBindRotation,    m_nBones }; }
+        inline std::span<vec4>          getBindScales           (void)  const   noexcept { return { m_pBindScale,       m_nBones }; }
+        inline std::span<affine>        getInverseBinds         (void)  const   noexcept { return { m_pInverseBind,     m_nBones }; }
+
+        std::int16_t*                   m_pParent;              // Parent of every bone, invalid_bone_v for the roots
+        name*                           m_pName;
+        vec4*                           m_pBindTranslation;     // XYZ, W = 0
+        vec4*                           m_pBindRotation;        // Quaternion XYZW
+        vec4*                           m_pBindScale;           // XYZ, W = 0
+        affine*                         m_pInverseBind;         // Model space bind pose -> bone space
+        std::uint16_t                   m_nBones;
+        std::uint16_t                   m_nRoots;
+    };
+
+    static_assert(sizeof(skeleton::affine) == 48);
+
+    //-------------------------------------------------------------------------
+
+    void skeleton::Initialize(void) noexcept
+    {
+        std::memset(this, 0, sizeof(*this));
+    }
+
+    //-------------------------------------------------------------------------
+    // Linear search, bones are looked up by name when an animation is bound, not per frame
+    //-------------------------------------------------------------------------
+    int skeleton::findBone(const char* pName) const noexcept
+    {
+        for (int i = 0; i < m_nBones; ++i)
+            if (std::strcmp(m_pName[i].data(), pName) == 0) return i;
+        return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Local transform of every bone in the bind pose
+    //-------------------------------------------------------------------------
+    void skeleton::ComputeBindLocal(std::span<affine> Local) const noexcept
+    {
+        for (std::size_t i = 0; i < m_nBones; ++i)
+            Local[i] = FromTRS(m_pBindTranslation[i], m_pBindRotation[i], m_pBindScale[i]);
+    }
+
+    //-------------------------------------------------------------------------
+    // Model space transform of every bone given their local transforms (both have m_nBones)
+    //-------------------------------------------------------------------------
+    void skeleton::ComputeModelPose(std::span<const affine> Local, std::span<affine> Model) const noexcept
+    {
+        for (std::size_t i = 0; i < m_nRoots; ++i)
+            Model[i] = Local[i];
+
+        for (std::size_t i = m_nRoots; i < m_nBones; ++i)
+            Model[i] = Multiply(Model[m_pParent[i]], Local[i]);
+    }
+
+    //-------------------------------------------------------------------------
+
+    constexpr skeleton::affine skeleton::FromTRS(const vec4& T, const vec4& R, const vec4& S) noexcept
+    {
+        const float XX = R.m_X * R.m_X, YY = R.m_Y * R.m_Y, ZZ = R.m_Z * R.m_Z;
+        const float XY = R.m_X * R.m_Y, XZ = R.m_X * R.m_Z, YZ = R.m_Y * R.m_Z;
+        const float WX = R.m_W * R.m_X, WY = R.m_W * R.m_Y, WZ = R.m_W * R.m_Z;
+
+        return {{{
+              { (1 - 2 * (YY + ZZ)) * S.m_X,    2 * (XY - WZ) * S.m_Y,          2 * (XZ + WY) * S.m_Z,          T.m_X }
+            , { 2 * (XY + WZ) * S.m_X,          (1 - 2 * (XX + ZZ)) * S.m_Y,    2 * (YZ - WX) * S.m_Z,          T.m_Y }
+            , { 2 * (XZ - WY) * S.m_X,          2 * (YZ + WX) * S.m_Y,          (1 - 2 * (XX + YY)) * S.m_Z,    T.m_Z }
+        }}};
+    }
+
+    //-------------------------------------------------------------------------
+    // A * B, B is applied first
+    //-------------------------------------------------------------------------
+    constexpr skeleton::affine skeleton::Multiply(const affine& A, const affine& B) noexcept
+    {
+        const auto& b0 = B.m_Rows[0];
+        const auto& b1 = B.m_Rows[1];
+        const auto& b2 = B.m_Rows[2];
+
+        affine R{};
+        for (int r = 0; r < 3; ++r)
+        {
+            const auto& a = A.m_Rows[r];
+            R.m_Rows[r] =
+            { a.m_X * b0.m_X + a.m_Y * b1.m_X + a.m_Z * b2.m_X
+            , a.m_X * b0.m_Y + a.m_Y * b1.m_Y + a.m_Z * b2.m_Y
+            , a.m_X * b0.m_Z + a.m_Y * b1.m_Z + a.m_Z * b2.m_Z
+            , a.m_X * b0.m_W + a.m_Y * b1.m_W + a.m_Z * b2.m_W + a.m_W
+            };
+        }
+        return R;
+    }
+
+    //-------------------------------------------------------------------------
+    // General affine inverse (the scale does not need to be uniform)
+    //-------------------------------------------------------------------------
+    constexpr skeleton::affine skeleton::Inverse(const affine& A) noexcept
+    {
+        const auto& r0 = A.m_Rows[0];
+        const auto& r1 = A.m_Rows[1];
+        const auto& r2 = A.m_Rows[2];
+
+        const float c00 = r1.m_Y * r2.m_Z - r1.m_Z * r2.m_Y;
+        const float c01 = r1.m_Z * r2.m_X - r1.m_X * r2.m_Z;
+        const float c02 = r1.m_X * r2.m_Y - r1.m_Y * r2.m_X;
+        const float Det = r0.m_X * c00 + r0.m_Y * c01 + r0.m_Z * c02;
+        const float s   = Det != 0.0f ? 1.0f / Det : 0.0f;
+
+        affine R{{{
+              { c00 * s, (r0.m_Z * r2.m_Y - r0.m_Y * r2.m_Z) * s, (r0.m_Y * r1.m_Z - r0.m_Z * r1.m_Y) * s, 0 }
+            , { c01 * s, (r0.m_X * r2.m_Z - r0.m_Z * r2.m_X) * s, (r0.m_Z * r1.m_X - r0.m_X * r1.m_Z) * s, 0 }
+            , { c02 * s, (r0.m_Y * r2.m_X - r0.m_X * r2.m_Y) * s, (r0.m_X * r1.m_Y - r0.m_Y * r1.m_X) * s, 0 }
+        }}};
+
+        for (auto& Row : R.m_Rows)
+            Row.m_W = -(Row.m_X * r0.m_W + Row.m_Y * r1.m_W + Row.m_Z * r2.m_W);
+
+        return R;
+    }
+}
+
+#endif
@@ -0,0 +1,540 @@
+#ifndef XSKELETON_SKINNING_H
+#define XSKELETON_SKINNING_H
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "xskeleton.h"
+#include "xskeleton_parallel.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define XSKELETON_SKINNING_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XSKELETON_SKINNING_SSE2
+#endif
+
+//
+// CPU linear blend skinning of the compressed clusters of a geom, for the places that need the
+// skinned surface without a GPU (hit detection on a server, bakes). The result is a float
+// position and a unit normal for every vertex of the geom, written at the index of the vertex so
+// the index buffer of the geom can be used with it as it is:
+//
+//      Positions[Cluster.m_iVertex + i] = Sum(Weight[j] * Palette[Bone[j]]) * Decode(Vertex[i])
+//
+// The palette is the one of pose::ComputePalette (one matrix per skeleton bone). For every
+// cluster the matrices of its bone palette (geom::getClusterBones) are multiplied once by the
+// dequantization of the cluster (m_PosScaleAndUScale / m_PosTrasnlationAndVScale), so a vertex
+// only blends up to 4 matrices and transforms its int16 position with the result. The normals
+// are the oct encoded ones of the vertex extras, moved by the same blended matrix (the
+// dequantization scale is removed first) and normalized.
+//
+// The clusters are cut into jobs of about vertices_per_job_v vertices that run on the xscheduler
+// workers (see ParallelFor). Inside a job the matrices are blended 2 vertices at a time with AVX2
+// or one at a time with SSE, and the results are stored 4 vertices at a time. Without SSE2 the
+// scalar kernel is used, which is also the reference of the benchmark (SkinClusterScalar).
+//
+// The vertex stream (and the extras when the normals are wanted) must be RAW, encoded geoms need
+// to be decoded first (see xskeleton_vertex_codec.h).
+//
+namespace xskeleton::skinning
+{
+    using geom   = xgeom_static::geom;
+    using affine = skeleton::affine;
+
+    inline static constexpr std::size_t     vertices_per_job_v  = 32 * 1024;
+    inline static constexpr std::size_t     max_cluster_bones_v = 256;          // geom::vertex_skin::m_iBone is 8 bits
+
+    namespace details
+    {
+        //--------------------------------------------------------------------------------------
+        // Palette entry of a cluster: the columns of Palette[Bone] * Dequantization (W = 0)
+        //--------------------------------------------------------------------------------------
+        struct alignas(16) bone_columns
+        {
+            std::array<skeleton::vec4, 4>   m_Col;
+        };
+
+        using cluster_palette = std::array<bone_columns, max_cluster_bones_v>;
+
+        //--------------------------------------------------------------------------------------
+        // Checks the streams and the ranges of a cluster (against the geom and the outputs)
+        // and builds its palette. InvScale takes a decoded normal to the space of the quantized
+        // positions (any positive factor works, the normals are normalized at the end).
+        //--------------------------------------------------------------------------------------
+        inline bool BuildClusterPalette(const geom& Geom, std::span<const affine> Palette, const geom::cluster& Cluster, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals, cluster_palette& Out, skeleton::vec4& InvScale) noexcept
+        {
+            const std::size_t End = std::size_t(Cluster.m_iVertex) + Cluster.m_nVertices;
+            if (   Geom.m_VertexEncoding != geom::vertex_encoding::RAW
+                || (Normals.empty() == false && Geom.m_VertexExtrasEncoding != geom::vertex_encoding::RAW)
+                || End > Geom.m_nVertices
+                || End > Positions.size()
+                || (Normals.empty() == false && End > Normals.size())
+                || std::size_t(Cluster.m_iBone)   + Cluster.m_nBones    > Geom.m_nClusterBones
+                || Cluster.m_nBones > max_cluster_bones_v
+                || (Cluster.m_nBones == 0 && Cluster.m_nVertices != 0) )
+                return false;
+
+            // Position = ((Q + 32768) / 32767.5 - 1) * Scale + Center = Q * A + B
+            const auto&     S = Cluster.m_PosScaleAndUScale;
+            const auto&     C = Cluster.m_PosTrasnlationAndVScale;
+            const float     A[3] = { S.m_X / 32767.5f, S.m_Y / 32767.5f, S.m_Z / 32767.5f };
+            const float     K    = 32768.0f / 32767.5f - 1.0f;
+            const float     B[3] = { K * S.m_X + C.m_X, K * S.m_Y + C.m_Y, K * S.m_Z + C.m_Z };
+
+            InvScale = { 1.0f / S.m_X, 1.0f / S.m_Y, 1.0f / S.m_Z, 0.0f };
+
+            for (std::uint32_t i = 0; i < Cluster.m_nBones; ++i)
+            {
+                const auto iBone = Geom.m_pClusterBone[Cluster.m_iBone + i];
+                if (iBone >= Palette.size()) return false;
+
+                const auto& M   = Palette[iBone].m_Rows;
+                auto&       Col = Out[i].m_Col;
+                Col[0] = { M[0].m_X * A[0], M[1].m_X * A[0], M[2].m_X * A[0], 0 };
+                Col[1] = { M[0].m_Y * A[1], M[1].m_Y * A[1], M[2].m_Y * A[1], 0 };
+                Col[2] = { M[0].m_Z * A[2], M[1].m_Z * A[2], M[2].m_Z * A[2], 0 };
+                Col[3] =
+                { M[0].m_X * B[0] + M[0].m_Y * B[1] + M[0].m_Z * B[2] + M[0].m_W
+                , M[1].m_X * B[0] + M[1].m_Y * B[1] + M[1].m_Z * B[2] + M[1].m_W
+                , M[2].m_X * B[0] + M[2].m_Y * B[1] + M[2].m_Z * B[2] + M[2].m_W
+                , 0
+                };
+            }
+
+            // The entries after m_nBones are not cleared, a corrupted vertex gets the bones of an
+            // older cluster but its 8 bit index never leaves the palette
+
+            return true;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Octahedral UNORM8 normal (see oct_encode in the compiler), not normalized
+        //--------------------------------------------------------------------------------------
+        inline skeleton::vec4 DecodeNormal(const geom::vertex_extras& Extras, const skeleton::vec4& InvScale) noexcept
+        {
+            float       X = Extras.m_OctNormal[0] * (2.0f / 255.0f) - 1.0f;
+            float       Y = Extras.m_OctNormal[1] * (2.0f / 255.0f) - 1.0f;
+            const float Z = 1.0f - std::abs(X) - std::abs(Y);
+            const float T = std::max(-Z, 0.0f);
+            X += X >= 0.0f ? -T : T;
+            Y += Y >= 0.0f ? -T : T;
+            return { X * InvScale.m_X, Y * InvScale.m_Y, Z * InvScale.m_Z, 0 };
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Reference kernel, one vertex at a time with plain floats. Returns false if the ranges of
+    // the cluster or its bones are out of the geom or the palette.
+    //--------------------------------------------------------------------------------------
+    inline bool SkinClusterScalar(const geom& Geom, std::span<const affine> Palette, const geom::cluster& Cluster, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals) noexcept
+    {
+        thread_local details::cluster_palette   Columns;
+        skeleton::vec4                          InvScale;
+        if (details::BuildClusterPalette(Geom, Palette, Cluster, Positions, Normals, Columns, InvScale) == false) return false;
+
+        const auto* pVertex = Geom.getVertices().data()    + Cluster.m_iVertex;
+        const auto* pSkin   = Geom.getVertexSkins().data() + Cluster.m_iVertex;
+        const auto* pExtras = Normals.empty() ? nullptr : Geom.getVertexExtras().data() + Cluster.m_iVertex;
+
+        for (std::uint32_t v = 0; v < Cluster.m_nVertices; ++v)
+        {
+            // Blended columns
+            std::array<skeleton::vec4, 4> Col{};
+            for (int i = 0; i < 4; ++i)
+            {
+                const float W = pSkin[v].m_Weight[i] * (1.0f / 255.0f);
+                const auto& M = Columns[pSkin[v].m_iBone[i]].m_Col;
+                for (int c = 0; c < 4; ++c)
+                {
+                    Col[c].m_X += M[c].m_X * W;
+                    Col[c].m_Y += M[c].m_Y * W;
+                    Col[c].m_Z += M[c].m_Z * W;
+                }
+            }
+
+            auto Transform = [&](float X, float Y, float Z, float W) -> geom::vec3
+            {
+                return
+                { Col[0].m_X * X + Col[1].m_X * Y + Col[2].m_X * Z + Col[3].m_X * W
+                , Col[0].m_Y * X + Col[1].m_Y * Y + Col[2].m_Y * Z + Col[3].m_Y * W
+                , Col[0].m_Z * X + Col[1].m_Z * Y + Col[2].m_Z * Z + Col[3].m_Z * W
+                };
+            };
+
+            Positions[Cluster.m_iVertex + v] = Transform(pVertex[v].m_XPos, pVertex[v].m_YPos, pVertex[v].m_ZPos, 1.0f);
+
+            if (pExtras)
+            {
+                const auto  N = details::DecodeNormal(pExtras[v], InvScale);
+                auto        R = Transform(N.m_X, N.m_Y, N.m_Z, 0.0f);
+                const float L = std::sqrt(R.m_X * R.m_X + R.m_Y * R.m_Y + R.m_Z * R.m_Z);
+                const float S = L > 0.0f ? 1.0f / L : 0.0f;
+                Normals[Cluster.m_iVertex + v] = { R.m_X * S, R.m_Y * S, R.m_Z * S };
+            }
+        }
+
+        return true;
+    }
+
+#if defined(XSKELETON_SKINNING_SSE2)
+    namespace kernels
+    {
+        //--------------------------------------------------------------------------------------
+        // Blended columns (W = 0) of one vertex applied to a position (Q.w = 1) and a normal (N.w = 0)
+        //--------------------------------------------------------------------------------------
+        struct result
+        {
+            __m128 m_Position;
+            __m128 m_Normal;
+        };
+
+        template< int T_LANE_V >
+        inline __m128 Splat(__m128 V) noexcept { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(T_LANE_V, T_LANE_V, T_LANE_V, T_LANE_V)); }
+
+        // The 4 UNORM8 weights of a skin as floats
+        inline __m128 LoadWeights(const geom::vertex_skin& Skin) noexcept
+        {
+            std::int32_t Packed;
+            std::memcpy(&Packed, Skin.m_Weight.data(), sizeof(Packed));
+            const __m128i Zero = _mm_setzero_si128();
+            const __m128i W    = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(Packed), Zero), Zero);
+            return _mm_mul_ps(_mm_cvtepi32_ps(W), _mm_set1_ps(1.0f / 255.0f));
+        }
+
+        // XYZ of the int16 position as floats, W = 1
+        inline __m128 LoadPosition(const geom::vertex& Vertex) noexcept
+        {
+            const __m128i Q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&Vertex));
+            const __m128  P = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(Q, Q), 16));
+            return _mm_or_ps(_mm_and_ps(P, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))), _mm_setr_ps(0, 0, 0, 1.0f));
+        }
+
+        template< bool T_NORMALS_V >
+        inline result SkinVertex(const details::cluster_palette& Columns, const geom::vertex& Vertex, const geom::vertex_skin& Skin, __m128 Normal) noexcept
+        {
+            const __m128    W   = LoadWeights(Skin);
+            const auto&     M0  = Columns[Skin.m_iBone[0]].m_Col;
+            const auto&     M1  = Columns[Skin.m_iBone[1]].m_Col;
+            const auto&     M2  = Columns[Skin.m_iBone[2]].m_Col;
+            const auto&     M3  = Columns[Skin.m_iBone[3]].m_Col;
+            const __m128    W0  = Splat<0>(W), W1 = Splat<1>(W), W2 = Splat<2>(W), W3 = Splat<3>(W);
+
+            __m128 Col[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                Col[c] = _mm_add_ps
+                ( _mm_add_ps(_mm_mul_ps(_mm_load_ps(&M0[c].m_X), W0), _mm_mul_ps(_mm_load_ps(&M1[c].m_X), W1))
+                , _mm_add_ps(_mm_mul_ps(_mm_load_ps(&M2[c].m_X), W2), _mm_mul_ps(_mm_load_ps(&M3[c].m_X), W3))
+                );
+            }
+
+            const __m128 P = LoadPosition(Vertex);
+            result R;
+            R.m_Position = _mm_add_ps
+            ( _mm_add_ps(_mm_mul_ps(Col[0], Splat<0>(P)), _mm_mul_ps(Col[1], Splat<1>(P)))
+            , _mm_add_ps(_mm_mul_ps(Col[2], Splat<2>(P)), Col[3])
+            );
+
+            if constexpr (T_NORMALS_V)
+            {
+                R.m_Normal = _mm_add_ps
+                ( _mm_add_ps(_mm_mul_ps(Col[0], Splat<0>(Normal)), _mm_mul_ps(Col[1], Splat<1>(Normal)))
+                , _mm_mul_ps(Col[2], Splat<2>(Normal))
+                );
+            }
+            return R;
+        }
+
+    #if defined(__AVX2__)
+        //--------------------------------------------------------------------------------------
+        // Same as SkinVertex for 2 vertices, one in each 128 bit half
+        //--------------------------------------------------------------------------------------
+        inline __m256 Load2(const skeleton::vec4& Lo, const skeleton::vec4& Hi) noexcept
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&Lo.m_X)), _mm_load_ps(&Hi.m_X), 1);
+        }
+
+        template< bool T_NORMALS_V >
+        inline void SkinVertex2(const details::cluster_palette& Columns, const geom::vertex* pVertex, const geom::vertex_skin* pSkin, __m256 Normal, result& A, result& B) noexcept
+        {
+            std::int32_t Packed[2];
+            std::memcpy(&Packed[0], pSkin[0].m_Weight.data(), sizeof(std::int32_t));
+            std::memcpy(&Packed[1], pSkin[1].m_Weight.data(), sizeof(std::int32_t));
+
+            const __m128i   W8  = _mm_unpacklo_epi32(_mm_cvtsi32_si128(Packed[0]), _mm_cvtsi32_si128(Packed[1]));
+            const __m256    W   = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(W8)), _mm256_set1_ps(1.0f / 255.0f));
+            const __m256    W0  = _mm256_permute_ps(W, _MM_SHUFFLE(0, 0, 0, 0));
+            const __m256    W1  = _mm256_permute_ps(W, _MM_SHUFFLE(1, 1, 1, 1));
+            const __m256    W2  = _mm256_permute_ps(W, _MM_SHUFFLE(2, 2, 2, 2));
+            const __m256    W3  = _mm256_permute_ps(W, _MM_SHUFFLE(3, 3, 3, 3));
+
+            const auto& A0 = Columns[pSkin[0].m_iBone[0]].m_Col; const auto& B0 = Columns[pSkin[1].m_iBone[0]].m_Col;
+            const auto& A1 = Columns[pSkin[0].m_iBone[1]].m_Col; const auto& B1 = Columns[pSkin[1].m_iBone[1]].m_Col;
+            const auto& A2 = Columns[pSkin[0].m_iBone[2]].m_Col; const auto& B2 = Columns[pSkin[1].m_iBone[2]].m_Col;
+            const auto& A3 = Columns[pSkin[0].m_iBone[3]].m_Col; const auto& B3 = Columns[pSkin[1].m_iBone[3]].m_Col;
+
+            __m256 Col[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                Col[c] = _mm256_add_ps
+                ( _mm256_add_ps(_mm256_mul_ps(Load2(A0[c], B0[c]), W0), _mm256_mul_ps(Load2(A1[c], B1[c]), W1))
+                , _mm256_add_ps(_mm256_mul_ps(Load2(A2[c], B2[c]), W2), _mm256_mul_ps(Load2(A3[c], B3[c]), W3))
+                );
+            }
+
+            // Both int16 positions in one load, the W lanes (m_Extra) are never used
+            const __m256 P = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pVertex))));
+            const __m256 R = _mm256_add_ps
+            ( _mm256_add_ps(_mm256_mul_ps(Col[0], _mm256_permute_ps(P, _MM_SHUFFLE(0, 0, 0, 0))), _mm256_mul_ps(Col[1], _mm256_permute_ps(P, _MM_SHUFFLE(1, 1, 1, 1))))
+            , _mm256_add_ps(_mm256_mul_ps(Col[2], _mm256_permute_ps(P, _MM_SHUFFLE(2, 2, 2, 2))), Col[3])
+            );
+            A.m_Position = _mm256_castps256_ps128(R);
+            B.m_Position = _mm256_extractf128_ps(R, 1);
+
+            if constexpr (T_NORMALS_V)
+            {
+                const __m256 N = _mm256_add_ps
+                ( _mm256_add_ps(_mm256_mul_ps(Col[0], _mm256_permute_ps(Normal, _MM_SHUFFLE(0, 0, 0, 0))), _mm256_mul_ps(Col[1], _mm256_permute_ps(Normal, _MM_SHUFFLE(1, 1, 1, 1))))
+                , _mm256_mul_ps(Col[2], _mm256_permute_ps(Normal, _MM_SHUFFLE(2, 2, 2, 2)))
+                );
+                A.m_Normal = _mm256_castps256_ps128(N);
+                B.m_Normal = _mm256_extractf128_ps(N, 1);
+            }
+        }
+    #endif
+
+        //--------------------------------------------------------------------------------------
+        // Same as details::DecodeNormal for 4 consecutive vertices, the results have W = 0
+        //--------------------------------------------------------------------------------------
+        inline void DecodeNormals4(const geom::vertex_extras* pExtras, __m128 InvScale, __m128 (&N)[4]) noexcept
+        {
+            static_assert(sizeof(geom::vertex_extras) == 8);
+
+            // The second 32 bits of every vertex are OctNormal.X, OctNormal.Y, OctTangent.X, OctTangent.Y
+            const __m128    A    = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pExtras + 0)));
+            const __m128    B    = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pExtras + 2)));
+            const __m128i   Oct  = _mm_castps_si128(_mm_shuffle_ps(A, B, _MM_SHUFFLE(3, 1, 3, 1)));
+            const __m128i   Mask = _mm_set1_epi32(0xff);
+
+            const __m128    K    = _mm_set1_ps(2.0f / 255.0f);
+            const __m128    One  = _mm_set1_ps(1.0f);
+            const __m128    Sign = _mm_set1_ps(-0.0f);
+            __m128          X    = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(Oct, Mask)), K), One);
+            __m128          Y    = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(Oct, 8), Mask)), K), One);
+            __m128          Z    = _mm_sub_ps(_mm_sub_ps(One, _mm_andnot_ps(Sign, X)), _mm_andnot_ps(Sign, Y));
+            const __m128    T    = _mm_max_ps(_mm_xor_ps(Z, Sign), _mm_setzero_ps());
+
+            // X += X >= 0 ? -T : T
+            X = _mm_sub_ps(X, _mm_or_ps(T, _mm_and_ps(_mm_cmplt_ps(X, _mm_setzero_ps()), Sign)));
+            Y = _mm_sub_ps(Y, _mm_or_ps(T, _mm_and_ps(_mm_cmplt_ps(Y, _mm_setzero_ps()), Sign)));
+
+            N[0] = _mm_mul_ps(X, Splat<0>(InvScale));
+            N[1] = _mm_mul_ps(Y, Splat<1>(InvScale));
+            N[2] = _mm_mul_ps(Z, Splat<2>(InvScale));
+            N[3] = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(N[0], N[1], N[2], N[3]);
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Normalizes the XYZ of 4 vectors (W = 0) with a refined reciprocal square root
+        //--------------------------------------------------------------------------------------
+        inline void Normalize4(__m128& V0, __m128& V1, __m128& V2, __m128& V3) noexcept
+        {
+            __m128 X = V0, Y = V1, Z = V2, W = V3;
+            _MM_TRANSPOSE4_PS(X, Y, Z, W);
+
+            const __m128 L2 = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(X, X), _mm_mul_ps(Y, Y)), _mm_mul_ps(Z, Z)), _mm_set1_ps(1e-30f));
+            const __m128 E  = _mm_rsqrt_ps(L2);
+            const __m128 S  = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), E), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(L2, E), E)));
+
+            V0 = _mm_mul_ps(V0, Splat<0>(S));
+            V1 = _mm_mul_ps(V1, Splat<1>(S));
+            V2 = _mm_mul_ps(V2, Splat<2>(S));
+            V3 = _mm_mul_ps(V3, Splat<3>(S));
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Stores the XYZ of 4 vectors as 4 packed vec3 (3 stores)
+        //--------------------------------------------------------------------------------------
+        inline void Store4(geom::vec3* pOut, __m128 V0, __m128 V1, __m128 V2, __m128 V3) noexcept
+        {
+            const __m128 T0 = _mm_shuffle_ps(V0, V1, _MM_SHUFFLE(0, 0, 2, 2));         // z0 z0 x1 x1
+            const __m128 T1 = _mm_shuffle_ps(V2, V3, _MM_SHUFFLE(0, 0, 2, 2));         // z2 z2 x3 x3
+            float*       p  = &pOut->m_X;
+            _mm_storeu_ps(p + 0, _mm_shuffle_ps(V0, T0, _MM_SHUFFLE(2, 0, 1, 0)));     // x0 y0 z0 x1
+            _mm_storeu_ps(p + 4, _mm_shuffle_ps(V1, V2, _MM_SHUFFLE(1, 0, 2, 1)));     // y1 z1 x2 y2
+            _mm_storeu_ps(p + 8, _mm_shuffle_ps(T1, V3, _MM_SHUFFLE(2, 1, 2, 0)));     // z2 x3 y3 z3
+        }
+
+        inline void Store1(geom::vec3& Out, __m128 V) noexcept
+        {
+            alignas(16) float F[4];
+            _mm_store_ps(F, V);
+            Out = { F[0], F[1], F[2] };
+        }
+
+        //--------------------------------------------------------------------------------------
+
+        template< bool T_NORMALS_V >
+        inline void SkinCluster(const details::cluster_palette& Columns, const skeleton::vec4& InvScale, const geom::vertex* pVertex, const geom::vertex_skin* pSkin, const geom::vertex_extras* pExtras, std::uint32_t nVertices, geom::vec3* pPositions, geom::vec3* pNormals) noexcept
+        {
+            auto Normal = [&](std::uint32_t v) -> skeleton::vec4
+            {
+                if constexpr (T_NORMALS_V) return details::DecodeNormal(pExtras[v], InvScale);
+                else                       return {};
+            };
+
+            const __m128  InvScale4 = _mm_loadu_ps(&InvScale.m_X);
+            std::uint32_t v         = 0;
+            for (; v + 4 <= nVertices; v += 4)
+            {
+                __m128 N[4];
+                if constexpr (T_NORMALS_V) DecodeNormals4(pExtras + v, InvScale4, N);
+                else                       N[0] = N[1] = N[2] = N[3] = _mm_setzero_ps();
+
+                result R[4];
+            #if defined(__AVX2__)
+                for (int i = 0; i < 4; i += 2)
+                    SkinVertex2<T_NORMALS_V>(Columns, pVertex + v + i, pSkin + v + i, _mm256_insertf128_ps(_mm256_castps128_ps256(N[i]), N[i + 1], 1), R[i], R[i + 1]);
+            #else
+                for (int i = 0; i < 4; ++i)
+                    R[i] = SkinVertex<T_NORMALS_V>(Columns, pVertex[v + i], pSkin[v + i], N[i]);
+            #endif
+                Store4(pPositions + v, R[0].m_Position, R[1].m_Position, R[2].m_Position, R[3].m_Position);
+
+                if constexpr (T_NORMALS_V)
+                {
+                    Normalize4(R[0].m_Normal, R[1].m_Normal, R[2].m_Normal, R[3].m_Normal);
+                    Store4(pNormals + v, R[0].m_Normal, R[1].m_Normal, R[2].m_Normal, R[3].m_Normal);
+                }
+            }
+
+            for (; v < nVertices; ++v)
+            {
+                const auto N = Normal(v);
+                result     R = SkinVertex<T_NORMALS_V>(Columns, pVertex[v], pSkin[v], _mm_setr_ps(N.m_X, N.m_Y, N.m_Z, 0));
+                Store1(pPositions[v], R.m_Position);
+
+                if constexpr (T_NORMALS_V)
+                {
+                    __m128 Unused = _mm_set1_ps(1.0f);
+                    Normalize4(R.m_Normal, Unused, Unused, Unused);
+                    Store1(pNormals[v], R.m_Normal);
+                }
+            }
+        }
+    }
+#endif
+
+    //--------------------------------------------------------------------------------------
+    // Skins one cluster on the calling thread. Returns false if the ranges of the cluster or
+    // its bones are out of the geom or the palette.
+    //--------------------------------------------------------------------------------------
+    inline bool SkinCluster(const geom& Geom, std::span<const affine> Palette, const geom::cluster& Cluster, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals) noexcept
+    {
+    #if defined(XSKELETON_SKINNING_SSE2)
+        thread_local details::cluster_palette   Columns;
+        skeleton::vec4                          InvScale;
+        if (details::BuildClusterPalette(Geom, Palette, Cluster, Positions, Normals, Columns, InvScale) == false) return false;
+
+        const auto* pVertex = Geom.getVertices().data()    + Cluster.m_iVertex;
+        const auto* pSkin   = Geom.getVertexSkins().data() + Cluster.m_iVertex;
+
+        if (Normals.empty())
+        {
+            kernels::SkinCluster<false>(Columns, InvScale, pVertex, pSkin, nullptr, Cluster.m_nVertices, Positions.data() + Cluster.m_iVertex, nullptr);
+        }
+        else
+        {
+            kernels::SkinCluster<true>(Columns, InvScale, pVertex, pSkin, Geom.getVertexExtras().data() + Cluster.m_iVertex, Cluster.m_nVertices, Positions.data() + Cluster.m_iVertex, Normals.data() + Cluster.m_iVertex);
+        }
+        return true;
+    #else
+        return SkinClusterScalar(Geom, Palette, Cluster, Positions, Normals);
+    #endif
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Skins the clusters [iCluster, iCluster + nClusters) in parallel. Palette has a matrix
+    // per skeleton bone, Positions has geom::m_nVertices entries and so does Normals unless it
+    // is empty (then only the positions are computed). The vertices that are not in the
+    // clusters are left as they are. Returns false if the geom is not skinned, a stream is
+    // encoded, a span is too small or a cluster is corrupted (the other clusters are still done).
+    //--------------------------------------------------------------------------------------
+    inline bool SkinClusters(const geom& Geom, std::span<const affine> Palette, std::size_t iCluster, std::size_t nClusters, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals = {}) noexcept
+    {
+        if (   Geom.isSkinned() == false
+            || Geom.m_VertexEncoding != geom::vertex_encoding::RAW
+            || (Normals.empty() == false && (Geom.m_VertexExtrasEncoding != geom::vertex_encoding::RAW || Normals.size() < Geom.m_nVertices))
+            || Palette.size()   < Geom.m_Skeleton.m_nBones
+            || Positions.size() < Geom.m_nVertices
+            || iCluster + nClusters > Geom.m_nClusters )
+            return false;
+
+        // Jobs of about vertices_per_job_v vertices, a job always has whole clusters
+        thread_local std::vector<std::size_t> JobStart;
+        JobStart.clear();
+        std::size_t nJobVertices = vertices_per_job_v;
+        for (std::size_t i = iCluster; i < iCluster + nClusters; ++i)
+        {
+            if (nJobVertices >= vertices_per_job_v)
+            {
+                JobStart.push_back(i);
+                nJobVertices = 0;
+            }
+            nJobVertices += Geom.m_pCluster[i].m_nVertices;
+        }
+        JobStart.push_back(iCluster + nClusters);
+
+        std::atomic<bool>   bOK     = true;
+        const auto&         Starts  = JobStart;
+        ParallelFor(Starts.size() - 1, [&](std::size_t iJob)
+        {
+            for (auto i = Starts[iJob]; i < Starts[iJob + 1]; ++i)
+            {
+                if (SkinCluster(Geom, Palette, Geom.m_pCluster[i], Positions, Normals) == false)
+                    bOK.store(false, std::memory_order_relaxed);
+            }
+        });
+
+        return bOK.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Skins every cluster of a LOD (the clusters of its submeshes are consecutive)
+    //--------------------------------------------------------------------------------------
+    inline bool SkinLOD(const geom& Geom, std::size_t iLOD, std::span<const affine> Palette, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals = {}) noexcept
+    {
+        if (iLOD >= Geom.m_nLODs) return false;
+
+        const auto& LOD = Geom.m_pLOD[iLOD];
+        if (LOD.m_nSubmesh == 0) return true;
+        if (std::size_t(LOD.m_iSubmesh) + LOD.m_nSubmesh > Geom.m_nSubMeshs) return false;
+
+        const auto& First = Geom.m_pSubMesh[LOD.m_iSubmesh];
+        const auto& Last  = Geom.m_pSubMesh[LOD.m_iSubmesh + LOD.m_nSubmesh - 1];
+        if (Last.m_iCluster < First.m_iCluster) return false;
+
+        return SkinClusters(Geom, Palette, First.m_iCluster, std::size_t(Last.m_iCluster) + Last.m_nCluster - First.m_iCluster, Positions, Normals);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Skins every cluster of the geom
+    //--------------------------------------------------------------------------------------
+    inline bool Skin(const geom& Geom, std::span<const affine> Palette, std::span<geom::vec3> Positions, std::span<geom::vec3> Normals = {}) noexcept
+    {
+        return SkinClusters(Geom, Palette, 0, Geom.m_nClusters, Positions, Normals);
+    }
+}
+
+#endif
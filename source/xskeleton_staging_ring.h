@@ -0,0 +1,91 @@
+#ifndef XSKELETON_STAGING_RING_H
+#define XSKELETON_STAGING_RING_H
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+
+//
+// Persistent host memory where the loader gathers the streams of many geoms before they are
+// submitted to the device together (see the upload batch in xskeleton_xgpu_rsc_loader.cpp).
+// The streams are copied, or decoded, straight into the ring, so a load does not allocate any
+// staging memory of its own.
+//
+// Allocations go one after the other. Once the ring is full the owner submits what it holds,
+// and the device has taken a copy of everything when the submit returns, so the whole ring is
+// free again. The memory is reserved on the first allocation and it only grows when a single
+// allocation is larger than the ring.
+//
+namespace xgeom_static
+{
+    class staging_ring
+    {
+    public:
+
+        inline static constexpr std::size_t alignment_v         = 64;                   // Min for Vulkan buffers
+        inline static constexpr std::size_t default_capacity_v  = 32 * 1024 * 1024;
+
+        explicit staging_ring(std::size_t Capacity = default_capacity_v) noexcept
+            : m_Capacity{ Align(Capacity) }
+        {}
+
+        staging_ring(const staging_ring&)               = delete;
+        staging_ring& operator = (const staging_ring&)  = delete;
+
+        //--------------------------------------------------------------------------------------
+        // Returns Size bytes aligned to alignment_v or an empty span when they do not fit in
+        // what is left, then the owner must submit and Reset before trying again. An empty
+        // ring always has room: it grows to fit.
+        //--------------------------------------------------------------------------------------
+        std::span<std::byte> Allocate(std::size_t Size) noexcept
+        {
+            const auto AlignedSize = Align(Size);
+            if (m_Head + AlignedSize > m_Capacity)
+            {
+                if (m_Head) return {};
+                m_Capacity = std::max(m_Capacity, AlignedSize);
+                m_pMemory.reset();
+            }
+
+            if (m_pMemory == nullptr)
+            {
+                m_pMemory.reset(new (std::align_val_t{ alignment_v }, std::nothrow) std::byte[m_Capacity]);
+                if (m_pMemory == nullptr) return {};
+            }
+
+            std::span<std::byte> Memory{ m_pMemory.get() + m_Head, Size };
+            m_Head += AlignedSize;
+            return Memory;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Everything that was allocated has been submitted
+        //--------------------------------------------------------------------------------------
+        void Reset(void) noexcept
+        {
+            m_Head = 0;
+        }
+
+        const std::byte*    getData     (void) const noexcept { return m_pMemory.get(); }
+        std::size_t         getUsed     (void) const noexcept { return m_Head; }
+        std::size_t         getCapacity (void) const noexcept { return m_Capacity; }
+
+    private:
+
+        struct aligned_delete
+        {
+            void operator()(std::byte* p) const noexcept { ::operator delete[](p, std::align_val_t{ alignment_v }); }
+        };
+
+        static constexpr std::size_t Align(std::size_t X) noexcept { return (X + alignment_v - 1) & ~(alignment_v - 1); }
+
+        std::unique_ptr<std::byte[], aligned_delete>    m_pMemory   = {};
+        std::size_t                                     m_Capacity  = 0;
+        std::size_t                                     m_Head      = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef XSKELETON_VERTEX_CODEC_H
+#define XSKELETON_VERTEX_CODEC_H
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "dependencies/meshoptimizer/src/meshoptimizer.h"
+#include "xskeleton.h"
+#include "xskeleton_parallel.h"
+
+//
+// Compressed vertex streams of a geom (geom::vertex_encoding::MESHOPT). Each stream (positions
+// and extras) is chosen on its own and is cut in chunks of vertices_per_chunk_v vertices that
+// are encoded with meshopt_encodeVertexBuffer, so the chunks can be decoded in parallel. The
+// region of the stream in geom::m_pData then holds:
+//
+//      std::uint32_t   Offsets[nChunks + 1]    - Start of the stream of every chunk, relative
+//                                                to the end of the table (the last one is the size)
+//      std::byte       Streams[]
+//
+// The streams are already quantized (int16 positions, 8 bit octahedral normals and tangents)
+// which is what the meshopt filters would produce, so the codec encodes them as they are.
+//
+namespace xgeom_static::vertex_codec
+{
+    inline static constexpr std::size_t vertices_per_chunk_v = 8192;    // 64KB of 8 byte vertices per job
+
+    //--------------------------------------------------------------------------------------
+
+    inline std::size_t getChunkCount(std::size_t nVertices) noexcept
+    {
+        return (nVertices + vertices_per_chunk_v - 1) / vertices_per_chunk_v;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Encodes a vertex stream. Throws if meshoptimizer fails to encode a chunk.
+    //--------------------------------------------------------------------------------------
+    template< typename T >
+    std::vector<std::byte> Encode(std::span<const T> Vertices)
+    {
+        static_assert(sizeof(T) % 4 == 0 && sizeof(T) <= 256, "meshopt_encodeVertexBuffer only takes vertices of 4 to 256 bytes in steps of 4");
+
+        const auto                              nChunks = getChunkCount(Vertices.size());
+        std::vector<std::vector<unsigned char>> Streams(nChunks);
+        std::atomic<bool>                       bFailed = false;
+        xskeleton::ParallelFor(nChunks, [&](std::size_t iChunk)
+        {
+            const auto  Source  = Vertices.subspan(iChunk * vertices_per_chunk_v, std::min(vertices_per_chunk_v, Vertices.size() - iChunk * vertices_per_chunk_v));
+            auto&       S       = Streams[iChunk];
+
+            // ParallelFor is noexcept, a failed allocation is reported like a failed encode
+            try
+            {
+                S.resize(meshopt_encodeVertexBufferBound(Source.size(), sizeof(T)));
+                S.resize(meshopt_encodeVertexBuffer(S.data(), S.size(), Source.data(), Source.size(), sizeof(T)));
+            }
+            catch (...)
+            {
+                S.clear();
+            }
+            if (S.empty()) bFailed.store(true, std::memory_order_relaxed);
+        });
+
+        if (bFailed) throw(std::runtime_error("Failed to encode a chunk of vertices"));
+
+        const std::size_t   TableSize = (nChunks + 1) * sizeof(std::uint32_t);
+        std::size_t         Total     = 0;
+        for (const auto& S : Streams) Total += S.size();
+
+        std::vector<std::byte> Encoded(TableSize + Total);
+        auto*       pOffsets = reinterpret_cast<std::uint32_t*>(Encoded.data());
+        std::size_t Offset   = 0;
+        for (std::size_t i = 0; i < Streams.size(); ++i)
+        {
+            pOffsets[i] = static_cast<std::uint32_t>(Offset);
+            std::memcpy(Encoded.data() + TableSize + Offset, Streams[i].data(), Streams[i].size());
+            Offset += Streams[i].size();
+        }
+        pOffsets[Streams.size()] = static_cast<std::uint32_t>(Offset);
+
+        return Encoded;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Checks that the offset table fits in Size bytes and that the streams are inside it
+    //--------------------------------------------------------------------------------------
+    inline bool isValid(const std::byte* pEncoded, std::size_t Size, std::size_t nVertices) noexcept
+    {
+        const auto        nChunks   = getChunkCount(nVertices);
+        const std::size_t TableSize = (nChunks + 1) * sizeof(std::uint32_t);
+        if (Size < TableSize) return false;
+
+        const auto* pOffsets = reinterpret_cast<const std::uint32_t*>(pEncoded);
+        for (std::size_t i = 0; i < nChunks; ++i)
+            if (pOffsets[i] > pOffsets[i + 1]) return false;
+
+        return pOffsets[nChunks] <= Size - TableSize;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Decodes a stream of Out.size() vertices that was encoded in Size bytes, the chunks are
+    // decoded in parallel straight into their final place. Returns false if the stream is
+    // corrupted or any chunk fails to decode.
+    //--------------------------------------------------------------------------------------
+    template< typename T >
+    bool Decode(const std::byte* pEncoded, std::size_t Size, std::span<T> Out) noexcept
+    {
+        if (!isValid(pEncoded, Size, Out.size())) return false;
+
+        const auto*         pOffsets  = reinterpret_cast<const std::uint32_t*>(pEncoded);
+        const auto*         pStreams  = reinterpret_cast<const unsigned char*>(pEncoded + (getChunkCount(Out.size()) + 1) * sizeof(std::uint32_t));
+        std::atomic<bool>   bOK       = true;
+
+        xskeleton::ParallelFor(getChunkCount(Out.size()), [&](std::size_t iChunk)
+        {
+            const auto iVertex = iChunk * vertices_per_chunk_v;
+            if (meshopt_decodeVertexBuffer(Out.data() + iVertex, std::min(vertices_per_chunk_v, Out.size() - iVertex), sizeof(T), pStreams + pOffsets[iChunk], pOffsets[iChunk + 1] - pOffsets[iChunk]) != 0)
+                bOK.store(false, std::memory_order_relaxed);
+        });
+
+        return bOK.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Size of the region of a stream in geom::m_pData, the streams are stored in this order:
+    // vertices, extras and indices
+    //--------------------------------------------------------------------------------------
+    inline std::size_t getVertexRegionSize      (const geom& Geom) noexcept { return Geom.m_VertexExtrasOffset - Geom.m_VertexOffset;      }
+    inline std::size_t getVertexExtrasRegionSize(const geom& Geom) noexcept { return Geom.m_IndicesOffset      - Geom.m_VertexExtrasOffset; }
+
+    //--------------------------------------------------------------------------------------
+    // Decode the streams of a geom, they must be in the encoding that the function expects
+    //--------------------------------------------------------------------------------------
+    inline bool DecodeVertices(const geom& Geom, std::span<geom::vertex> Out) noexcept
+    {
+        return Geom.m_VertexOffset <= Geom.m_VertexExtrasOffset && Geom.m_VertexExtrasOffset <= Geom.m_DataSize
+            && Out.size() == Geom.m_nVertices
+            && Decode(reinterpret_cast<const std::byte*>(Geom.m_pData + Geom.m_VertexOffset), getVertexRegionSize(Geom), Out);
+    }
+
+    inline bool DecodeVertexExtras(const geom& Geom, std::span<geom::vertex_extras> Out) noexcept
+    {
+        return Geom.m_VertexExtrasOffset <= Geom.m_IndicesOffset && Geom.m_IndicesOffset <= Geom.m_DataSize
+            && Out.size() == Geom.m_nVertices
+            && Decode(reinterpret_cast<const std::byte*>(Geom.m_pData + Geom.m_VertexExtrasOffset), getVertexExtrasRegionSize(Geom), Out);
+    }
+}
+
+#endif
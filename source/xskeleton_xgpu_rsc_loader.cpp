@@ -1,8 +1,22 @@
-#include "xgeom_static_xgpu_runtime.h"
-#include "xgeom_static_xgpu_rsc_loader.h"
+#if defined(XSKELETON_HEADLESS_DEVICE)
+    #include "xskeleton_headless_device.h"
+#else
+    #include "xgeom_static_xgpu_runtime.h"
+#endif
+#include "xskeleton_xgpu_rsc_loader.h"
+#include "xskeleton_blob.h"
+#include "xskeleton_index_codec.h"
+#include "xskeleton_lod_pager.h"
+#include "xskeleton_vertex_codec.h"
+#include "xskeleton_staging_ring.h"
 
 #include "dependencies/xresource_guid/source/bridges/xresource_xproperty_bridge.h"
 
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <vector>
+
 //
 // We will register the loader, the properties, 
 //
@@ -29,38 +43,276 @@ std::size_t MakeMuultipleOf64(const T& X)
 
 //------------------------------------------------------------------
 
-xresource::loader< xrsc::geom_static_type_guid_v >::data_type* xresource::loader< xrsc::geom_static_type_guid_v >::Load(xresource::mgr& Mgr, const full_guid& GUID)
+static xgeom_static::xgpu::load_stats s_LoadStats;
+
+xgeom_static::xgpu::load_stats& xgeom_static::xgpu::getLoadStats(void) noexcept
 {
-    auto&                   UserData    = Mgr.getUserData<resource_mgr_user_data>();
-    std::wstring            Path        = Mgr.getResourcePath(GUID, type_name_v);
-    xgeom_static::geom*     pGeom       = nullptr;
+    return s_LoadStats;
+}
 
-    // Load the xgeom_static
-    xserializer::stream Stream;
-    if (auto Err = Stream.Load(Path, pGeom); Err)
-    {
-        assert(false);
-    }
+//------------------------------------------------------------------
+
+static xgeom_static::xgpu::load_options s_LoadOptions;
+
+xgeom_static::xgpu::load_options& xgeom_static::xgpu::getLoadOptions(void) noexcept
+{
+    return s_LoadOptions;
+}
+
+//------------------------------------------------------------------
+
+static std::uint64_t ElapsedNS(std::chrono::steady_clock::time_point Start) noexcept
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+}
+
+//------------------------------------------------------------------
+
+// File I/O and decompression, touches neither the device nor the resource manager so it can
+// run on any thread. Returns nullptr on failure.
+
+static xgeom_static::xgpu::geom* LoadFromFile(const std::wstring& Path) noexcept
+{
+    const auto          Start = std::chrono::steady_clock::now();
+    xgeom_static::geom* pGeom = nullptr;
 
     //
-    // Time to copy the memory to the right places
+    // Flat blobs are mapped and used in place, anything else goes through the serializer
     //
+    if (auto pMapping = std::make_unique<xgeom_static::blob::mapped_file>(); pMapping->Open(Path, true) && xgeom_static::blob::isBlob(pMapping->getData()))
+    {
+        pGeom = new xgeom_static::xgpu::geom;
+        if (auto Err = xgeom_static::blob::View(*pGeom, pMapping->getWritableData()); Err)
+        {
+            assert(false);
+            delete static_cast<xgeom_static::xgpu::geom*>(pGeom);
+            s_LoadStats.m_nFailed.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // The geom owns the mapping from now on (see Destroy)
+        pGeom->m_pBlob = pMapping.release();
+    }
+    else
+    {
+        pMapping.reset();
+
+        // Load the xgeom_static
+        xserializer::stream Stream;
+        if (auto Err = Stream.Load(Path, pGeom); Err)
+        {
+            assert(false);
+            s_LoadStats.m_nFailed.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // The tables live in the serializer block
+        pGeom->m_pBlob  = nullptr;
+        pGeom->m_pArena = nullptr;
+    }
+
+    s_LoadStats.m_ReadNS.fetch_add(ElapsedNS(Start), std::memory_order_relaxed);
 
     // Upgrade to the runtime version
-    xgeom_static::xgpu::geom* pXGPUGeom = static_cast<xgeom_static::xgpu::geom*>(pGeom);
+    return static_cast<xgeom_static::xgpu::geom*>(pGeom);
+}
+
+//------------------------------------------------------------------
+// Streams of geoms waiting in the staging ring to be submitted to the device together, only
+// used by the thread that owns the device. The data of the entries points into the ring.
+
+struct xgeom_static::xgpu::upload_batch
+{
+    struct entry
+    {
+        ::xgpu::buffer*             m_pBuffer;
+        ::xgpu::buffer::setup       m_Setup;
+        xgeom_static::xgpu::geom*   m_pGeom;                // Owner of the buffer
+    };
+
+    bool isFailed(const xgeom_static::xgpu::geom* pGeom) const noexcept
+    {
+        return std::ranges::find(m_Failed, pGeom) != m_Failed.end();
+    }
+
+    xgeom_static::staging_ring              m_Ring;
+    std::vector<entry>                      m_Entries;
+    std::vector<xgeom_static::xgpu::geom*>  m_Failed;       // Geoms with a buffer in a failed submit
+};
+
+static xgeom_static::xgpu::upload_batch s_SyncUpload;
+
+//------------------------------------------------------------------
+// Creates the buffers of every entry of the batch and frees the ring. A device that can
+// create many buffers in one call gets a single submission, any other one gets a Create per
+// buffer (still from the ring memory). Returns false when the device fails, then every geom
+// with a buffer in the submit goes to m_Failed (some of its buffers may have been created).
+
+template< typename T_DEVICE >
+static bool SubmitUploads(T_DEVICE& Device, xgeom_static::xgpu::upload_batch& Batch) noexcept
+{
+    if (Batch.m_Entries.empty()) return true;
+
+    const auto                      Start = std::chrono::steady_clock::now();
+    typename T_DEVICE::error*       p     = nullptr;
+
+    if constexpr (requires(std::span<const typename T_DEVICE::create_entry> Entries) { Device.Create(Entries); })
+    {
+        std::vector<typename T_DEVICE::create_entry> Entries;
+        Entries.reserve(Batch.m_Entries.size());
+        for (const auto& E : Batch.m_Entries) Entries.push_back({ E.m_pBuffer, E.m_Setup });
+
+        p = Device.Create(std::span<const typename T_DEVICE::create_entry>(Entries));
+        s_LoadStats.m_nSubmits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        for (const auto& E : Batch.m_Entries)
+        {
+            if ((p = Device.Create(*E.m_pBuffer, E.m_Setup))) break;
+        }
+        s_LoadStats.m_nSubmits.fetch_add(Batch.m_Entries.size(), std::memory_order_relaxed);
+    }
+
+    if (p)
+    {
+        for (const auto& E : Batch.m_Entries)
+            if (Batch.isFailed(E.m_pGeom) == false) Batch.m_Failed.push_back(E.m_pGeom);
+    }
+
+    Batch.m_Entries.clear();
+    Batch.m_Ring.Reset();
+
+    s_LoadStats.m_BuffersNS.fetch_add(ElapsedNS(Start), std::memory_order_relaxed);
+    return p == nullptr;
+}
+
+//------------------------------------------------------------------
+// Reserves the memory of a buffer in the ring (submitting what the ring holds if it is full)
+// and lets Fill copy or decode the stream into it. Returns false when there is no memory for
+// the stream or Fill fails (a failed submit is reported through the batch, see SubmitUploads).
+
+template< typename T, typename T_FILL >
+static bool StageStream(resource_mgr_user_data& UserData, xgeom_static::xgpu::upload_batch& Batch, xgeom_static::xgpu::geom& Geom, xgpu::buffer& Buffer, xgpu::buffer::type Type, std::size_t Count, bool bDecode, T_FILL&& Fill) noexcept
+{
+    auto Memory = Batch.m_Ring.Allocate(Count * sizeof(T));
+    if (Memory.data() == nullptr)
+    {
+        SubmitUploads(UserData.m_Device, Batch);
+        Memory = Batch.m_Ring.Allocate(Count * sizeof(T));
+        if (Memory.data() == nullptr) return false;
+    }
+
+    const auto Start = std::chrono::steady_clock::now();
+    const bool bOK   = Fill(std::span<T>(reinterpret_cast<T*>(Memory.data()), Count));
+    (bDecode ? s_LoadStats.m_DecodeNS : s_LoadStats.m_BuffersNS).fetch_add(ElapsedNS(Start), std::memory_order_relaxed);
+    if (bOK == false) return false;
+
+    Batch.m_Entries.push_back({ &Buffer, xgpu::buffer::setup{.m_Type = Type, .m_EntryByteSize = (int)sizeof(T), .m_EntryCount = (int)Count, .m_pData = Memory.data()}, &Geom });
+    s_LoadStats.m_BufferBytes.fetch_add(Memory.size(), std::memory_order_relaxed);
+    return true;
+}
+
+//------------------------------------------------------------------
+// Copies a raw stream to its buffer memory. When only the coarsest LODs are uploaded (see
+// load_options) just their ranges are copied, the pages of the other LODs are not touched.
+
+template< typename T >
+static void CopyStream(const xgeom_static::geom& Geom, std::span<const T> Source, std::span<T> Out, bool bIndices) noexcept
+{
+    if (s_LoadOptions.m_bUploadAllLODs || xgeom_static::lod_pager::isPageable(Geom) == false)
+    {
+        std::ranges::copy(Source, Out.begin());
+        return;
+    }
+
+    for (const auto& Mesh : Geom.getMeshes())
+    {
+        if (Mesh.m_nLODs == 0) continue;
+
+        const auto& L     = Geom.m_pLOD[Mesh.m_iLOD + Mesh.m_nLODs - 1];
+        const auto  First = bIndices ? L.m_iIndex   : L.m_iVertex;
+        const auto  Count = bIndices ? L.m_nIndices : L.m_nVertices;
+        std::ranges::copy(Source.subspan(First, Count), Out.begin() + First);
+    }
+}
+
+//------------------------------------------------------------------
+// The skin stream gets a buffer only from runtime geoms that have a slot for it (see
+// VertexSkinBuffer in xskeleton_headless_device.h), with any other one skinned geoms keep
+// their skins on the CPU only (see xskeleton_skinning.h). Static geoms never have one.
+
+template< typename T_GEOM >
+static bool StageSkins(resource_mgr_user_data& UserData, xgeom_static::xgpu::upload_batch& Batch, T_GEOM& Geom) noexcept
+{
+    if constexpr (requires { Geom.VertexSkinBuffer(); })
+    {
+        // The skins are never encoded
+        if (Geom.isSkinned() == false) return true;
 
+        return StageStream<xgeom_static::geom::vertex_skin>(UserData, Batch, Geom, Geom.VertexSkinBuffer(), xgpu::buffer::type::VERTEX, Geom.m_nVertices, false, [&](std::span<xgeom_static::geom::vertex_skin> Out)
+        {
+            CopyStream<xgeom_static::geom::vertex_skin>(Geom, Geom.getVertexSkins(), Out, false);
+            return true;
+        });
+    }
+    else
+    {
+        return true;
+    }
+}
+
+//------------------------------------------------------------------
+
+template< typename T_GEOM >
+static void DestroySkins(resource_mgr_user_data& UserData, T_GEOM& Geom) noexcept
+{
+    if constexpr (requires { Geom.VertexSkinBuffer(); })
+    {
+        if (Geom.isSkinned()) UserData.m_Device.Destroy(std::move(Geom.VertexSkinBuffer()));
+    }
+}
+
+//------------------------------------------------------------------
+// Copies the streams of the geom to the staging ring, the encoded ones are decoded straight
+// into it (clusters and vertex chunks in parallel on the workers). Must run on the thread
+// that owns the device. Returns false when a stream can not be staged, the streams that were
+// staged before it stay in the batch.
+
+static bool StageLoad(resource_mgr_user_data& UserData, xgeom_static::xgpu::upload_batch& Batch, xgeom_static::xgpu::geom* pXGPUGeom) noexcept
+{
+    using geom = xgeom_static::geom;
+    auto& Geom = *pXGPUGeom;
+
+    return StageStream<geom::vertex>(UserData, Batch, Geom, Geom.VertexBuffer(), xgpu::buffer::type::VERTEX, Geom.m_nVertices, Geom.m_VertexEncoding != geom::vertex_encoding::RAW, [&](std::span<geom::vertex> Out)
+    {
+        if (Geom.m_VertexEncoding != geom::vertex_encoding::RAW) return xgeom_static::vertex_codec::DecodeVertices(Geom, Out);
+        CopyStream<geom::vertex>(Geom, Geom.getVertices(), Out, false);
+        return true;
+    })
+    && StageStream<geom::vertex_extras>(UserData, Batch, Geom, Geom.VertexExtrasBuffer(), xgpu::buffer::type::VERTEX, Geom.m_nVertices, Geom.m_VertexExtrasEncoding != geom::vertex_encoding::RAW, [&](std::span<geom::vertex_extras> Out)
+    {
+        if (Geom.m_VertexExtrasEncoding != geom::vertex_encoding::RAW) return xgeom_static::vertex_codec::DecodeVertexExtras(Geom, Out);
+        CopyStream<geom::vertex_extras>(Geom, Geom.getVertexExtras(), Out, false);
+        return true;
+    })
+    && StageStream<std::uint16_t>(UserData, Batch, Geom, Geom.IndexBuffer(), xgpu::buffer::type::INDEX, Geom.m_nIndices, Geom.m_IndexEncoding != geom::index_encoding::RAW, [&](std::span<std::uint16_t> Out)
+    {
+        if (Geom.m_IndexEncoding != geom::index_encoding::RAW) return xgeom_static::index_codec::Decode(Geom, Out);
+        CopyStream<std::uint16_t>(Geom, Geom.getIndices(), Out, true);
+        return true;
+    })
+    && StageSkins(UserData, Batch, Geom);
+}
 
-    // Create buffers
-    xgpu::device::error* p;
+//------------------------------------------------------------------
+// Resolves the default material instances, must run on the thread that owns the resource
+// manager.
 
-    0
-    ||(p = UserData.m_Device.Create(pXGPUGeom->VertexBuffer(),       xgpu::buffer::setup{.m_Type = xgpu::buffer::type::VERTEX,  .m_EntryByteSize = (int)sizeof(xgeom_static::geom::vertex),            .m_EntryCount = (int)pXGPUGeom->getVertices().size(),     .m_pData = pXGPUGeom->getVertices().data()}))
-    ||(p = UserData.m_Device.Create(pXGPUGeom->VertexExtrasBuffer(), xgpu::buffer::setup{.m_Type = xgpu::buffer::type::VERTEX,  .m_EntryByteSize = (int)sizeof(xgeom_static::geom::vertex_extras),     .m_EntryCount = (int)pXGPUGeom->getVertexExtras().size(), .m_pData = pXGPUGeom->getVertexExtras().data()}))
-    ||(p = UserData.m_Device.Create(pXGPUGeom->IndexBuffer(),        xgpu::buffer::setup{.m_Type = xgpu::buffer::type::INDEX,   .m_EntryByteSize = (int)sizeof(std::uint16_t),                         .m_EntryCount = (int)pXGPUGeom->getIndices().size(),      .m_pData = pXGPUGeom->getIndices().data()}))
-    ;
-    assert(p == nullptr);
+static void ResolveMaterials(xresource::mgr& Mgr, xgeom_static::xgpu::geom* pXGPUGeom) noexcept
+{
+    const auto Start = std::chrono::steady_clock::now();
 
-    // Resolve the default material instances
     for (auto& E : pXGPUGeom->getDefaultMaterialInstances())
     {
         if (not E.empty())
@@ -76,6 +328,77 @@ xresource::loader< xrsc::geom_static_type_guid_v >::data_type* xresource::loader
         }
     }
 
+    s_LoadStats.m_MaterialsNS.fetch_add(ElapsedNS(Start), std::memory_order_relaxed);
+    s_LoadStats.m_nLoads.fetch_add(1, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------
+
+static void DestroyBuffers(resource_mgr_user_data& UserData, xgeom_static::xgpu::geom& Geom) noexcept
+{
+    UserData.m_Device.Destroy(std::move(Geom.VertexBuffer()));
+    UserData.m_Device.Destroy(std::move(Geom.VertexExtrasBuffer()));
+    UserData.m_Device.Destroy(std::move(Geom.IndexBuffer()));
+    DestroySkins(UserData, Geom);
+}
+
+//------------------------------------------------------------------
+
+static void FreeGeom(xgeom_static::xgpu::geom& Geom) noexcept
+{
+    if (Geom.m_pBlob)
+    {
+        delete static_cast<xgeom_static::blob::mapped_file*>(Geom.m_pBlob);
+        Geom.Initialize();
+        delete &Geom;
+    }
+    else
+    {
+        xserializer::default_memory_handler_v.Free(xserializer::mem_type{ .m_bUnique = true }, &Geom);
+    }
+}
+
+//------------------------------------------------------------------
+// Frees a geom whose buffers could not be created, the buffers that were created are
+// destroyed and its material instances were never resolved.
+
+static void DiscardLoad(resource_mgr_user_data& UserData, xgeom_static::xgpu::geom* pXGPUGeom) noexcept
+{
+    assert(false);
+    DestroyBuffers(UserData, *pXGPUGeom);
+    FreeGeom(*pXGPUGeom);
+    s_LoadStats.m_nFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------
+// Creates the GPU buffers and resolves the default material instances of a single geom, must
+// run on the thread that owns the device and the resource manager. Returns false (and frees
+// the geom) when the buffers can not be created.
+
+static bool FinishLoad(xresource::mgr& Mgr, xgeom_static::xgpu::geom* pXGPUGeom) noexcept
+{
+    auto& UserData = Mgr.getUserData<resource_mgr_user_data>();
+
+    s_SyncUpload.m_Failed.clear();
+    const bool bStaged = StageLoad(UserData, s_SyncUpload, pXGPUGeom);
+    if (SubmitUploads(UserData.m_Device, s_SyncUpload) == false || bStaged == false)
+    {
+        DiscardLoad(UserData, pXGPUGeom);
+        return false;
+    }
+
+    ResolveMaterials(Mgr, pXGPUGeom);
+    return true;
+}
+
+//------------------------------------------------------------------
+
+xresource::loader< xrsc::geom_static_type_guid_v >::data_type* xresource::loader< xrsc::geom_static_type_guid_v >::Load(xresource::mgr& Mgr, const full_guid& GUID)
+{
+    auto pXGPUGeom = LoadFromFile(Mgr.getResourcePath(GUID, type_name_v));
+    if (pXGPUGeom == nullptr) return nullptr;
+
+    if (FinishLoad(Mgr, pXGPUGeom) == false) return nullptr;
     return pXGPUGeom;
 }
 
@@ -86,9 +409,7 @@ void xresource::loader< xrsc::geom_static_type_guid_v >::Destroy(xresource::mgr&
     auto& UserData = Mgr.getUserData<resource_mgr_user_data>();
 
     // Release all the buffers
-    UserData.m_Device.Destroy(std::move(Data.VertexBuffer()));
-    UserData.m_Device.Destroy(std::move(Data.VertexExtrasBuffer()));
-    UserData.m_Device.Destroy(std::move(Data.IndexBuffer()));
+    DestroyBuffers(UserData, Data);
 
     // Release all the material instance references
     for (auto& E : Data.getDefaultMaterialInstances())
@@ -97,5 +418,154 @@ void xresource::loader< xrsc::geom_static_type_guid_v >::Destroy(xresource::mgr&
     }
 
     // Free the resource
-    xserializer::default_memory_handler_v.Free(xserializer::mem_type{ .m_bUnique = true }, &Data);
+    FreeGeom(Data);
+}
+
+//------------------------------------------------------------------
+// async_loader
+//------------------------------------------------------------------
+
+xgeom_static::xgpu::async_loader::async_loader(xresource::mgr& Mgr) noexcept
+    : m_Mgr     { Mgr }
+    , m_Workers { xscheduler::str_v<"xgeom_static::xgpu::async_loader">, xscheduler::lifetime::DONT_DELETE_WHEN_DONE, xscheduler::triggers::CLEAN_COUNT }
+    , m_pUpload { std::make_unique<upload_batch>() }
+{
+}
+
+//------------------------------------------------------------------
+
+xgeom_static::xgpu::async_loader::~async_loader(void) noexcept
+{
+    Flush();
+
+    for (auto& [Key, Entry] : m_Entries)
+    {
+        if (Entry.m_pGeom) xresource::loader< xrsc::geom_static_type_guid_v >::Destroy(m_Mgr, std::move(*Entry.m_pGeom), Entry.m_GUID);
+    }
+}
+
+//------------------------------------------------------------------
+
+void xgeom_static::xgpu::async_loader::Request(const xresource::full_guid& GUID, callback&& Callback) noexcept
+{
+    using loader = xresource::loader< xrsc::geom_static_type_guid_v >;
+
+    m_nPending.fetch_add(1, std::memory_order_relaxed);
+
+    // A GUID that is loading or loaded only waits for the geom
+    auto [It, bNew] = m_Entries.try_emplace(GUID.m_Instance.m_Value);
+    auto& Entry     = It->second;
+    Entry.m_Callbacks.push_back(std::move(Callback));
+    if (bNew == false)
+    {
+        if (Entry.m_bLoading == false && Entry.m_Callbacks.size() == 1) m_Loaded.push_back(It->first);
+        return;
+    }
+    Entry.m_GUID = GUID;
+
+    auto pRequest = std::make_unique<request>();
+    pRequest->m_Path        = m_Mgr.getResourcePath(GUID, loader::type_name_v);
+    pRequest->m_GUID        = GUID;
+
+    m_Workers.Submit([this, pRequest = pRequest.release()]
+    {
+        pRequest->m_pGeom = LoadFromFile(pRequest->m_Path);
+
+        std::scoped_lock Lock(m_ReadyMutex);
+        m_Ready.emplace_back(pRequest);
+    });
+}
+
+//------------------------------------------------------------------
+
+void xgeom_static::xgpu::async_loader::Release(const xresource::full_guid& GUID) noexcept
+{
+    const auto It = m_Entries.find(GUID.m_Instance.m_Value);
+    assert(It != m_Entries.end() && It->second.m_RefCount > 0);
+    if (It == m_Entries.end() || --It->second.m_RefCount || It->second.m_Callbacks.size()) return;
+
+    xresource::loader< xrsc::geom_static_type_guid_v >::Destroy(m_Mgr, std::move(*It->second.m_pGeom), GUID);
+    m_Entries.erase(It);
+}
+
+//------------------------------------------------------------------
+// Calls the callbacks waiting for a finished entry, each one that gets the geom takes a
+// reference. A failed entry is forgotten so a later request tries again.
+
+std::size_t xgeom_static::xgpu::async_loader::Deliver(std::uint64_t Key) noexcept
+{
+    const auto It = m_Entries.find(Key);
+    if (It == m_Entries.end()) return 0;
+
+    // The callbacks may request or release geoms, nothing of the entry is used after them
+    auto        Callbacks = std::move(It->second.m_Callbacks);
+    const auto  pGeom     = It->second.m_pGeom;
+    It->second.m_Callbacks.clear();
+
+    if (pGeom) It->second.m_RefCount += Callbacks.size();
+    else       m_Entries.erase(It);
+
+    for (auto& Callback : Callbacks)
+    {
+        m_nPending.fetch_sub(1, std::memory_order_relaxed);
+        Callback(pGeom);
+    }
+
+    return Callbacks.size();
+}
+
+//------------------------------------------------------------------
+
+std::size_t xgeom_static::xgpu::async_loader::Update(void) noexcept
+{
+    std::vector<std::unique_ptr<request>> Ready;
+    {
+        std::scoped_lock Lock(m_ReadyMutex);
+        Ready.swap(m_Ready);
+    }
+
+    // Everything that the workers finished since the last update is finished in one go: the
+    // streams of all the geoms are staged and submitted together. A geom that could not be
+    // staged, or had a buffer in a failed submit, is discarded once everything was submitted
+    // and its callbacks get nullptr.
+    auto& UserData = m_Mgr.getUserData<resource_mgr_user_data>();
+    m_pUpload->m_Failed.clear();
+    for (auto& pRequest : Ready)
+    {
+        if (pRequest->m_pGeom && StageLoad(UserData, *m_pUpload, pRequest->m_pGeom) == false)
+            m_pUpload->m_Failed.push_back(pRequest->m_pGeom);
+    }
+    SubmitUploads(UserData.m_Device, *m_pUpload);
+
+    for (auto& pRequest : Ready)
+    {
+        if (pRequest->m_pGeom && m_pUpload->isFailed(pRequest->m_pGeom))
+        {
+            DiscardLoad(UserData, pRequest->m_pGeom);
+            pRequest->m_pGeom = nullptr;
+        }
+
+        if (pRequest->m_pGeom) ResolveMaterials(m_Mgr, pRequest->m_pGeom);
+
+        auto& Entry = m_Entries[pRequest->m_GUID.m_Instance.m_Value];
+        Entry.m_pGeom    = pRequest->m_pGeom;
+        Entry.m_bLoading = false;
+    }
+
+    std::vector<std::uint64_t> Loaded;
+    Loaded.swap(m_Loaded);
+
+    std::size_t nCalls = 0;
+    for (auto& pRequest : Ready) nCalls += Deliver(pRequest->m_GUID.m_Instance.m_Value);
+    for (const auto Key : Loaded)  nCalls += Deliver(Key);
+
+    return nCalls;
+}
+
+//------------------------------------------------------------------
+
+void xgeom_static::xgpu::async_loader::Flush(void) noexcept
+{
+    m_Workers.join();
+    Update();
 }
@@ -4,6 +4,15 @@
 
 // This header file is used to provide a resource_guid for textures
 #include "dependencies/xresource_mgr/source/xresource_mgr.h"
+#include "dependencies/xscheduler/source/xscheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 // All the information about the resource
 namespace xrsc
@@ -16,6 +25,111 @@ namespace xrsc
 namespace xgeom_static::xgpu
 {
     struct geom;
+    struct upload_batch;
+
+    //------------------------------------------------------------------
+    // Accumulated cost of every geom load of the process split by phase: Read is the file
+    // mapping or decompression, Decode the decoding of encoded streams, Buffers the copy of the
+    // streams to the staging ring plus the submits that create the GPU buffers and Materials
+    // the resolve of the default material instances. BufferBytes is what went to the device
+    // in nSubmits submissions.
+    //------------------------------------------------------------------
+    struct load_stats
+    {
+        std::atomic<std::uint64_t>  m_nLoads        = 0;
+        std::atomic<std::uint64_t>  m_nFailed       = 0;
+        std::atomic<std::uint64_t>  m_ReadNS        = 0;
+        std::atomic<std::uint64_t>  m_DecodeNS      = 0;
+        std::atomic<std::uint64_t>  m_BuffersNS     = 0;
+        std::atomic<std::uint64_t>  m_MaterialsNS   = 0;
+        std::atomic<std::uint64_t>  m_BufferBytes   = 0;
+        std::atomic<std::uint64_t>  m_nSubmits      = 0;
+
+        void Reset(void) noexcept
+        {
+            for (auto* p : { &m_nLoads, &m_nFailed, &m_ReadNS, &m_DecodeNS, &m_BuffersNS, &m_MaterialsNS, &m_BufferBytes, &m_nSubmits })
+                p->store(0, std::memory_order_relaxed);
+        }
+    };
+
+    load_stats& getLoadStats(void) noexcept;
+
+    //------------------------------------------------------------------
+    // How the loader fills the GPU buffers. With m_bUploadAllLODs off, geoms that the lod_pager
+    // can page only get the data of the coarsest LOD of every mesh: the buffers keep their full
+    // size so the cluster offsets stay valid, the ranges of the other LODs are undefined until
+    // the renderer uploads their lod_pager::getPage, and their file pages are never touched.
+    // Initialize the pager with the same value.
+    //------------------------------------------------------------------
+    struct load_options
+    {
+        bool                        m_bUploadAllLODs = true;
+    };
+
+    load_options& getLoadOptions(void) noexcept;
+
+    //------------------------------------------------------------------
+    // Loads geoms without stalling the caller. The file read, the mapping and the decompression
+    // run on the xscheduler workers; Update (called by the thread that owns the device and the
+    // resource manager, usually once per frame) creates the GPU buffers, resolves the default
+    // materials of everything that finished and calls the callbacks. The buffers of all the geoms
+    // that an Update finishes go through the staging ring of the loader and are submitted
+    // together (more than once only when they do not fit in the ring).
+    //
+    // Requests of the same GUID share one geom: a request while it loads waits for that load and
+    // a request after it finished gets the geom from the next Update. Every callback that
+    // receives a geom holds a reference to it, give it back with Release (the last one destroys
+    // the geom). The callback receives nullptr if the load failed, which holds no reference.
+    // Request, Update and Release must be called from the thread that owns the device.
+    //
+    // The geoms are not registered in the resource manager, the loader keeps the references of
+    // its own geoms (a Mgr.getResource of the same GUID loads a separate copy). The geoms still
+    // referenced when the loader is destroyed are destroyed with it.
+    //------------------------------------------------------------------
+    class async_loader
+    {
+    public:
+
+        using callback = std::function<void(geom*)>;
+
+                        async_loader    (xresource::mgr& Mgr)                                   noexcept;
+                       ~async_loader    (void)                                                  noexcept;
+        void            Request         (const xresource::full_guid& GUID, callback&& Callback) noexcept;
+        void            Release         (const xresource::full_guid& GUID)                      noexcept;
+        std::size_t     Update          (void)                                                  noexcept;
+        void            Flush           (void)                                                  noexcept;
+        std::size_t     getPendingCount (void) const                                            noexcept { return m_nPending.load(std::memory_order_relaxed); }
+
+    private:
+
+        struct request
+        {
+            std::wstring                m_Path;
+            xresource::full_guid        m_GUID;
+            geom*                       m_pGeom     = nullptr;
+        };
+
+        // One per GUID from its first request until its last reference is released
+        struct entry
+        {
+            xresource::full_guid        m_GUID;
+            geom*                       m_pGeom     = nullptr;
+            std::size_t                 m_RefCount  = 0;
+            bool                        m_bLoading  = true;
+            std::vector<callback>       m_Callbacks;                // Waiting for the geom
+        };
+
+        std::size_t     Deliver         (std::uint64_t Key)                                     noexcept;
+
+        xresource::mgr&                             m_Mgr;
+        xscheduler::task_group                      m_Workers;
+        std::mutex                                  m_ReadyMutex;
+        std::vector<std::unique_ptr<request>>       m_Ready;
+        std::unordered_map<std::uint64_t, entry>    m_Entries;      // By instance GUID, only touched by the owner thread
+        std::vector<std::uint64_t>                  m_Loaded;       // Requested while already loaded, for the next Update
+        std::unique_ptr<upload_batch>               m_pUpload;
+        std::atomic<std::size_t>                m_nPending  = 0;
+    };
 }
 
 // Now we specify the loader and we must fill in all the information